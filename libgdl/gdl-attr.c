@@ -24,10 +24,11 @@
 #include <libiberty.h>
 
 #include "gdl.h"
+#include "gdl-budget.h"
 
 /* Functions to get the attributes.  */
 
-char *
+gdl_color
 gdl_get_node_bordercolor (gdl_node *node)
 {
   return node->bordercolor;
@@ -39,12 +40,18 @@ gdl_get_node_borderwidth (gdl_node *node)
   return node->borderwidth;
 }
 
-char *
+gdl_color
 gdl_get_node_color (gdl_node *node)
 {
   return node->color;
 }
 
+int
+gdl_get_node_horizontal_order (gdl_node *node)
+{
+  return node->horizontal_order;
+}
+
 char *
 gdl_get_node_label (gdl_node *node)
 {
@@ -69,7 +76,7 @@ gdl_get_edge_label (gdl_edge *edge)
   return edge->label;
 }
 
-char *
+gdl_linestyle
 gdl_get_edge_linestyle (gdl_edge *edge)
 {
   return edge->linestyle;
@@ -93,7 +100,7 @@ gdl_get_edge_thickness (gdl_edge *edge)
   return edge->thickness;
 }
 
-char *
+gdl_color
 gdl_get_graph_color (gdl_graph *graph)
 {
   return graph->color;
@@ -105,6 +112,12 @@ gdl_get_graph_folding (gdl_graph *graph)
   return graph->folding;
 }
 
+int
+gdl_get_graph_horizontal_order (gdl_graph *graph)
+{
+  return graph->horizontal_order;
+}
+
 char *
 gdl_get_graph_label (gdl_graph *graph)
 {
@@ -135,7 +148,7 @@ gdl_get_graph_port_sharing (gdl_graph *graph)
   return graph->port_sharing;
 }
 
-char *
+gdl_shape
 gdl_get_graph_shape (gdl_graph *graph)
 {
   return graph->shape;
@@ -177,19 +190,19 @@ gdl_get_graph_node_borderwidth (gdl_graph *graph)
   return graph->node_borderwidth;
 }
 
-char *
+gdl_color
 gdl_get_graph_node_color (gdl_graph *graph)
 {
   return graph->node_color;
 }
 
-char *
+gdl_shape
 gdl_get_graph_node_shape (gdl_graph *graph)
 {
   return graph->node_shape;
 }
 
-char *
+gdl_color
 gdl_get_graph_edge_color (gdl_graph *graph)
 {
   return graph->edge_color;
@@ -204,7 +217,7 @@ gdl_get_graph_edge_thickness (gdl_graph *graph)
 /* Functions to set the attributes.  */
 
 void
-gdl_set_node_bordercolor (gdl_node *node, char *value)
+gdl_set_node_bordercolor (gdl_node *node, gdl_color value)
 {
   node->set_p[GDL_NODE_ATTR_bordercolor] = 1;
   node->bordercolor = value;
@@ -218,7 +231,7 @@ gdl_set_node_borderwidth (gdl_node *node, int value)
 }
 
 void
-gdl_set_node_color (gdl_node *node, char *value)
+gdl_set_node_color (gdl_node *node, gdl_color value)
 {
   node->set_p[GDL_NODE_ATTR_color] = 1;
   node->color = value;
@@ -234,6 +247,10 @@ gdl_set_node_horizontal_order (gdl_node *node, int value)
 void
 gdl_set_node_label (gdl_node *node, char *value)
 {
+  gdl_budget *budget = find_budget (node->parent);
+
+  if (budget != NULL && !gdl_budget_label_p (budget, value))
+    return;
   node->set_p[GDL_NODE_ATTR_label] = 1;
   node->label = value;
 }
@@ -255,12 +272,16 @@ gdl_set_node_vertical_order (gdl_node *node, int value)
 void
 gdl_set_edge_label (gdl_edge *edge, char *value)
 {
+  gdl_budget *budget = find_budget (edge->parent);
+
+  if (budget != NULL && !gdl_budget_label_p (budget, value))
+    return;
   edge->set_p[GDL_EDGE_ATTR_label] = 1;
   edge->label = value;
 }
 
 void
-gdl_set_edge_linestyle (gdl_edge *edge, char *value)
+gdl_set_edge_linestyle (gdl_edge *edge, gdl_linestyle value)
 {
   edge->set_p[GDL_EDGE_ATTR_linestyle] = 1;
   edge->linestyle = value;
@@ -288,7 +309,7 @@ gdl_set_edge_thickness (gdl_edge *edge, int value)
 }
 
 void
-gdl_set_graph_color (gdl_graph *graph, char *value)
+gdl_set_graph_color (gdl_graph *graph, gdl_color value)
 {
   graph->set_p[GDL_GRAPH_ATTR_color] = 1;
   graph->color = value;
@@ -313,6 +334,13 @@ gdl_set_graph_folding (gdl_graph *graph, int value)
   graph->folding = value;
 }
 
+void
+gdl_set_graph_horizontal_order (gdl_graph *graph, int value)
+{
+  graph->set_p[GDL_GRAPH_ATTR_horizontal_order] = 1;
+  graph->horizontal_order = value;
+}
+
 void
 gdl_set_graph_label (gdl_graph *graph, char *value)
 {
@@ -356,7 +384,7 @@ gdl_set_graph_port_sharing (gdl_graph *graph, char *value)
 }
 
 void
-gdl_set_graph_shape (gdl_graph *graph, char *value)
+gdl_set_graph_shape (gdl_graph *graph, gdl_shape value)
 {
   graph->set_p[GDL_GRAPH_ATTR_shape] = 1;
   graph->shape = value;
@@ -405,28 +433,28 @@ gdl_set_graph_node_borderwidth (gdl_graph *graph, int value)
 }
 
 void
-gdl_set_graph_node_color (gdl_graph *graph, char *value)
+gdl_set_graph_node_color (gdl_graph *graph, gdl_color value)
 {
   graph->set_p[GDL_GRAPH_ATTR_node_color] = 1;
   graph->node_color = value;
 }
 
 void
-gdl_set_graph_node_shape (gdl_graph *graph, char *value)
+gdl_set_graph_node_shape (gdl_graph *graph, gdl_shape value)
 {
   graph->set_p[GDL_GRAPH_ATTR_node_shape] = 1;
   graph->node_shape = value;
 }
 
 void
-gdl_set_graph_node_textcolor (gdl_graph *graph, char *value)
+gdl_set_graph_node_textcolor (gdl_graph *graph, gdl_color value)
 {
   graph->set_p[GDL_GRAPH_ATTR_node_textcolor] = 1;
   graph->node_textcolor = value;
 }
 
 void
-gdl_set_graph_edge_color (gdl_graph *graph, char *value)
+gdl_set_graph_edge_color (gdl_graph *graph, gdl_color value)
 {
   graph->set_p[GDL_GRAPH_ATTR_edge_color] = 1;
   graph->edge_color = value;
@@ -483,3 +511,387 @@ gdl_set_edge_type (gdl_edge *edge, gdl_edge_type type)
   edge->type = type;
 }
 
+/* Functions to access the styles.  */
+
+gdl_style *
+gdl_get_node_style (gdl_node *node)
+{
+  return node->style;
+}
+
+gdl_style *
+gdl_get_edge_style (gdl_edge *edge)
+{
+  return edge->style;
+}
+
+gdl_style *
+gdl_get_graph_style (gdl_graph *graph)
+{
+  return graph->style;
+}
+
+char *
+gdl_get_style_name (gdl_style *style)
+{
+  return style->name;
+}
+
+void
+gdl_set_node_style (gdl_node *node, gdl_style *style)
+{
+  node->style = style;
+}
+
+void
+gdl_set_edge_style (gdl_edge *edge, gdl_style *style)
+{
+  edge->style = style;
+}
+
+void
+gdl_set_graph_style (gdl_graph *graph, gdl_style *style)
+{
+  graph->style = style;
+}
+
+void
+gdl_set_style_bordercolor (gdl_style *style, gdl_color value)
+{
+  style->set_p[GDL_STYLE_ATTR_bordercolor] = 1;
+  style->bordercolor = value;
+}
+
+void
+gdl_set_style_borderwidth (gdl_style *style, int value)
+{
+  style->set_p[GDL_STYLE_ATTR_borderwidth] = 1;
+  style->borderwidth = value;
+}
+
+void
+gdl_set_style_color (gdl_style *style, gdl_color value)
+{
+  style->set_p[GDL_STYLE_ATTR_color] = 1;
+  style->color = value;
+}
+
+void
+gdl_set_style_folding (gdl_style *style, int value)
+{
+  style->set_p[GDL_STYLE_ATTR_folding] = 1;
+  style->folding = value;
+}
+
+void
+gdl_set_style_linestyle (gdl_style *style, gdl_linestyle value)
+{
+  style->set_p[GDL_STYLE_ATTR_linestyle] = 1;
+  style->linestyle = value;
+}
+
+void
+gdl_set_style_shape (gdl_style *style, gdl_shape value)
+{
+  style->set_p[GDL_STYLE_ATTR_shape] = 1;
+  style->shape = value;
+}
+
+void
+gdl_set_style_thickness (gdl_style *style, int value)
+{
+  style->set_p[GDL_STYLE_ATTR_thickness] = 1;
+  style->thickness = value;
+}
+
+/* Names of the shapes, colors and line styles.  */
+
+#define SPAN(STR) { STR, sizeof (STR) - 1 }
+
+static const gdl_span shape_spans[GDL_SHAPE_MAX] =
+{
+  SPAN ("box"),
+  SPAN ("rhomb"),
+  SPAN ("ellipse"),
+  SPAN ("triangle")
+};
+
+/* The color entries are referred to by their numbers.  */
+
+static const gdl_span color_spans[GDL_COLOR_MAX] =
+{
+  SPAN ("white"),
+  SPAN ("blue"),
+  SPAN ("red"),
+  SPAN ("green"),
+  SPAN ("yellow"),
+  SPAN ("magenta"),
+  SPAN ("cyan"),
+  SPAN ("darkgrey"),
+  SPAN ("darkblue"),
+  SPAN ("darkred"),
+  SPAN ("darkgreen"),
+  SPAN ("darkyellow"),
+  SPAN ("darkmagenta"),
+  SPAN ("darkcyan"),
+  SPAN ("gold"),
+  SPAN ("lightgrey"),
+  SPAN ("lightblue"),
+  SPAN ("lightred"),
+  SPAN ("lightgreen"),
+  SPAN ("lightyellow"),
+  SPAN ("lightmagenta"),
+  SPAN ("lightcyan"),
+  SPAN ("lilac"),
+  SPAN ("turquoise"),
+  SPAN ("aquamarine"),
+  SPAN ("khaki"),
+  SPAN ("purple"),
+  SPAN ("yellowgreen"),
+  SPAN ("pink"),
+  SPAN ("orange"),
+  SPAN ("orchid"),
+  SPAN ("black"),
+  SPAN ("32"), SPAN ("33"), SPAN ("34"), SPAN ("35"), SPAN ("36"),
+  SPAN ("37"), SPAN ("38"), SPAN ("39"), SPAN ("40"), SPAN ("41"),
+  SPAN ("42"), SPAN ("43"), SPAN ("44"), SPAN ("45"), SPAN ("46"),
+  SPAN ("47"), SPAN ("48"), SPAN ("49"), SPAN ("50"), SPAN ("51"),
+  SPAN ("52"), SPAN ("53"), SPAN ("54"), SPAN ("55"), SPAN ("56"),
+  SPAN ("57"), SPAN ("58"), SPAN ("59"), SPAN ("60"), SPAN ("61"),
+  SPAN ("62"), SPAN ("63"), SPAN ("64"), SPAN ("65"), SPAN ("66"),
+  SPAN ("67"), SPAN ("68"), SPAN ("69"), SPAN ("70"), SPAN ("71"),
+  SPAN ("72"), SPAN ("73"), SPAN ("74"), SPAN ("75"), SPAN ("76"),
+  SPAN ("77"), SPAN ("78"), SPAN ("79"), SPAN ("80"), SPAN ("81"),
+  SPAN ("82"), SPAN ("83"), SPAN ("84"), SPAN ("85"), SPAN ("86"),
+  SPAN ("87"), SPAN ("88"), SPAN ("89"), SPAN ("90"), SPAN ("91"),
+  SPAN ("92"), SPAN ("93"), SPAN ("94"), SPAN ("95"), SPAN ("96"),
+  SPAN ("97"), SPAN ("98"), SPAN ("99"), SPAN ("100"), SPAN ("101"),
+  SPAN ("102"), SPAN ("103"), SPAN ("104"), SPAN ("105"), SPAN ("106"),
+  SPAN ("107"), SPAN ("108"), SPAN ("109"), SPAN ("110"), SPAN ("111"),
+  SPAN ("112"), SPAN ("113"), SPAN ("114"), SPAN ("115"), SPAN ("116"),
+  SPAN ("117"), SPAN ("118"), SPAN ("119"), SPAN ("120"), SPAN ("121"),
+  SPAN ("122"), SPAN ("123"), SPAN ("124"), SPAN ("125"), SPAN ("126"),
+  SPAN ("127"), SPAN ("128"), SPAN ("129"), SPAN ("130"), SPAN ("131"),
+  SPAN ("132"), SPAN ("133"), SPAN ("134"), SPAN ("135"), SPAN ("136"),
+  SPAN ("137"), SPAN ("138"), SPAN ("139"), SPAN ("140"), SPAN ("141"),
+  SPAN ("142"), SPAN ("143"), SPAN ("144"), SPAN ("145"), SPAN ("146"),
+  SPAN ("147"), SPAN ("148"), SPAN ("149"), SPAN ("150"), SPAN ("151"),
+  SPAN ("152"), SPAN ("153"), SPAN ("154"), SPAN ("155"), SPAN ("156"),
+  SPAN ("157"), SPAN ("158"), SPAN ("159"), SPAN ("160"), SPAN ("161"),
+  SPAN ("162"), SPAN ("163"), SPAN ("164"), SPAN ("165"), SPAN ("166"),
+  SPAN ("167"), SPAN ("168"), SPAN ("169"), SPAN ("170"), SPAN ("171"),
+  SPAN ("172"), SPAN ("173"), SPAN ("174"), SPAN ("175"), SPAN ("176"),
+  SPAN ("177"), SPAN ("178"), SPAN ("179"), SPAN ("180"), SPAN ("181"),
+  SPAN ("182"), SPAN ("183"), SPAN ("184"), SPAN ("185"), SPAN ("186"),
+  SPAN ("187"), SPAN ("188"), SPAN ("189"), SPAN ("190"), SPAN ("191"),
+  SPAN ("192"), SPAN ("193"), SPAN ("194"), SPAN ("195"), SPAN ("196"),
+  SPAN ("197"), SPAN ("198"), SPAN ("199"), SPAN ("200"), SPAN ("201"),
+  SPAN ("202"), SPAN ("203"), SPAN ("204"), SPAN ("205"), SPAN ("206"),
+  SPAN ("207"), SPAN ("208"), SPAN ("209"), SPAN ("210"), SPAN ("211"),
+  SPAN ("212"), SPAN ("213"), SPAN ("214"), SPAN ("215"), SPAN ("216"),
+  SPAN ("217"), SPAN ("218"), SPAN ("219"), SPAN ("220"), SPAN ("221"),
+  SPAN ("222"), SPAN ("223"), SPAN ("224"), SPAN ("225"), SPAN ("226"),
+  SPAN ("227"), SPAN ("228"), SPAN ("229"), SPAN ("230"), SPAN ("231"),
+  SPAN ("232"), SPAN ("233"), SPAN ("234"), SPAN ("235"), SPAN ("236"),
+  SPAN ("237"), SPAN ("238"), SPAN ("239"), SPAN ("240"), SPAN ("241"),
+  SPAN ("242"), SPAN ("243"), SPAN ("244"), SPAN ("245"), SPAN ("246"),
+  SPAN ("247"), SPAN ("248"), SPAN ("249"), SPAN ("250"), SPAN ("251"),
+  SPAN ("252"), SPAN ("253"), SPAN ("254"), SPAN ("255")
+};
+
+static const gdl_span linestyle_spans[GDL_LINESTYLE_MAX] =
+{
+  SPAN ("continuous"),
+  SPAN ("dashed"),
+  SPAN ("dotted"),
+  SPAN ("invisible")
+};
+
+/* The keywords of the edge types.  */
+
+static const gdl_span edge_type_spans[] =
+{
+  SPAN ("edge"),
+  SPAN ("backedge"),
+  SPAN ("nearedge"),
+  SPAN ("leftnearedge"),
+  SPAN ("rightnearedge"),
+  SPAN ("bentnearedge"),
+  SPAN ("leftbentnearedge"),
+  SPAN ("rightbentnearedge")
+};
+
+#define EDGE_TYPE_NUM (sizeof (edge_type_spans) / sizeof (edge_type_spans[0]))
+
+#undef SPAN
+
+/* The arbitrary names, which are shared by the shapes, colors and line
+   styles.  They are never freed.  */
+static gdl_span *custom_spans;
+static int custom_num;
+static int custom_size;
+
+/* Return the index of NAME in the arbitrary names, adding it if it is
+   not there yet.  */
+
+static int
+find_custom (char *name)
+{
+  int i;
+
+  for (i = 0; i < custom_num; i++)
+    if (!strcmp (custom_spans[i].str, name))
+      return i;
+
+  if (custom_num == custom_size)
+    {
+      custom_size = custom_size ? custom_size * 2 : 8;
+      custom_spans = XRESIZEVEC (gdl_span, custom_spans, custom_size);
+    }
+  custom_spans[custom_num].str = xstrdup (name);
+  custom_spans[custom_num].len = strlen (name);
+
+  return custom_num++;
+}
+
+/* Return the index of NAME in the table SPANS with NUM entries, or -1 if
+   it is not found.  */
+
+static int
+find_span (const gdl_span *spans, int num, char *name)
+{
+  int i;
+
+  for (i = 0; i < num; i++)
+    if (!strcmp (spans[i].str, name))
+      return i;
+
+  return -1;
+}
+
+/* Functions to convert a name into a shape, color or line style.  An
+   unknown name is kept as it is and gets a value past the predefined
+   ones.  */
+
+gdl_shape
+gdl_shape_from_name (char *name)
+{
+  int i;
+
+  i = find_span (shape_spans, GDL_SHAPE_MAX, name);
+  if (i < 0)
+    i = GDL_SHAPE_MAX + find_custom (name);
+
+  return (gdl_shape) i;
+}
+
+gdl_color
+gdl_color_from_name (char *name)
+{
+  int i;
+
+  i = find_span (color_spans, GDL_COLOR_MAX, name);
+  if (i < 0)
+    i = GDL_COLOR_MAX + find_custom (name);
+
+  return (gdl_color) i;
+}
+
+gdl_linestyle
+gdl_linestyle_from_name (char *name)
+{
+  int i;
+
+  i = find_span (linestyle_spans, GDL_LINESTYLE_MAX, name);
+  if (i < 0)
+    i = GDL_LINESTYLE_MAX + find_custom (name);
+
+  return (gdl_linestyle) i;
+}
+
+/* Functions to get the name of a shape, color or line style.  */
+
+const gdl_span *
+gdl_shape_span (gdl_shape shape)
+{
+  if (shape < GDL_SHAPE_MAX)
+    return &shape_spans[shape];
+
+  assert (shape - GDL_SHAPE_MAX < custom_num);
+  return &custom_spans[shape - GDL_SHAPE_MAX];
+}
+
+const gdl_span *
+gdl_color_span (gdl_color color)
+{
+  if (color < GDL_COLOR_MAX)
+    return &color_spans[color];
+
+  assert (color - GDL_COLOR_MAX < custom_num);
+  return &custom_spans[color - GDL_COLOR_MAX];
+}
+
+const gdl_span *
+gdl_linestyle_span (gdl_linestyle linestyle)
+{
+  if (linestyle < GDL_LINESTYLE_MAX)
+    return &linestyle_spans[linestyle];
+
+  assert (linestyle - GDL_LINESTYLE_MAX < custom_num);
+  return &custom_spans[linestyle - GDL_LINESTYLE_MAX];
+}
+
+/* The default color map of VCG.  */
+
+static const unsigned char color_map[32][3] =
+{
+  {255, 255, 255}, {0, 0, 255}, {255, 0, 0}, {0, 255, 0},
+  {255, 255, 0}, {255, 0, 255}, {0, 255, 255}, {85, 85, 85},
+  {0, 0, 128}, {128, 0, 0}, {0, 128, 0}, {128, 128, 0},
+  {128, 0, 128}, {0, 128, 128}, {255, 215, 0}, {170, 170, 170},
+  {128, 128, 255}, {255, 128, 128}, {128, 255, 128}, {255, 255, 128},
+  {255, 128, 255}, {128, 255, 255}, {238, 130, 238}, {64, 224, 208},
+  {127, 255, 212}, {240, 230, 140}, {160, 32, 240}, {154, 205, 50},
+  {255, 192, 203}, {255, 165, 0}, {218, 112, 214}, {0, 0, 0}
+};
+
+/* Store the red, green and blue of COLOR in the graph GRAPH into RGB,
+   after the color entries of its top graph or else the default color
+   map.  Return 0 if COLOR has no known value, e.g. an arbitrary name.  */
+
+int
+gdl_get_color_rgb (gdl_graph *graph, gdl_color color, int rgb[3])
+{
+  int i;
+
+  while (graph != NULL && graph->parent != NULL)
+    graph = graph->parent;
+
+  if (color < 256 && graph != NULL && graph->colorentry_set_p[color])
+    for (i = 0; i < 3; i++)
+      rgb[i] = graph->colorentry[color][i];
+  else if (color < 32)
+    for (i = 0; i < 3; i++)
+      rgb[i] = color_map[color][i];
+  else
+    return 0;
+
+  return 1;
+}
+
+/* Convert the keyword NAME into an edge type.  Unlike the names above,
+   there are no arbitrary edge types, so -1 is returned for an unknown
+   NAME.  */
+
+int
+gdl_edge_type_from_name (char *name)
+{
+  return find_span (edge_type_spans, EDGE_TYPE_NUM, name);
+}
+
+const gdl_span *
+gdl_edge_type_span (gdl_edge_type type)
+{
+  assert (type < EDGE_TYPE_NUM);
+  return &edge_type_spans[type];
+}
@@ -0,0 +1,513 @@
+/* The size budgets of gdl graphs.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* A budget limits the number of nodes and edges in a graph and the
+   bytes of their labels, counting the subgraphs at any depth.  It is
+   enforced by gdl_new_graph_node, gdl_new_graph_edge and the label
+   setters.  Once a limit is reached, the further nodes and edges are not
+   added and the further labels are not set.  They are only counted, by
+   the label of a single summary node in the graph, "N more nodes elided"
+   etc.  The objects returned for the elided nodes and edges belong to
+   the budget, and may be changed but not added to a graph.
+
+   The edges must not refer to the elided nodes, which the viewers would
+   reject.  So the titles of the nodes and subgraphs in the graph are
+   kept, and an edge to a title which is not known yet waits for it.  It
+   is redirected to the summary node if the title turns out to be
+   elided, or right away once the nodes are being elided.
+
+   A subgraph created by gdl_new_graph_subgraph is elided as well once
+   the nodes are, and the graph returned for it elides everything put
+   into it.  A subgraph which is built apart and added by
+   gdl_add_subgraph counts towards the budget, but is never cut itself.  Nor are the edges of a
+   shared graph redirected, see gdl_new_graph_shared.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libiberty.h>
+#include <hashtab.h>
+
+#include "gdl.h"
+#include "gdl-budget.h"
+
+/* The title of the summary node.  The ends of the edges redirected to
+   it are told by this very string.  */
+static char summary_title[] = "gdl.elided";
+
+/* An end of an edge waiting for the title it refers to.  */
+
+typedef struct pending_end pending_end;
+
+struct pending_end
+{
+  gdl_edge *edge;
+  int target_p;
+  pending_end *next;
+};
+
+typedef struct
+{
+  char *title;
+  pending_end *ends;
+} pending_title;
+
+struct gdl_budget
+{
+  /* The graph which has the budget.  */
+  gdl_graph *graph;
+  /* The limits, 0 for none.  */
+  int max_nodes;
+  int max_edges;
+  long max_label_bytes;
+
+  int node_num;
+  int edge_num;
+  long label_bytes;
+  int elided_nodes;
+  int elided_graphs;
+  int elided_edges;
+  int elided_labels;
+
+  /* The titles of the nodes and subgraphs in the graph.  */
+  htab_t titles;
+  /* The pending_title of the edges to the titles not known yet.  */
+  htab_t pending;
+
+  gdl_node *summary;
+  char summary_label[128];
+  /* The objects returned for the elided nodes, subgraphs and edges.  */
+  gdl_node *elided_node;
+  gdl_graph *elided_graph;
+  gdl_edge *elided_edge;
+};
+
+static hashval_t
+title_hash (const void *p)
+{
+  return htab_hash_string ((const char *) p);
+}
+
+static int
+title_eq (const void *p1, const void *p2)
+{
+  return strcmp ((const char *) p1, (const char *) p2) == 0;
+}
+
+static hashval_t
+pending_title_hash (const void *p)
+{
+  return htab_hash_string (((const pending_title *) p)->title);
+}
+
+static int
+pending_title_eq (const void *p1, const void *p2)
+{
+  return strcmp (((const pending_title *) p1)->title,
+                 ((const pending_title *) p2)->title) == 0;
+}
+
+static void
+pending_title_del (void *p)
+{
+  pending_title *t = (pending_title *) p;
+  pending_end *end, *next;
+
+  for (end = t->ends; end != NULL; end = next)
+    {
+      next = end->next;
+      free (end);
+    }
+  free (t->title);
+  free (t);
+}
+
+/* Return 1 if TITLE is in the graph of BUDGET.  */
+
+static int
+known_title_p (gdl_budget *budget, char *title)
+{
+  return htab_find (budget->titles, title) != NULL;
+}
+
+/* Refresh the label of the summary node, which is created the first
+   time.  */
+
+static void
+update_summary (gdl_budget *budget)
+{
+  char *p = budget->summary_label;
+
+  if (budget->summary == NULL)
+    {
+      budget->summary = gdl_new_node (summary_title);
+      gdl_set_node_color (budget->summary, GDL_COLOR_DARKGREY);
+      gdl_add_node (budget->graph, budget->summary);
+      *htab_find_slot (budget->titles, budget->summary->title, INSERT)
+        = budget->summary->title;
+    }
+
+  if (budget->elided_nodes)
+    p += sprintf (p, "%d more nodes elided", budget->elided_nodes);
+  if (budget->elided_graphs)
+    p += sprintf (p, "%s%d more subgraphs elided",
+                  p > budget->summary_label ? "\n" : "",
+                  budget->elided_graphs);
+  if (budget->elided_edges)
+    p += sprintf (p, "%s%d more edges elided",
+                  p > budget->summary_label ? "\n" : "",
+                  budget->elided_edges);
+  if (budget->elided_labels)
+    sprintf (p, "%s%d more labels elided",
+             p > budget->summary_label ? "\n" : "",
+             budget->elided_labels);
+
+  /* Not by gdl_set_node_label, which would count it.  */
+  budget->summary->label = budget->summary_label;
+  budget->summary->set_p[GDL_NODE_ATTR_label] = 1;
+}
+
+/* Resolve the edges waiting for TITLE, which is redirected to the summary
+   node if REDIRECT_P.  */
+
+static void
+resolve_title (gdl_budget *budget, char *title, int redirect_p)
+{
+  pending_title key, *t;
+  pending_end *end;
+  char **name;
+  void **slot;
+
+  if (title == NULL || htab_elements (budget->pending) == 0)
+    return;
+
+  key.title = title;
+  slot = htab_find_slot (budget->pending, &key, NO_INSERT);
+  if (slot == NULL)
+    return;
+
+  t = (pending_title *) *slot;
+  if (redirect_p)
+    for (end = t->ends; end != NULL; end = end->next)
+      {
+        name = end->target_p ? &end->edge->targetname
+                             : &end->edge->sourcename;
+        free (*name);
+        *name = xstrdup (summary_title);
+      }
+  htab_clear_slot (budget->pending, slot);
+}
+
+/* Keep TITLE, which is in the graph of BUDGET.  */
+
+static void
+add_title (gdl_budget *budget, char *title)
+{
+  *htab_find_slot (budget->titles, title, INSERT) = title;
+  resolve_title (budget, title, 0);
+}
+
+/* Make the end of EDGE to TITLE wait for it if not known yet.  */
+
+static void
+add_end (gdl_budget *budget, gdl_edge *edge, char *title, int target_p)
+{
+  pending_title key, *t;
+  pending_end *end;
+  void **slot;
+
+  if (known_title_p (budget, title))
+    return;
+
+  key.title = title;
+  slot = htab_find_slot (budget->pending, &key, INSERT);
+  if (*slot == NULL)
+    {
+      t = XNEW (pending_title);
+      t->title = xstrdup (title);
+      t->ends = NULL;
+      *slot = t;
+    }
+  t = (pending_title *) *slot;
+
+  end = XNEW (pending_end);
+  end->edge = edge;
+  end->target_p = target_p;
+  end->next = t->ends;
+  t->ends = end;
+}
+
+/* Keep the titles in GRAPH, and count its nodes.  */
+
+static void
+add_titles (gdl_budget *budget, gdl_graph *graph)
+{
+  gdl_node *node;
+  gdl_graph *subgraph;
+
+  for (node = graph->node; node != NULL; node = node->next)
+    {
+      budget->node_num++;
+      if (node->set_p[GDL_NODE_ATTR_label])
+        budget->label_bytes += strlen (node->label);
+      add_title (budget, node->title);
+    }
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    {
+      add_title (budget, subgraph->title);
+      add_titles (budget, subgraph);
+    }
+}
+
+/* Count the edges in GRAPH.  The edges of a shared graph, which is
+   shown by GRAPH or an enclosing graph as SHARED_P tells, are never
+   redirected.  */
+
+static void
+add_edges (gdl_budget *budget, gdl_graph *graph, int shared_p)
+{
+  gdl_edge *edge;
+  gdl_graph *subgraph;
+
+  shared_p |= graph->shared != NULL;
+  for (edge = graph->edge; edge != NULL; edge = edge->next)
+    {
+      if (edge->set_p[GDL_EDGE_ATTR_label])
+        budget->label_bytes += strlen (edge->label);
+      if (shared_p)
+        budget->edge_num++;
+      else
+        gdl_budget_add_edge (budget, edge);
+    }
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    add_edges (budget, subgraph, shared_p);
+}
+
+/* Set a budget on GRAPH, of MAX_NODES nodes, MAX_EDGES edges and
+   MAX_LABEL_BYTES bytes of node and edge labels, where 0 means no limit.
+   The objects already in the graph are counted.  The budget is freed
+   with the graph.  */
+
+void
+gdl_set_graph_budget (gdl_graph *graph, int max_nodes, int max_edges,
+                      long max_label_bytes)
+{
+  gdl_budget *budget = graph->budget;
+
+  if (budget == NULL)
+    {
+      budget = XCNEW (gdl_budget);
+      budget->graph = graph;
+      budget->titles = htab_create (1024, title_hash, title_eq, NULL);
+      budget->pending = htab_create (64, pending_title_hash,
+                                     pending_title_eq, pending_title_del);
+      graph->budget = budget;
+
+      add_title (budget, graph->title);
+      add_titles (budget, graph);
+      add_edges (budget, graph, 0);
+    }
+
+  budget->max_nodes = max_nodes;
+  budget->max_edges = max_edges;
+  budget->max_label_bytes = max_label_bytes;
+}
+
+/* Return 1 if the nodes created in GRAPH, which is under BUDGET, are
+   elided.  */
+
+static int
+nodes_elided_p (gdl_budget *budget, gdl_graph *graph)
+{
+  return graph == budget->elided_graph
+         || (budget->max_nodes != 0 && budget->node_num >= budget->max_nodes);
+}
+
+/* Return the object for a node TITLE to add to GRAPH if it is elided, or
+   NULL if it fits into BUDGET.  */
+
+gdl_node *
+gdl_budget_elide_node (gdl_budget *budget, gdl_graph *graph, char *title)
+{
+  if (!nodes_elided_p (budget, graph))
+    return NULL;
+
+  budget->elided_nodes++;
+  update_summary (budget);
+  resolve_title (budget, title, 1);
+
+  if (budget->elided_node == NULL)
+    budget->elided_node = gdl_new_node (summary_title);
+  return budget->elided_node;
+}
+
+/* Return the graph for a subgraph TITLE to add to GRAPH if it is elided,
+   or NULL if it fits into BUDGET.  The graph belongs to the budget, and
+   the objects created in it are elided as well.  */
+
+gdl_graph *
+gdl_budget_elide_graph (gdl_budget *budget, gdl_graph *graph, char *title)
+{
+  if (!nodes_elided_p (budget, graph))
+    return NULL;
+
+  budget->elided_graphs++;
+  update_summary (budget);
+  resolve_title (budget, title, 1);
+
+  if (budget->elided_graph == NULL)
+    {
+      budget->elided_graph = gdl_new_graph (summary_title);
+      budget->elided_graph->budget = budget;
+    }
+  return budget->elided_graph;
+}
+
+/* Count NODE, which is added.  */
+
+void
+gdl_budget_add_node (gdl_budget *budget, gdl_node *node)
+{
+  budget->node_num++;
+  add_title (budget, node->title);
+}
+
+/* Return the object for an edge from *SOURCE to *TARGET to add to GRAPH
+   if it is elided, or NULL if it fits into BUDGET.  The ends to the
+   elided nodes are redirected to the summary node.  */
+
+gdl_edge *
+gdl_budget_elide_edge (gdl_budget *budget, gdl_graph *graph, char **source,
+                       char **target)
+{
+  if (budget->elided_nodes || budget->elided_graphs)
+    {
+      if (!known_title_p (budget, *source))
+        *source = summary_title;
+      if (!known_title_p (budget, *target))
+        *target = summary_title;
+    }
+
+  if (graph == budget->elided_graph
+      || (budget->max_edges != 0 && budget->edge_num >= budget->max_edges)
+      || (*source == summary_title && *target == summary_title))
+    {
+      budget->elided_edges++;
+      update_summary (budget);
+
+      if (budget->elided_edge == NULL)
+        budget->elided_edge = gdl_new_edge (summary_title, summary_title);
+      return budget->elided_edge;
+    }
+
+  return NULL;
+}
+
+/* Count EDGE, which is added.  */
+
+void
+gdl_budget_add_edge (gdl_budget *budget, gdl_edge *edge)
+{
+  budget->edge_num++;
+  add_end (budget, edge, edge->sourcename, 0);
+  add_end (budget, edge, edge->targetname, 1);
+}
+
+/* Count SUBGRAPH, which is added with its contents.  */
+
+void
+gdl_budget_add_subgraph (gdl_budget *budget, gdl_graph *subgraph)
+{
+  add_title (budget, subgraph->title);
+  add_titles (budget, subgraph);
+  add_edges (budget, subgraph, 0);
+}
+
+/* Make BUDGET refer to TITLE, which is a copy of a title in the graph
+   whose original may be freed.  */
+
+void
+gdl_budget_move_title (gdl_budget *budget, char *title)
+{
+  void **slot = htab_find_slot (budget->titles, title, NO_INSERT);
+
+  if (slot != NULL)
+    *slot = title;
+}
+
+/* Return 1 if LABEL fits into BUDGET, and count it.  */
+
+int
+gdl_budget_label_p (gdl_budget *budget, char *label)
+{
+  size_t len = strlen (label);
+
+  /* Even an empty label is elided once the labels are used up.  */
+  if (budget->max_label_bytes != 0
+      && (budget->label_bytes + (long) len > budget->max_label_bytes
+          || budget->label_bytes >= budget->max_label_bytes))
+    {
+      budget->elided_labels++;
+      update_summary (budget);
+      return 0;
+    }
+
+  budget->label_bytes += len;
+  return 1;
+}
+
+/* Free BUDGET.  The summary node is freed with the graph.  */
+
+void
+gdl_free_budget (gdl_budget *budget)
+{
+  htab_delete (budget->titles);
+  htab_delete (budget->pending);
+  if (budget->elided_node != NULL)
+    gdl_free_node (budget->elided_node);
+  if (budget->elided_edge != NULL)
+    gdl_free_edge (budget->elided_edge);
+  if (budget->elided_graph != NULL)
+    {
+      budget->elided_graph->budget = NULL;
+      gdl_free_graph (budget->elided_graph);
+    }
+  free (budget);
+}
+
+/* Return the bytes of labels which the budget of GRAPH has room for, or
+   -1 if they are not limited.  Return 0 if the nodes created in GRAPH
+   are elided, so that the caller can skip making their labels.  */
+
+long
+gdl_graph_label_room (gdl_graph *graph)
+{
+  gdl_budget *budget = find_budget (graph);
+
+  if (budget == NULL)
+    return -1;
+  if (nodes_elided_p (budget, graph))
+    return 0;
+  if (budget->max_label_bytes == 0)
+    return -1;
+  if (budget->label_bytes >= budget->max_label_bytes)
+    return 0;
+  return budget->max_label_bytes - budget->label_bytes;
+}
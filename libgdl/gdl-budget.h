@@ -0,0 +1,50 @@
+/* The size budgets of gdl graphs, used inside libgdl.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef GDL_BUDGET_H
+#define GDL_BUDGET_H
+
+#include "gdl.h"
+
+/* Return the budget which GRAPH is under, the one of the nearest graph
+   having a budget, or NULL.  */
+
+static inline gdl_budget *
+find_budget (gdl_graph *graph)
+{
+  for (; graph != NULL; graph = graph->parent)
+    if (graph->budget != NULL)
+      return graph->budget;
+  return NULL;
+}
+
+extern gdl_node *gdl_budget_elide_node (gdl_budget *budget,
+                                        gdl_graph *graph, char *title);
+extern gdl_graph *gdl_budget_elide_graph (gdl_budget *budget,
+                                          gdl_graph *graph, char *title);
+extern void gdl_budget_add_node (gdl_budget *budget, gdl_node *node);
+extern gdl_edge *gdl_budget_elide_edge (gdl_budget *budget,
+                                        gdl_graph *graph, char **source,
+                                        char **target);
+extern void gdl_budget_add_edge (gdl_budget *budget, gdl_edge *edge);
+extern void gdl_budget_add_subgraph (gdl_budget *budget,
+                                     gdl_graph *subgraph);
+extern void gdl_budget_move_title (gdl_budget *budget, char *title);
+extern int gdl_budget_label_p (gdl_budget *budget, char *label);
+extern void gdl_free_budget (gdl_budget *budget);
+
+#endif /* GDL_BUDGET_H */
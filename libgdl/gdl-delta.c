@@ -0,0 +1,885 @@
+/* Record a series of gdl graphs as an append-only delta log, and replay
+   it.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* A delta log holds the snapshots of a graph, e.g. a function after each
+   pass, as the changes from one snapshot to the next.  The first step is
+   the base snapshot, which is all additions.  Each record is a line of
+   its own, where the strings are quoted and "-" stands for none:
+
+     gdl-delta 1
+     step "cfg"
+     +graph "top graph" - -
+     +graph "main.2" "top graph" "bb 2"
+     +node "bb.2" "main.2" "x = 1;"
+     +edge "top graph" "main.0" "main.2" edge -
+     step "ccp"
+     ~node "bb.2" "x = 2;"
+     ^node "bb.3" "main.4"
+     -edge "top graph" "main.2" "main.3" backedge -
+     -node "bb.5"
+     -graph "main.5"
+
+   The records add (+), remove (-), relabel (~) or move (^) a node or a
+   graph, found by its title, or add or remove an edge, found by its
+   graph, source, target, type and label.  Every object which is gone is
+   removed on its own, so a record never affects the ones it contains.
+   The writer keeps the last snapshot as titles and labels only, so the
+   size of a step grows with the changes rather than with the graph.
+
+   Only the structure and the labels are recorded, not the other
+   attributes or the styles.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libiberty.h>
+#include <hashtab.h>
+
+#include "gdl.h"
+
+#define DELTA_MAGIC "gdl-delta 1"
+
+typedef enum
+{
+  DELTA_NODE,
+  DELTA_GRAPH
+} delta_kind;
+
+static const char *delta_kind_names[] = { "node", "graph" };
+
+/* A node or a graph, in the writer or the replay.  The strings are
+   owned.  */
+
+typedef struct
+{
+  char *title;
+  delta_kind kind;
+  char *parent;
+  char *label;
+  /* The step which saw it last, for the writer, or the order in which it
+     was added, for the replay.  */
+  int seq;
+  /* The graph created for it by the replay.  */
+  gdl_graph *graph;
+} delta_object;
+
+/* The edges with the same graph, source, target, type and label.  */
+
+typedef struct
+{
+  char *graph;
+  char *source;
+  char *target;
+  gdl_edge_type type;
+  char *label;
+  /* The number of the edges in the last snapshot, and in the one being
+     written.  The replay only uses COUNT.  */
+  int old_count;
+  int count;
+  int seq;
+} delta_edge;
+
+struct gdl_delta
+{
+  FILE *fout;
+  htab_t objects;
+  htab_t edges;
+  int step;
+  int record_num;
+};
+
+/* Compare the strings S1 and S2, which may be NULL.  */
+
+static int
+str_eq_p (const char *s1, const char *s2)
+{
+  if (s1 == NULL || s2 == NULL)
+    return s1 == s2;
+  return !strcmp (s1, s2);
+}
+
+static char *
+str_dup (const char *s)
+{
+  return s ? xstrdup (s) : NULL;
+}
+
+static hashval_t
+delta_object_hash (const void *p)
+{
+  return htab_hash_string (((const delta_object *) p)->title);
+}
+
+static int
+delta_object_eq (const void *p1, const void *p2)
+{
+  return !strcmp (((const delta_object *) p1)->title,
+                  ((const delta_object *) p2)->title);
+}
+
+static void
+delta_object_del (void *p)
+{
+  delta_object *o = (delta_object *) p;
+
+  free (o->title);
+  free (o->parent);
+  free (o->label);
+  free (o);
+}
+
+static hashval_t
+delta_edge_hash (const void *p)
+{
+  const delta_edge *e = (const delta_edge *) p;
+  hashval_t h;
+
+  h = htab_hash_string (e->graph);
+  h = h * 31 + htab_hash_string (e->source);
+  h = h * 31 + htab_hash_string (e->target);
+  h = h * 31 + e->type;
+  if (e->label != NULL)
+    h = h * 31 + htab_hash_string (e->label);
+  return h;
+}
+
+static int
+delta_edge_eq (const void *p1, const void *p2)
+{
+  const delta_edge *e1 = (const delta_edge *) p1;
+  const delta_edge *e2 = (const delta_edge *) p2;
+
+  return e1->type == e2->type && !strcmp (e1->graph, e2->graph)
+         && !strcmp (e1->source, e2->source)
+         && !strcmp (e1->target, e2->target)
+         && str_eq_p (e1->label, e2->label);
+}
+
+static void
+delta_edge_del (void *p)
+{
+  delta_edge *e = (delta_edge *) p;
+
+  free (e->graph);
+  free (e->source);
+  free (e->target);
+  free (e->label);
+  free (e);
+}
+
+static void
+init_tables (htab_t *objects, htab_t *edges)
+{
+  *objects = htab_create (1024, delta_object_hash, delta_object_eq,
+                          delta_object_del);
+  *edges = htab_create (1024, delta_edge_hash, delta_edge_eq,
+                        delta_edge_del);
+}
+
+/* Writing.  */
+
+/* Print STR quoted, or "-" if it is NULL.  */
+
+static void
+print_delta_string (FILE *fout, const char *str)
+{
+  const char *p;
+
+  if (str == NULL)
+    {
+      fputs (" -", fout);
+      return;
+    }
+
+  fputs (" \"", fout);
+  for (p = str; *p; p++)
+    switch (*p)
+      {
+      case '"':
+        fputs ("\\\"", fout);
+        break;
+      case '\\':
+        fputs ("\\\\", fout);
+        break;
+      case '\n':
+        fputs ("\\n", fout);
+        break;
+      default:
+        putc (*p, fout);
+        break;
+      }
+  putc ('"', fout);
+}
+
+static void
+print_object_record (gdl_delta *delta, char op, delta_object *o)
+{
+  FILE *fout = delta->fout;
+
+  fprintf (fout, "%c%s", op, delta_kind_names[o->kind]);
+  print_delta_string (fout, o->title);
+  if (op == '+' || op == '^')
+    print_delta_string (fout, o->parent);
+  if (op == '+' || op == '~')
+    print_delta_string (fout, o->label);
+  putc ('\n', fout);
+  delta->record_num++;
+}
+
+static void
+print_edge_record (gdl_delta *delta, char op, delta_edge *e)
+{
+  FILE *fout = delta->fout;
+  const gdl_span *type = gdl_edge_type_span (e->type);
+
+  fputs (op == '+' ? "+edge" : "-edge", fout);
+  print_delta_string (fout, e->graph);
+  print_delta_string (fout, e->source);
+  print_delta_string (fout, e->target);
+  putc (' ', fout);
+  fwrite (type->str, 1, type->len, fout);
+  print_delta_string (fout, e->label);
+  putc ('\n', fout);
+  delta->record_num++;
+}
+
+/* Compare the node or graph TITLE in the snapshot being written with the
+   last one, and print the records for the difference.  */
+
+static void
+visit_object (gdl_delta *delta, delta_kind kind, char *title, char *parent,
+              char *label)
+{
+  delta_object key, *o;
+  void **slot;
+
+  key.title = title;
+  slot = htab_find_slot (delta->objects, &key, INSERT);
+  o = (delta_object *) *slot;
+
+  if (o == NULL || o->kind != kind)
+    {
+      if (o == NULL)
+        {
+          o = XCNEW (delta_object);
+          o->title = xstrdup (title);
+          *slot = o;
+        }
+      else if (o->seq == delta->step)
+        /* The titles are expected to be unique, the first one wins.  */
+        return;
+      else
+        {
+          print_object_record (delta, '-', o);
+          free (o->parent);
+          free (o->label);
+        }
+      o->kind = kind;
+      o->parent = str_dup (parent);
+      o->label = str_dup (label);
+      print_object_record (delta, '+', o);
+    }
+  else if (o->seq == delta->step)
+    return;
+  else
+    {
+      if (!str_eq_p (o->parent, parent))
+        {
+          free (o->parent);
+          o->parent = str_dup (parent);
+          print_object_record (delta, '^', o);
+        }
+      if (!str_eq_p (o->label, label))
+        {
+          free (o->label);
+          o->label = str_dup (label);
+          print_object_record (delta, '~', o);
+        }
+    }
+  o->seq = delta->step;
+}
+
+/* Count EDGE of GRAPH in the snapshot being written, and print a record
+   if there are more such edges than in the last one.  */
+
+static void
+visit_edge (gdl_delta *delta, gdl_graph *graph, gdl_edge *edge)
+{
+  delta_edge key, *e;
+  void **slot;
+
+  key.graph = graph->title;
+  key.source = edge->sourcename;
+  key.target = edge->targetname;
+  key.type = edge->type;
+  key.label = edge->set_p[GDL_EDGE_ATTR_label] ? edge->label : NULL;
+  slot = htab_find_slot (delta->edges, &key, INSERT);
+  e = (delta_edge *) *slot;
+  if (e == NULL)
+    {
+      e = XCNEW (delta_edge);
+      e->graph = xstrdup (key.graph);
+      e->source = xstrdup (key.source);
+      e->target = xstrdup (key.target);
+      e->type = key.type;
+      e->label = str_dup (key.label);
+      *slot = e;
+    }
+
+  if (++e->count > e->old_count)
+    print_edge_record (delta, '+', e);
+}
+
+/* Walk GRAPH, which is in the graph titled PARENT, in preorder, so that a
+   graph is added before what it contains.  */
+
+static void
+visit_graph (gdl_delta *delta, gdl_graph *graph, char *parent)
+{
+  gdl_node *node;
+  gdl_graph *subgraph;
+  gdl_edge *edge;
+
+  visit_object (delta, DELTA_GRAPH, graph->title, parent,
+                graph->set_p[GDL_GRAPH_ATTR_label] ? graph->label : NULL);
+  for (node = graph->node; node != NULL; node = node->next)
+    visit_object (delta, DELTA_NODE, node->title, graph->title,
+                  node->set_p[GDL_NODE_ATTR_label] ? node->label : NULL);
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    visit_graph (delta, subgraph, graph->title);
+  for (edge = graph->edge; edge != NULL; edge = edge->next)
+    visit_edge (delta, graph, edge);
+}
+
+/* Print the records for the edges which are fewer than in the last
+   snapshot, and start counting anew.  */
+
+static int
+flush_edge (void **slot, void *data)
+{
+  gdl_delta *delta = (gdl_delta *) data;
+  delta_edge *e = (delta_edge *) *slot;
+
+  for (; e->old_count > e->count; e->old_count--)
+    print_edge_record (delta, '-', e);
+  if (e->count == 0)
+    htab_clear_slot (delta->edges, slot);
+  else
+    {
+      e->old_count = e->count;
+      e->count = 0;
+    }
+  return 1;
+}
+
+/* Print the record for a node or a graph which is gone.  */
+
+static int
+flush_object (void **slot, void *data)
+{
+  gdl_delta *delta = (gdl_delta *) data;
+  delta_object *o = (delta_object *) *slot;
+
+  if (o->seq != delta->step)
+    {
+      print_object_record (delta, '-', o);
+      htab_clear_slot (delta->objects, slot);
+    }
+  return 1;
+}
+
+/* Start a delta log in the file.  */
+
+gdl_delta *
+gdl_new_delta (FILE *fout)
+{
+  gdl_delta *delta;
+
+  delta = XNEW (gdl_delta);
+  delta->fout = fout;
+  init_tables (&delta->objects, &delta->edges);
+  delta->step = 0;
+  delta->record_num = 0;
+  fputs (DELTA_MAGIC "\n", fout);
+  return delta;
+}
+
+/* Append GRAPH to the delta log as the step NAME.  Return the number of
+   the records written, 0 if GRAPH is the same as the last one.  */
+
+int
+gdl_dump_delta_step (gdl_delta *delta, const char *name, gdl_graph *graph)
+{
+  delta->step++;
+  delta->record_num = 0;
+
+  fputs ("step", delta->fout);
+  print_delta_string (delta->fout, name);
+  putc ('\n', delta->fout);
+
+  visit_graph (delta, graph, NULL);
+  htab_traverse (delta->edges, flush_edge, delta);
+  htab_traverse (delta->objects, flush_object, delta);
+  return delta->record_num;
+}
+
+/* Free the delta log, the file is left open.  */
+
+void
+gdl_free_delta (gdl_delta *delta)
+{
+  htab_delete (delta->objects);
+  htab_delete (delta->edges);
+  free (delta);
+}
+
+/* Replaying.  */
+
+typedef struct
+{
+  FILE *fin;
+  char *buf;
+  size_t size;
+  int line;
+  htab_t objects;
+  htab_t edges;
+  int seq;
+} delta_reader;
+
+/* Read a line into R->buf without the newline.  Return 0 at the end of
+   the file.  */
+
+static int
+read_line (delta_reader *r)
+{
+  size_t len = 0;
+  int c;
+
+  while ((c = getc (r->fin)) != EOF && c != '\n')
+    {
+      if (len + 1 >= r->size)
+        {
+          r->size = r->size ? r->size * 2 : 256;
+          r->buf = XRESIZEVEC (char, r->buf, r->size);
+        }
+      r->buf[len++] = c;
+    }
+  if (c == EOF && len == 0)
+    return 0;
+
+  if (r->buf == NULL)
+    {
+      r->size = 256;
+      r->buf = XNEWVEC (char, r->size);
+    }
+  r->buf[len] = '\0';
+  r->line++;
+  return 1;
+}
+
+/* Split the line at P into at most MAX tokens in place.  A quoted string
+   is unescaped, and "-" becomes NULL.  Return the number of tokens, or
+   -1 on error.  */
+
+static int
+split_line (char *p, char **tokens, int max)
+{
+  int n = 0;
+  char *q;
+
+  while (*p)
+    {
+      if (*p == ' ')
+        {
+          p++;
+          continue;
+        }
+      if (n == max)
+        return -1;
+
+      if (*p == '"')
+        {
+          tokens[n++] = q = ++p;
+          for (; *p != '"'; p++)
+            {
+              if (*p == '\0')
+                return -1;
+              if (*p == '\\')
+                {
+                  p++;
+                  if (*p == 'n')
+                    *q++ = '\n';
+                  else if (*p == '"' || *p == '\\')
+                    *q++ = *p;
+                  else
+                    return -1;
+                }
+              else
+                *q++ = *p;
+            }
+          p++;
+          *q = '\0';
+        }
+      else
+        {
+          tokens[n] = p;
+          while (*p && *p != ' ')
+            p++;
+          if (*p)
+            *p++ = '\0';
+          if (!strcmp (tokens[n], "-"))
+            tokens[n] = NULL;
+          n++;
+        }
+    }
+  return n;
+}
+
+/* Apply the record of an edge, with the tokens after the operator.  */
+
+static int
+replay_edge (delta_reader *r, char op, char **tokens, int n)
+{
+  delta_edge key, *e;
+  void **slot;
+  int type;
+
+  if (n != 5 || tokens[0] == NULL || tokens[1] == NULL || tokens[2] == NULL
+      || tokens[3] == NULL || (type = gdl_edge_type_from_name (tokens[3])) < 0)
+    return -1;
+
+  key.graph = tokens[0];
+  key.source = tokens[1];
+  key.target = tokens[2];
+  key.type = type;
+  key.label = tokens[4];
+  slot = htab_find_slot (r->edges, &key, op == '+' ? INSERT : NO_INSERT);
+  if (slot == NULL)
+    return 0;
+
+  e = (delta_edge *) *slot;
+  if (op == '-')
+    {
+      if (--e->count == 0)
+        htab_clear_slot (r->edges, slot);
+      return 0;
+    }
+
+  if (e == NULL)
+    {
+      e = XCNEW (delta_edge);
+      e->graph = xstrdup (key.graph);
+      e->source = xstrdup (key.source);
+      e->target = xstrdup (key.target);
+      e->type = key.type;
+      e->label = str_dup (key.label);
+      e->seq = r->seq++;
+      *slot = e;
+    }
+  e->count++;
+  return 0;
+}
+
+/* Apply the record of a node or a graph of KIND, with the tokens after
+   the operator.  */
+
+static int
+replay_object (delta_reader *r, char op, delta_kind kind, char **tokens,
+               int n)
+{
+  delta_object key, *o;
+  void **slot;
+
+  if (n < 1 || tokens[0] == NULL
+      || n != (op == '+' ? 3 : op == '-' ? 1 : 2))
+    return -1;
+
+  key.title = tokens[0];
+  slot = htab_find_slot (r->objects, &key, op == '+' ? INSERT : NO_INSERT);
+  if (slot == NULL)
+    return 0;
+  o = (delta_object *) *slot;
+  if (o != NULL && op != '+' && o->kind != kind)
+    return 0;
+
+  switch (op)
+    {
+    case '+':
+      if (o == NULL)
+        {
+          o = XCNEW (delta_object);
+          o->title = xstrdup (tokens[0]);
+          *slot = o;
+        }
+      o->kind = kind;
+      free (o->parent);
+      free (o->label);
+      o->parent = str_dup (tokens[1]);
+      o->label = str_dup (tokens[2]);
+      o->seq = r->seq++;
+      break;
+    case '-':
+      htab_clear_slot (r->objects, slot);
+      break;
+    case '~':
+      free (o->label);
+      o->label = str_dup (tokens[1]);
+      break;
+    case '^':
+      free (o->parent);
+      o->parent = str_dup (tokens[1]);
+      o->seq = r->seq++;
+      break;
+    }
+  return 0;
+}
+
+/* Apply the record in R->buf.  Set *NAME to the name if it is a step,
+   and return 1 then, or to NULL otherwise.  Return -1 on error.  */
+
+static int
+replay_record (delta_reader *r, char **name)
+{
+  char *tokens[6], *p = r->buf;
+  int n;
+
+  *name = NULL;
+  if (!strncmp (p, "step ", 5))
+    {
+      if (split_line (p + 5, tokens, 1) != 1)
+        return -1;
+      *name = tokens[0];
+      return 1;
+    }
+
+  if (*p != '+' && *p != '-' && *p != '~' && *p != '^')
+    return -1;
+
+  if (!strncmp (p + 1, "edge ", 5))
+    {
+      if (*p == '~' || *p == '^')
+        return -1;
+      n = split_line (p + 6, tokens, 6);
+      return replay_edge (r, *p, tokens, n);
+    }
+  if (!strncmp (p + 1, "node ", 5))
+    {
+      n = split_line (p + 6, tokens, 6);
+      return replay_object (r, *p, DELTA_NODE, tokens, n);
+    }
+  if (!strncmp (p + 1, "graph ", 6))
+    {
+      n = split_line (p + 7, tokens, 6);
+      return replay_object (r, *p, DELTA_GRAPH, tokens, n);
+    }
+  return -1;
+}
+
+/* Collect the objects or the edges into an array.  */
+
+static int
+collect_entry (void **slot, void *data)
+{
+  void ***p = (void ***) data;
+
+  *(*p)++ = *slot;
+  return 1;
+}
+
+static void **
+collect_entries (htab_t table)
+{
+  void **entries, **p;
+
+  entries = p = XNEWVEC (void *, htab_elements (table) + 1);
+  htab_traverse (table, collect_entry, &p);
+  return entries;
+}
+
+static int
+object_seq_cmp (const void *p1, const void *p2)
+{
+  return (*(delta_object *const *) p1)->seq
+         - (*(delta_object *const *) p2)->seq;
+}
+
+static int
+edge_seq_cmp (const void *p1, const void *p2)
+{
+  return (*(delta_edge *const *) p1)->seq - (*(delta_edge *const *) p2)->seq;
+}
+
+/* Return the graph created for the title PARENT, or ROOT.  */
+
+static gdl_graph *
+find_parent_graph (htab_t objects, char *parent, gdl_graph *root)
+{
+  delta_object key, *o;
+
+  if (parent == NULL)
+    return root;
+  key.title = parent;
+  o = (delta_object *) htab_find (objects, &key);
+  if (o == NULL || o->graph == NULL)
+    return root;
+  return o->graph;
+}
+
+/* Build the graph of the objects and the edges, in the order they were
+   added.  The first graph without a parent is the top graph.  */
+
+static gdl_graph *
+materialize (delta_reader *r)
+{
+  size_t object_num = htab_elements (r->objects);
+  size_t edge_num = htab_elements (r->edges);
+  delta_object **objects, *o;
+  delta_edge **edges, *e;
+  gdl_graph *root = NULL, *g;
+  gdl_node *node;
+  gdl_edge *edge;
+  size_t i;
+  int j;
+
+  objects = (delta_object **) collect_entries (r->objects);
+  qsort (objects, object_num, sizeof (*objects), object_seq_cmp);
+  edges = (delta_edge **) collect_entries (r->edges);
+  qsort (edges, edge_num, sizeof (*edges), edge_seq_cmp);
+
+  for (i = 0; i < object_num; i++)
+    {
+      o = objects[i];
+      o->graph = NULL;
+      if (o->kind != DELTA_GRAPH)
+        continue;
+      o->graph = gdl_new_graph (o->title);
+      if (root == NULL && o->parent == NULL)
+        root = o->graph;
+    }
+  if (root == NULL)
+    root = gdl_new_graph (NULL);
+
+  /* Link the graphs before anything goes into their pools.  A graph
+     whose parent is missing goes into the top graph.  */
+  for (i = 0; i < object_num; i++)
+    {
+      o = objects[i];
+      if (o->graph == NULL || o->graph == root)
+        continue;
+      g = find_parent_graph (r->objects, o->parent, root);
+      gdl_add_subgraph (g == o->graph ? root : g, o->graph);
+    }
+
+  for (i = 0; i < object_num; i++)
+    {
+      o = objects[i];
+      if (o->graph != NULL)
+        {
+          if (o->label != NULL)
+            gdl_set_graph_label (o->graph,
+                                 gdl_graph_strdup (root, o->label));
+          continue;
+        }
+      g = find_parent_graph (r->objects, o->parent, root);
+      node = gdl_new_graph_node (g, o->title);
+      if (o->label != NULL)
+        gdl_set_node_label (node, gdl_graph_strdup (root, o->label));
+    }
+
+  for (i = 0; i < edge_num; i++)
+    {
+      e = edges[i];
+      g = find_parent_graph (r->objects, e->graph, root);
+      for (j = 0; j < e->count; j++)
+        {
+          edge = gdl_new_graph_edge (g, e->source, e->target);
+          gdl_set_edge_type (edge, e->type);
+          if (e->label != NULL)
+            gdl_set_edge_label (edge, gdl_graph_strdup (root, e->label));
+        }
+    }
+
+  free (objects);
+  free (edges);
+  return root;
+}
+
+/* Read the delta log from the file, and build the graph of the step STEP,
+   counted from 0 for the base snapshot, or of the last step if STEP is
+   negative.  The name of the step is returned in *NAME if NAME is not
+   NULL, which is allocated.  Return NULL on error, with the line in
+   *ERROR_LINE, which is 0 if there is no such step.  */
+
+gdl_graph *
+gdl_read_delta (FILE *fin, int step, char **name, int *error_line)
+{
+  delta_reader r;
+  gdl_graph *graph = NULL;
+  char *step_name = NULL, *s = NULL;
+  int n = -1, ret;
+
+  memset (&r, 0, sizeof (r));
+  r.fin = fin;
+  init_tables (&r.objects, &r.edges);
+  *error_line = 0;
+
+  if (!read_line (&r) || strcmp (r.buf, DELTA_MAGIC))
+    {
+      *error_line = 1;
+      goto out;
+    }
+
+  while (read_line (&r))
+    {
+      if (r.buf[0] == '\0')
+        continue;
+      ret = replay_record (&r, &s);
+      if (ret < 0 || (ret == 0 && n < 0))
+        {
+          *error_line = r.line;
+          goto out;
+        }
+      if (ret == 1)
+        {
+          if (step >= 0 && n == step)
+            break;
+          n++;
+          free (step_name);
+          step_name = s ? xstrdup (s) : NULL;
+        }
+    }
+
+  if (n >= 0 && (step < 0 || n == step))
+    {
+      graph = materialize (&r);
+      if (name != NULL)
+        {
+          *name = step_name;
+          step_name = NULL;
+        }
+    }
+
+ out:
+  free (step_name);
+  free (r.buf);
+  htab_delete (r.objects);
+  htab_delete (r.edges);
+  return graph;
+}
@@ -0,0 +1,458 @@
+/* Difference of gdl graphs.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* The nodes and subgraphs of the two graphs are matched by title, at any
+   depth, and the edges by their source, target and type.  The new graph
+   is indexed in hash tables once, and the old graph is walked once
+   against them, so the cost is linear in the sizes of the graphs.
+
+   The result is the new graph itself, where the added nodes and edges
+   are green and the relabeled nodes yellow.  The removed ones are copied
+   from the old graph in red, into the subgraph matching their old one.
+   The edges, which have no color of their own, get a copy of their style
+   with the color, so that e.g. a dashed edge stays dashed.
+   The subgraphs are colored the same, but in the light colors so that
+   their nodes stand out.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libiberty.h>
+#include <hashtab.h>
+
+#include "gdl.h"
+
+/* A node or a subgraph of the new graph.  */
+
+typedef struct
+{
+  char *title;
+  gdl_node *node;
+  gdl_graph *graph;
+  int matched_p;
+} diff_object;
+
+/* The edges of the new graph with the same source, target and type.  */
+
+typedef struct diff_edge diff_edge;
+
+struct diff_edge
+{
+  gdl_edge *edge;
+  int matched_p;
+  diff_edge *next;
+};
+
+typedef struct
+{
+  htab_t objects;
+  htab_t edges;
+  gdl_graph *new_graph;
+  gdl_diff_summary *summary;
+} differ;
+
+/* A copy of a style, or of no style, with another color.  */
+
+typedef struct
+{
+  gdl_style *style;
+  gdl_color color;
+  gdl_style *variant;
+} style_variant;
+
+/* The style_variant of the added and removed edges, which live as long
+   as the program.  */
+
+static htab_t style_variants;
+
+static hashval_t
+diff_object_hash (const void *p)
+{
+  return htab_hash_string (((const diff_object *) p)->title);
+}
+
+static int
+diff_object_eq (const void *p1, const void *p2)
+{
+  return strcmp (((const diff_object *) p1)->title,
+                 ((const diff_object *) p2)->title) == 0;
+}
+
+static hashval_t
+diff_edge_hash (const void *p)
+{
+  gdl_edge *edge = ((const diff_edge *) p)->edge;
+
+  return (htab_hash_string (edge->sourcename) * 31
+          + htab_hash_string (edge->targetname)) * 31 + edge->type;
+}
+
+static int
+diff_edge_eq (const void *p1, const void *p2)
+{
+  gdl_edge *edge1 = ((const diff_edge *) p1)->edge;
+  gdl_edge *edge2 = ((const diff_edge *) p2)->edge;
+
+  return edge1->type == edge2->type
+         && !strcmp (edge1->sourcename, edge2->sourcename)
+         && !strcmp (edge1->targetname, edge2->targetname);
+}
+
+static void
+diff_edge_del (void *p)
+{
+  diff_edge *e = (diff_edge *) p, *next;
+
+  for (; e != NULL; e = next)
+    {
+      next = e->next;
+      free (e);
+    }
+}
+
+static hashval_t
+style_variant_hash (const void *p)
+{
+  const style_variant *v = (const style_variant *) p;
+
+  return htab_hash_pointer (v->style) * 31 + v->color;
+}
+
+static int
+style_variant_eq (const void *p1, const void *p2)
+{
+  const style_variant *v1 = (const style_variant *) p1;
+  const style_variant *v2 = (const style_variant *) p2;
+
+  return v1->style == v2->style && v1->color == v2->color;
+}
+
+/* Return the copy of STYLE, which may be NULL, with COLOR.  */
+
+static gdl_style *
+color_style (gdl_style *style, gdl_color color)
+{
+  style_variant key, *v;
+  void **slot;
+  char *name;
+
+  if (style_variants == NULL)
+    style_variants = htab_create (16, style_variant_hash, style_variant_eq,
+                                  NULL);
+
+  key.style = style;
+  key.color = color;
+  slot = htab_find_slot (style_variants, &key, INSERT);
+  if (*slot != NULL)
+    return ((style_variant *) *slot)->variant;
+
+  v = XNEW (style_variant);
+  v->style = style;
+  v->color = color;
+  name = concat (style != NULL ? style->name : "diff",
+                 color == GDL_COLOR_GREEN ? ".added" : ".removed", NULL);
+  v->variant = gdl_new_style (name);
+  free (name);
+  if (style != NULL)
+    {
+      name = v->variant->name;
+      *v->variant = *style;
+      v->variant->name = name;
+    }
+  gdl_set_style_color (v->variant, color);
+  *slot = v;
+  return v->variant;
+}
+
+/* Return 1 if the strings S1 and S2, which may be NULL, differ.  */
+
+static int
+strings_differ_p (const char *s1, const char *s2)
+{
+  if (s1 == NULL || s2 == NULL)
+    return s1 != s2;
+  return strcmp (s1, s2) != 0;
+}
+
+/* Add an object for TITLE to D.  */
+
+static void
+index_object (differ *d, char *title, gdl_node *node, gdl_graph *graph)
+{
+  diff_object key, *obj;
+  void **slot;
+
+  key.title = title;
+  slot = htab_find_slot (d->objects, &key, INSERT);
+  /* The titles should be unique, keep the first one otherwise.  */
+  if (*slot != NULL)
+    return;
+
+  obj = XNEW (diff_object);
+  obj->title = title;
+  obj->node = node;
+  obj->graph = graph;
+  obj->matched_p = 0;
+  *slot = obj;
+}
+
+/* Index the nodes, subgraphs and edges in GRAPH into D.  */
+
+static void
+index_graph (differ *d, gdl_graph *graph)
+{
+  gdl_node *node;
+  gdl_graph *subgraph;
+  gdl_edge *edge;
+  diff_edge *e, **slot;
+
+  for (node = graph->node; node != NULL; node = node->next)
+    index_object (d, node->title, node, NULL);
+
+  for (edge = graph->edge; edge != NULL; edge = edge->next)
+    {
+      e = XNEW (diff_edge);
+      e->edge = edge;
+      e->matched_p = 0;
+      slot = (diff_edge **) htab_find_slot (d->edges, e, INSERT);
+      e->next = *slot;
+      *slot = e;
+    }
+
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    {
+      index_object (d, subgraph->title, NULL, subgraph);
+      index_graph (d, subgraph);
+    }
+}
+
+/* The labels of the objects, or NULL if not set.  */
+
+#define NODE_LABEL(NODE) \
+  ((NODE)->set_p[GDL_NODE_ATTR_label] ? (NODE)->label : NULL)
+#define EDGE_LABEL(EDGE) \
+  ((EDGE)->set_p[GDL_EDGE_ATTR_label] ? (EDGE)->label : NULL)
+#define GRAPH_LABEL(GRAPH) \
+  ((GRAPH)->set_p[GDL_GRAPH_ATTR_label] ? (GRAPH)->label : NULL)
+
+/* Copy the label of the old object into the new graph of D.  */
+
+static char *
+copy_label (differ *d, char *label)
+{
+  return gdl_graph_strdup (d->new_graph, label);
+}
+
+/* Find the new counterpart of the node or subgraph TITLE of the old
+   graph, as NODE_P tells, and mark it as matched.  Return NULL if there
+   is none.  */
+
+static diff_object *
+match_object (differ *d, char *title, int node_p)
+{
+  diff_object key, *obj;
+
+  key.title = title;
+  obj = (diff_object *) htab_find (d->objects, &key);
+  if (obj == NULL || obj->matched_p || (obj->node != NULL) != node_p)
+    return NULL;
+
+  obj->matched_p = 1;
+  return obj;
+}
+
+/* Walk OLD_GRAPH against the new graph of D, where TARGET is the new
+   graph which OLD_GRAPH maps to.  */
+
+static void
+diff_graph (differ *d, gdl_graph *old_graph, gdl_graph *target)
+{
+  gdl_node *node, *copy;
+  gdl_graph *subgraph, *new_subgraph;
+  gdl_edge *edge, *copy_edge;
+  diff_edge key, *e;
+  diff_object *obj;
+
+  for (node = old_graph->node; node != NULL; node = node->next)
+    {
+      obj = match_object (d, node->title, 1);
+      if (obj == NULL)
+        {
+          copy = gdl_new_graph_node (target, node->title);
+          gdl_set_node_style (copy, node->style);
+          if (node->set_p[GDL_NODE_ATTR_bordercolor])
+            gdl_set_node_bordercolor (copy, node->bordercolor);
+          if (node->set_p[GDL_NODE_ATTR_borderwidth])
+            gdl_set_node_borderwidth (copy, node->borderwidth);
+          if (NODE_LABEL (node) != NULL)
+            gdl_set_node_label (copy, copy_label (d, node->label));
+          gdl_set_node_color (copy, GDL_COLOR_RED);
+          d->summary->removed_nodes++;
+        }
+      else if (strings_differ_p (NODE_LABEL (node), NODE_LABEL (obj->node)))
+        {
+          gdl_set_node_color (obj->node, GDL_COLOR_YELLOW);
+          d->summary->relabeled_nodes++;
+        }
+      else
+        d->summary->same_nodes++;
+    }
+
+  for (subgraph = old_graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    {
+      obj = match_object (d, subgraph->title, 0);
+      if (obj == NULL)
+        {
+          new_subgraph = gdl_new_graph_subgraph (target, subgraph->title);
+          if (GRAPH_LABEL (subgraph) != NULL)
+            gdl_set_graph_label (new_subgraph,
+                                 copy_label (d, subgraph->label));
+          gdl_set_graph_color (new_subgraph, GDL_COLOR_LIGHTRED);
+          d->summary->removed_subgraphs++;
+        }
+      else
+        {
+          new_subgraph = obj->graph;
+          d->summary->same_subgraphs++;
+        }
+      diff_graph (d, subgraph, new_subgraph);
+    }
+
+  for (edge = old_graph->edge; edge != NULL; edge = edge->next)
+    {
+      key.edge = edge;
+      for (e = (diff_edge *) htab_find (d->edges, &key); e != NULL;
+           e = e->next)
+        if (!e->matched_p)
+          break;
+
+      if (e != NULL)
+        {
+          e->matched_p = 1;
+          d->summary->same_edges++;
+          continue;
+        }
+
+      copy_edge = gdl_new_graph_edge (target, edge->sourcename,
+                                      edge->targetname);
+      gdl_set_edge_type (copy_edge, edge->type);
+      if (edge->set_p[GDL_EDGE_ATTR_linestyle])
+        gdl_set_edge_linestyle (copy_edge, edge->linestyle);
+      if (edge->set_p[GDL_EDGE_ATTR_thickness])
+        gdl_set_edge_thickness (copy_edge, edge->thickness);
+      if (EDGE_LABEL (edge) != NULL)
+        gdl_set_edge_label (copy_edge, copy_label (d, edge->label));
+      gdl_set_edge_style (copy_edge,
+                          color_style (edge->style, GDL_COLOR_RED));
+      d->summary->removed_edges++;
+    }
+}
+
+/* Color the unmatched objects of the new graph of D as added.  */
+
+static int
+mark_added_object (void **slot, void *data)
+{
+  diff_object *obj = (diff_object *) *slot;
+  differ *d = (differ *) data;
+
+  if (obj->matched_p)
+    return 1;
+
+  if (obj->node != NULL)
+    {
+      gdl_set_node_color (obj->node, GDL_COLOR_GREEN);
+      d->summary->added_nodes++;
+    }
+  else
+    {
+      gdl_set_graph_color (obj->graph, GDL_COLOR_LIGHTGREEN);
+      d->summary->added_subgraphs++;
+    }
+  return 1;
+}
+
+static int
+mark_added_edge (void **slot, void *data)
+{
+  diff_edge *e;
+  differ *d = (differ *) data;
+
+  for (e = (diff_edge *) *slot; e != NULL; e = e->next)
+    if (!e->matched_p)
+      {
+        gdl_set_edge_style (e->edge,
+                            color_style (e->edge->style, GDL_COLOR_GREEN));
+        d->summary->added_edges++;
+      }
+  return 1;
+}
+
+/* Compare OLD_GRAPH with NEW_GRAPH, which is turned into the difference
+   graph as described above, and store the counts into SUMMARY.  The top
+   graphs are matched whatever their titles.  OLD_GRAPH is not changed,
+   and may be freed afterwards.  */
+
+void
+gdl_diff_graph (gdl_graph *old_graph, gdl_graph *new_graph,
+                gdl_diff_summary *summary)
+{
+  differ d;
+
+  memset (summary, 0, sizeof (*summary));
+  d.objects = htab_create (1024, diff_object_hash, diff_object_eq, free);
+  d.edges = htab_create (1024, diff_edge_hash, diff_edge_eq, diff_edge_del);
+  d.new_graph = new_graph;
+  d.summary = summary;
+
+  index_graph (&d, new_graph);
+  diff_graph (&d, old_graph, new_graph);
+  htab_traverse_noresize (d.objects, mark_added_object, &d);
+  htab_traverse_noresize (d.edges, mark_added_edge, &d);
+
+  htab_delete (d.objects);
+  htab_delete (d.edges);
+}
+
+/* Return 1 if SUMMARY records any difference.  */
+
+int
+gdl_diff_summary_changed_p (gdl_diff_summary *summary)
+{
+  return summary->added_nodes || summary->removed_nodes
+         || summary->relabeled_nodes || summary->added_subgraphs
+         || summary->removed_subgraphs || summary->added_edges
+         || summary->removed_edges;
+}
+
+/* Dump SUMMARY into the file in one line per kind of objects, the
+   counts being of the added, removed, relabeled and same ones.  */
+
+void
+gdl_dump_diff_summary (FILE *fout, gdl_diff_summary *summary)
+{
+  fprintf (fout, "nodes: +%d -%d ~%d =%d\n", summary->added_nodes,
+           summary->removed_nodes, summary->relabeled_nodes,
+           summary->same_nodes);
+  fprintf (fout, "subgraphs: +%d -%d =%d\n", summary->added_subgraphs,
+           summary->removed_subgraphs, summary->same_subgraphs);
+  fprintf (fout, "edges: +%d -%d =%d\n", summary->added_edges,
+           summary->removed_edges, summary->same_edges);
+}
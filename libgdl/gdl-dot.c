@@ -0,0 +1,484 @@
+/* Dump gdl graphs in the DOT language of Graphviz.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* The graph becomes a digraph, and each subgraph a cluster, whether it is
+   folded or not, as DOT has no folding.  The default node and edge
+   attributes of a graph become the "node" and "edge" statements of its
+   cluster, which DOT scopes the same way.  An edge to or from a subgraph
+   is attached to a node inside the cluster, and clipped at its border
+   with lhead or ltail.
+
+   The colors are written in RGB, after the color entries of the top
+   graph or else the default color map of VCG.  The back edges are
+   reversed with dir=back, so that they point upwards as in VCG, and the
+   near edges do not constrain the ranks.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libiberty.h>
+#include <hashtab.h>
+
+#include "gdl.h"
+#include "gdl-print.h"
+
+static const gdl_span shape_names[GDL_SHAPE_MAX] =
+{
+  {"box", 3},
+  {"diamond", 7},
+  {"ellipse", 7},
+  {"triangle", 8}
+};
+
+static const gdl_span linestyle_names[GDL_LINESTYLE_MAX] =
+{
+  {"solid", 5},
+  {"dashed", 6},
+  {"dotted", 6},
+  {"invis", 5}
+};
+
+/* A cluster, found by the title of its subgraph.  */
+
+typedef struct
+{
+  char *title;
+  int id;
+  /* The title of the node to attach the edges to.  */
+  char *anchor;
+} dot_cluster;
+
+typedef struct
+{
+  FILE *fout;
+  gdl_graph *top;
+  htab_t clusters;
+  int cluster_num;
+  /* The keyword of the attribute statement being printed, which is left
+     out if the list is empty, or NULL for a node or an edge statement.  */
+  const char *keyword;
+  /* The number of attributes printed in the current list.  */
+  int attr_num;
+} dot_writer;
+
+static hashval_t
+dot_cluster_hash (const void *p)
+{
+  return htab_hash_string (((const dot_cluster *) p)->title);
+}
+
+static int
+dot_cluster_eq (const void *p1, const void *p2)
+{
+  return strcmp (((const dot_cluster *) p1)->title,
+                 ((const dot_cluster *) p2)->title) == 0;
+}
+
+/* Return the title of the first node in GRAPH or in its subgraphs, or
+   NULL if there is none.  */
+
+static char *
+first_node_title (gdl_graph *graph)
+{
+  gdl_graph *subgraph;
+  char *title;
+
+  if (graph->node != NULL)
+    return graph->node->title;
+
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    if ((title = first_node_title (subgraph)) != NULL)
+      return title;
+
+  return NULL;
+}
+
+/* Number the subgraphs of GRAPH as clusters.  */
+
+static void
+collect_clusters (dot_writer *w, gdl_graph *graph)
+{
+  gdl_graph *subgraph;
+  dot_cluster *cluster;
+  void **slot;
+
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    {
+      cluster = XNEW (dot_cluster);
+      cluster->title = subgraph->title;
+      cluster->id = w->cluster_num++;
+      /* An empty cluster gets an invisible node named after it.  */
+      cluster->anchor = first_node_title (subgraph);
+      if (cluster->anchor == NULL)
+        cluster->anchor = subgraph->title;
+      slot = htab_find_slot (w->clusters, cluster, INSERT);
+      if (*slot != NULL)
+        free (*slot);
+      *slot = cluster;
+      collect_clusters (w, subgraph);
+    }
+}
+
+static dot_cluster *
+find_cluster (dot_writer *w, char *title)
+{
+  dot_cluster key;
+
+  key.title = title;
+  return (dot_cluster *) htab_find (w->clusters, &key);
+}
+
+/* Begin the attribute statement KEYWORD, i.e. "graph", "node" or
+   "edge".  */
+
+static void
+begin_attrs (dot_writer *w, const char *keyword)
+{
+  w->keyword = keyword;
+}
+
+/* Print the key of an attribute, after the separator from the previous
+   one or the opening bracket of the list.  */
+
+static void
+print_key (dot_writer *w, const char *key)
+{
+  if (w->attr_num++)
+    fputs (", ", w->fout);
+  else
+    {
+      if (w->keyword != NULL)
+        fputs (w->keyword, w->fout);
+      fputs (" [", w->fout);
+    }
+  fputs (key, w->fout);
+  putc ('=', w->fout);
+}
+
+/* Close the attribute list, if any, and the statement.  An attribute
+   statement without attributes is left out.  */
+
+static void
+end_attrs (dot_writer *w)
+{
+  if (w->attr_num)
+    fputs ("];\n", w->fout);
+  else if (w->keyword == NULL)
+    fputs (";\n", w->fout);
+  w->keyword = NULL;
+  w->attr_num = 0;
+}
+
+static void
+print_id (dot_writer *w, char *id)
+{
+  putc ('"', w->fout);
+  print_string (w->fout, id);
+  putc ('"', w->fout);
+}
+
+static void
+print_string_attr (dot_writer *w, const char *key, char *value)
+{
+  print_key (w, key);
+  print_id (w, value);
+}
+
+static void
+print_int_attr (dot_writer *w, const char *key, int value)
+{
+  print_key (w, key);
+  fprintf (w->fout, "%d", value);
+}
+
+static void
+print_color_attr (dot_writer *w, const char *key, gdl_color color)
+{
+  const gdl_span *span;
+  int rgb[3];
+
+  print_key (w, key);
+  if (gdl_get_color_rgb (w->top, color, rgb))
+    fprintf (w->fout, "\"#%02x%02x%02x\"", rgb[0], rgb[1], rgb[2]);
+  else
+    {
+      /* Let Graphviz try the name.  */
+      span = gdl_color_span (color);
+      putc ('"', w->fout);
+      fwrite (span->str, 1, span->len, w->fout);
+      putc ('"', w->fout);
+    }
+}
+
+static void
+print_shape_attr (dot_writer *w, gdl_shape shape)
+{
+  const gdl_span *span;
+
+  span = shape < GDL_SHAPE_MAX ? &shape_names[shape] : gdl_shape_span (shape);
+  print_key (w, "shape");
+  fwrite (span->str, 1, span->len, w->fout);
+}
+
+static void
+print_linestyle_attr (dot_writer *w, gdl_linestyle linestyle)
+{
+  const gdl_span *span;
+
+  span = (linestyle < GDL_LINESTYLE_MAX ? &linestyle_names[linestyle]
+          : gdl_linestyle_span (linestyle));
+  print_key (w, "style");
+  fwrite (span->str, 1, span->len, w->fout);
+}
+
+/* Print the attribute ATTR of OBJ if it is set on OBJ, or else on its
+   style as SATTR, with PRINT under the DOT name KEY.  KIND is NODE, EDGE
+   or GRAPH.  */
+
+#define PRINT_ATTR(W, OBJ, KIND, ATTR, SATTR, PRINT, KEY) \
+  do \
+    { \
+      if ((OBJ)->set_p[GDL_##KIND##_ATTR_##ATTR]) \
+        PRINT ((W), (KEY), (OBJ)->ATTR); \
+      else if ((OBJ)->style != NULL \
+               && (OBJ)->style->set_p[GDL_STYLE_ATTR_##SATTR]) \
+        PRINT ((W), (KEY), (OBJ)->style->SATTR); \
+    } \
+  while (0)
+
+/* Dump NODE.  */
+
+static void
+dump_node (dot_writer *w, gdl_node *node)
+{
+  gdl_style *style = node->style;
+
+  print_id (w, node->title);
+
+  PRINT_ATTR (w, node, NODE, bordercolor, bordercolor, print_color_attr,
+              "color");
+  PRINT_ATTR (w, node, NODE, borderwidth, borderwidth, print_int_attr,
+              "penwidth");
+  PRINT_ATTR (w, node, NODE, color, color, print_color_attr, "fillcolor");
+  if (node->set_p[GDL_NODE_ATTR_label])
+    print_string_attr (w, "label", node->label);
+  if (style != NULL && style->set_p[GDL_STYLE_ATTR_shape])
+    print_shape_attr (w, style->shape);
+
+  end_attrs (w);
+}
+
+/* Dump EDGE.  */
+
+static void
+dump_edge (dot_writer *w, gdl_edge *edge)
+{
+  gdl_style *style = edge->style;
+  char *source = edge->sourcename, *target = edge->targetname;
+  dot_cluster *head, *tail;
+
+  tail = find_cluster (w, source);
+  head = find_cluster (w, target);
+
+  if (edge->type == GDL_BACKEDGE)
+    {
+      print_id (w, head ? head->anchor : target);
+      fputs (" -> ", w->fout);
+      print_id (w, tail ? tail->anchor : source);
+      print_key (w, "dir");
+      fputs ("back", w->fout);
+      if (head)
+        {
+          print_key (w, "ltail");
+          fprintf (w->fout, "cluster_%d", head->id);
+        }
+      if (tail)
+        {
+          print_key (w, "lhead");
+          fprintf (w->fout, "cluster_%d", tail->id);
+        }
+    }
+  else
+    {
+      print_id (w, tail ? tail->anchor : source);
+      fputs (" -> ", w->fout);
+      print_id (w, head ? head->anchor : target);
+      if (tail)
+        {
+          print_key (w, "ltail");
+          fprintf (w->fout, "cluster_%d", tail->id);
+        }
+      if (head)
+        {
+          print_key (w, "lhead");
+          fprintf (w->fout, "cluster_%d", head->id);
+        }
+      if (edge->type != GDL_EDGE)
+        {
+          print_key (w, "constraint");
+          fputs ("false", w->fout);
+        }
+    }
+
+  if (style != NULL && style->set_p[GDL_STYLE_ATTR_color])
+    print_color_attr (w, "color", style->color);
+  if (edge->set_p[GDL_EDGE_ATTR_label])
+    print_string_attr (w, "label", edge->label);
+  if (edge->set_p[GDL_EDGE_ATTR_linestyle])
+    print_linestyle_attr (w, edge->linestyle);
+  else if (style != NULL && style->set_p[GDL_STYLE_ATTR_linestyle])
+    print_linestyle_attr (w, style->linestyle);
+  PRINT_ATTR (w, edge, EDGE, thickness, thickness, print_int_attr,
+              "penwidth");
+
+  end_attrs (w);
+}
+
+/* Dump the default node and edge attributes set by GRAPH.  */
+
+static void
+dump_defaults (dot_writer *w, gdl_graph *graph)
+{
+  begin_attrs (w, "node");
+  if (graph->parent == NULL)
+    {
+      /* The nodes of VCG are filled, and white by default.  */
+      print_key (w, "style");
+      fputs ("filled", w->fout);
+      if (!graph->set_p[GDL_GRAPH_ATTR_node_color])
+        print_color_attr (w, "fillcolor", GDL_COLOR_WHITE);
+    }
+  if (graph->set_p[GDL_GRAPH_ATTR_node_borderwidth])
+    print_int_attr (w, "penwidth", graph->node_borderwidth);
+  if (graph->set_p[GDL_GRAPH_ATTR_node_color])
+    print_color_attr (w, "fillcolor", graph->node_color);
+  if (graph->set_p[GDL_GRAPH_ATTR_node_shape])
+    print_shape_attr (w, graph->node_shape);
+  if (graph->set_p[GDL_GRAPH_ATTR_node_textcolor])
+    print_color_attr (w, "fontcolor", graph->node_textcolor);
+  end_attrs (w);
+
+  begin_attrs (w, "edge");
+  if (graph->set_p[GDL_GRAPH_ATTR_edge_color])
+    print_color_attr (w, "color", graph->edge_color);
+  if (graph->set_p[GDL_GRAPH_ATTR_edge_thickness])
+    print_int_attr (w, "penwidth", graph->edge_thickness);
+  end_attrs (w);
+}
+
+/* Dump the contents of GRAPH.  */
+
+static void
+dump_body (dot_writer *w, gdl_graph *graph)
+{
+  gdl_node *node;
+  gdl_graph *subgraph;
+  gdl_edge *edge;
+  dot_cluster *cluster;
+
+  dump_defaults (w, graph);
+
+  for (node = graph->node; node != NULL; node = node->next)
+    dump_node (w, node);
+
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    {
+      cluster = find_cluster (w, subgraph->title);
+      fprintf (w->fout, "subgraph cluster_%d {\n", cluster->id);
+
+      begin_attrs (w, "graph");
+      print_string_attr (w, "label",
+                         subgraph->set_p[GDL_GRAPH_ATTR_label]
+                         ? subgraph->label : subgraph->title);
+      if (subgraph->set_p[GDL_GRAPH_ATTR_color]
+          || (subgraph->style != NULL
+              && subgraph->style->set_p[GDL_STYLE_ATTR_color]))
+        {
+          PRINT_ATTR (w, subgraph, GRAPH, color, color, print_color_attr,
+                      "fillcolor");
+          print_key (w, "style");
+          fputs ("filled", w->fout);
+        }
+      end_attrs (w);
+
+      if (cluster->anchor == subgraph->title)
+        {
+          print_id (w, subgraph->title);
+          print_key (w, "style");
+          fputs ("invis", w->fout);
+          print_key (w, "shape");
+          fputs ("point", w->fout);
+          end_attrs (w);
+        }
+
+      dump_body (w, subgraph);
+      fputs ("}\n", w->fout);
+    }
+
+  for (edge = graph->edge; edge != NULL; edge = edge->next)
+    dump_edge (w, edge);
+}
+
+/* Dump GRAPH into the file in the DOT language, as a top graph.  */
+
+void
+gdl_dump_graph_dot (FILE *fout, gdl_graph *graph)
+{
+  dot_writer w;
+
+  w.fout = fout;
+  w.top = graph;
+  while (w.top->parent != NULL)
+    w.top = w.top->parent;
+  w.clusters = htab_create (64, dot_cluster_hash, dot_cluster_eq, free);
+  w.cluster_num = 0;
+  w.keyword = NULL;
+  w.attr_num = 0;
+  collect_clusters (&w, graph);
+
+  fputs ("digraph ", fout);
+  print_id (&w, graph->title);
+  fputs (" {\n", fout);
+
+  begin_attrs (&w, "graph");
+  print_key (&w, "compound");
+  fputs ("true", fout);
+  if (graph->set_p[GDL_GRAPH_ATTR_label])
+    print_string_attr (&w, "label", graph->label);
+  if (graph->set_p[GDL_GRAPH_ATTR_orientation])
+    {
+      print_key (&w, "rankdir");
+      if (!strcmp (graph->orientation, "left_to_right"))
+        fputs ("LR", fout);
+      else if (!strcmp (graph->orientation, "right_to_left"))
+        fputs ("RL", fout);
+      else if (!strcmp (graph->orientation, "bottom_to_top"))
+        fputs ("BT", fout);
+      else
+        fputs ("TB", fout);
+    }
+  end_attrs (&w);
+
+  dump_body (&w, graph);
+  fputs ("}\n", fout);
+
+  htab_delete (w.clusters);
+}
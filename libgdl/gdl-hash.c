@@ -0,0 +1,280 @@
+/* Structural hash of gdl graphs.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* The hash of a node or an edge covers its title, names, label, type and
+   the attributes in effect for it, i.e. the ones set on the object or
+   else on its style.  The hash of a graph covers its own attributes and
+   the hashes of its nodes, subgraphs and edges, the way a Merkle tree
+   does.  The child hashes are mixed and summed, so that the hash does not
+   depend on the order in which the objects were added.  Colors, shapes
+   and line styles are hashed by name, which keeps the hash stable across
+   processes even for the custom ones.
+
+   Two graphs with the same hash are dumped the same, up to the order of
+   the objects, with a very high probability.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gdl.h"
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+/* Hash the LEN bytes at P into H.  */
+
+static inline gdl_hashval
+hash_bytes (gdl_hashval h, const char *p, int len)
+{
+  int i;
+
+  for (i = 0; i < len; i++)
+    {
+      h ^= (unsigned char) p[i];
+      h *= FNV_PRIME;
+    }
+  return h;
+}
+
+/* Hash the integer VAL into H, independently of the byte order.  */
+
+static inline gdl_hashval
+hash_int (gdl_hashval h, int val)
+{
+  unsigned int u = val;
+  int i;
+
+  for (i = 0; i < 4; i++)
+    {
+      h ^= (u >> (i * 8)) & 0xff;
+      h *= FNV_PRIME;
+    }
+  return h;
+}
+
+/* Hash the string STR into H.  NULL is hashed apart from "".  */
+
+static inline gdl_hashval
+hash_string (gdl_hashval h, const char *str)
+{
+  if (str == NULL)
+    return hash_int (h, -1);
+
+  h = hash_int (h, strlen (str));
+  return hash_bytes (h, str, strlen (str));
+}
+
+/* Hash the hash VAL into H.  */
+
+static inline gdl_hashval
+hash_hashval (gdl_hashval h, gdl_hashval val)
+{
+  h = hash_int (h, val & 0xffffffff);
+  return hash_int (h, val >> 32);
+}
+
+static inline gdl_hashval
+hash_span (gdl_hashval h, const gdl_span *span)
+{
+  h = hash_int (h, span->len);
+  return hash_bytes (h, span->str, span->len);
+}
+
+/* Mix the bits of H, so that the sum of several hashes stays well
+   distributed.  */
+
+static inline gdl_hashval
+mix (gdl_hashval h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/* Hash the integer attribute ATTR of OBJ if it is set on OBJ, or else on
+   its style as SATTR.  KIND is NODE, EDGE or GRAPH.  */
+
+#define HASH_INT_ATTR(H, OBJ, KIND, ATTR, SATTR) \
+  do \
+    { \
+      if ((OBJ)->set_p[GDL_##KIND##_ATTR_##ATTR]) \
+        H = hash_int (hash_int (H, GDL_STYLE_ATTR_MAX \
+                                   + GDL_##KIND##_ATTR_##ATTR), \
+                      (OBJ)->ATTR); \
+      else if ((OBJ)->style != NULL \
+               && (OBJ)->style->set_p[GDL_STYLE_ATTR_##SATTR]) \
+        H = hash_int (hash_int (H, GDL_STYLE_ATTR_MAX \
+                                   + GDL_##KIND##_ATTR_##ATTR), \
+                      (OBJ)->style->SATTR); \
+    } \
+  while (0)
+
+/* Likewise, but for the attributes hashed by name, where SPAN_FUNC maps
+   the value to its name.  */
+
+#define HASH_SPAN_ATTR(H, OBJ, KIND, ATTR, SATTR, SPAN_FUNC) \
+  do \
+    { \
+      if ((OBJ)->set_p[GDL_##KIND##_ATTR_##ATTR]) \
+        H = hash_span (hash_int (H, GDL_STYLE_ATTR_MAX \
+                                    + GDL_##KIND##_ATTR_##ATTR), \
+                       SPAN_FUNC ((OBJ)->ATTR)); \
+      else if ((OBJ)->style != NULL \
+               && (OBJ)->style->set_p[GDL_STYLE_ATTR_##SATTR]) \
+        H = hash_span (hash_int (H, GDL_STYLE_ATTR_MAX \
+                                    + GDL_##KIND##_ATTR_##ATTR), \
+                       SPAN_FUNC ((OBJ)->style->SATTR)); \
+    } \
+  while (0)
+
+/* Hash an attribute which only a style may set.  */
+
+#define HASH_STYLE_ATTR(H, STYLE, SATTR, VAL) \
+  do \
+    { \
+      if ((STYLE) != NULL && (STYLE)->set_p[GDL_STYLE_ATTR_##SATTR]) \
+        H = VAL (hash_int (H, GDL_STYLE_ATTR_##SATTR), (STYLE)->SATTR); \
+    } \
+  while (0)
+
+/* Hash an attribute which only the object itself may set.  */
+
+#define HASH_OWN_ATTR(H, OBJ, KIND, ATTR, VAL) \
+  do \
+    { \
+      if ((OBJ)->set_p[GDL_##KIND##_ATTR_##ATTR]) \
+        H = VAL (hash_int (H, GDL_STYLE_ATTR_MAX \
+                              + GDL_##KIND##_ATTR_##ATTR), \
+                 (OBJ)->ATTR); \
+    } \
+  while (0)
+
+static inline gdl_hashval
+hash_color (gdl_hashval h, gdl_color color)
+{
+  return hash_span (h, gdl_color_span (color));
+}
+
+static inline gdl_hashval
+hash_shape (gdl_hashval h, gdl_shape shape)
+{
+  return hash_span (h, gdl_shape_span (shape));
+}
+
+/* Return the hash of NODE.  */
+
+gdl_hashval
+gdl_hash_node (gdl_node *node)
+{
+  gdl_hashval h = hash_int (FNV_OFFSET, 'n');
+
+  HASH_SPAN_ATTR (h, node, NODE, bordercolor, bordercolor, gdl_color_span);
+  HASH_INT_ATTR (h, node, NODE, borderwidth, borderwidth);
+  HASH_SPAN_ATTR (h, node, NODE, color, color, gdl_color_span);
+  HASH_OWN_ATTR (h, node, NODE, horizontal_order, hash_int);
+  HASH_OWN_ATTR (h, node, NODE, label, hash_string);
+  HASH_STYLE_ATTR (h, node->style, shape, hash_shape);
+  HASH_OWN_ATTR (h, node, NODE, title, hash_string);
+  HASH_OWN_ATTR (h, node, NODE, vertical_order, hash_int);
+
+  return mix (h);
+}
+
+/* Return the hash of EDGE.  */
+
+gdl_hashval
+gdl_hash_edge (gdl_edge *edge)
+{
+  gdl_hashval h = hash_int (FNV_OFFSET, 'e');
+
+  h = hash_int (h, edge->type);
+  HASH_STYLE_ATTR (h, edge->style, color, hash_color);
+  HASH_OWN_ATTR (h, edge, EDGE, label, hash_string);
+  HASH_SPAN_ATTR (h, edge, EDGE, linestyle, linestyle, gdl_linestyle_span);
+  HASH_OWN_ATTR (h, edge, EDGE, sourcename, hash_string);
+  HASH_OWN_ATTR (h, edge, EDGE, targetname, hash_string);
+  HASH_INT_ATTR (h, edge, EDGE, thickness, thickness);
+
+  return mix (h);
+}
+
+/* Return the hash of GRAPH, including all of its nodes, edges and
+   subgraphs.  */
+
+gdl_hashval
+gdl_hash_graph (gdl_graph *graph)
+{
+  int i;
+  gdl_hashval h = hash_int (FNV_OFFSET, 'g');
+  gdl_hashval nodes = 0, edges = 0, subgraphs = 0;
+  gdl_node *node;
+  gdl_edge *edge;
+  gdl_graph *subgraph;
+
+  if (graph->set_p[GDL_GRAPH_ATTR_colorentry])
+    for (i = 0; i < 256; i++)
+      if (graph->colorentry_set_p[i])
+        {
+          h = hash_int (h, i);
+          h = hash_int (h, graph->colorentry[i][0]);
+          h = hash_int (h, graph->colorentry[i][1]);
+          h = hash_int (h, graph->colorentry[i][2]);
+        }
+
+  HASH_STYLE_ATTR (h, graph->style, bordercolor, hash_color);
+  HASH_STYLE_ATTR (h, graph->style, borderwidth, hash_int);
+  HASH_SPAN_ATTR (h, graph, GRAPH, color, color, gdl_color_span);
+  HASH_INT_ATTR (h, graph, GRAPH, folding, folding);
+  HASH_OWN_ATTR (h, graph, GRAPH, horizontal_order, hash_int);
+  HASH_OWN_ATTR (h, graph, GRAPH, label, hash_string);
+  HASH_OWN_ATTR (h, graph, GRAPH, layout_algorithm, hash_string);
+  HASH_OWN_ATTR (h, graph, GRAPH, near_edges, hash_string);
+  HASH_OWN_ATTR (h, graph, GRAPH, node_alignment, hash_string);
+  HASH_OWN_ATTR (h, graph, GRAPH, orientation, hash_string);
+  HASH_OWN_ATTR (h, graph, GRAPH, port_sharing, hash_string);
+  HASH_SPAN_ATTR (h, graph, GRAPH, shape, shape, gdl_shape_span);
+  HASH_OWN_ATTR (h, graph, GRAPH, splines, hash_string);
+  HASH_OWN_ATTR (h, graph, GRAPH, title, hash_string);
+  HASH_OWN_ATTR (h, graph, GRAPH, vertical_order, hash_int);
+  HASH_OWN_ATTR (h, graph, GRAPH, xspace, hash_int);
+  HASH_OWN_ATTR (h, graph, GRAPH, yspace, hash_int);
+  HASH_OWN_ATTR (h, graph, GRAPH, node_borderwidth, hash_int);
+  HASH_OWN_ATTR (h, graph, GRAPH, node_color, hash_color);
+  HASH_OWN_ATTR (h, graph, GRAPH, node_shape, hash_shape);
+  HASH_OWN_ATTR (h, graph, GRAPH, node_textcolor, hash_color);
+  HASH_OWN_ATTR (h, graph, GRAPH, edge_color, hash_color);
+  HASH_OWN_ATTR (h, graph, GRAPH, edge_thickness, hash_int);
+
+  for (node = gdl_get_graph_node (graph); node; node = node->next)
+    nodes += gdl_hash_node (node);
+  for (subgraph = gdl_get_graph_subgraph (graph); subgraph;
+       subgraph = subgraph->next)
+    subgraphs += gdl_hash_graph (subgraph);
+  for (edge = gdl_get_graph_edge (graph); edge; edge = edge->next)
+    edges += gdl_hash_edge (edge);
+
+  /* Hash the sums apart, so that a node can not stand in for an edge.  */
+  h = hash_hashval (h, nodes);
+  h = hash_hashval (h, subgraphs);
+  h = hash_hashval (h, edges);
+
+  return mix (h);
+}
@@ -0,0 +1,306 @@
+/* Dump gdl graphs as JSON Lines.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* Each graph, node and edge is written as a flat JSON object on a line of
+   its own, so that the lines can be split and loaded in any order.  The
+   graphs and nodes are numbered in one sequence, in the order of a
+   preorder walk, and the objects refer to each other by these numbers:
+
+     {"type":"graph","id":0,"parent":null,"title":"top graph"}
+     {"type":"node","id":1,"graph":0,"title":"a","label":"..."}
+     {"type":"edge","id":0,"graph":0,"kind":"edge","source":1,"target":2}
+
+   The edges are numbered in a sequence of their own.  The source or
+   target of an edge is null if no graph or node has its title, which
+   are expected to be unique as in gdl; it is the first object with the
+   title otherwise, but each object still has its own number.  Only the attributes set on the
+   object or on its style are written.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libiberty.h>
+#include <hashtab.h>
+
+#include "gdl.h"
+
+/* The number of a graph or a node, found by its title.  */
+
+typedef struct
+{
+  char *title;
+  int id;
+} json_id;
+
+typedef struct
+{
+  FILE *fout;
+  htab_t ids;
+  int id_num;
+  /* The number of the next graph or node to dump, which follows the
+     order of collect_ids.  */
+  int object_num;
+  int edge_num;
+} json_writer;
+
+static hashval_t
+json_id_hash (const void *p)
+{
+  return htab_hash_string (((const json_id *) p)->title);
+}
+
+static int
+json_id_eq (const void *p1, const void *p2)
+{
+  return strcmp (((const json_id *) p1)->title,
+                 ((const json_id *) p2)->title) == 0;
+}
+
+/* Number TITLE.  The first one wins if the titles are not unique.  */
+
+static void
+add_id (json_writer *w, char *title)
+{
+  json_id *id;
+  void **slot;
+
+  id = XNEW (json_id);
+  id->title = title;
+  id->id = w->id_num++;
+  slot = htab_find_slot (w->ids, id, INSERT);
+  if (*slot != NULL)
+    free (id);
+  else
+    *slot = id;
+}
+
+/* Return the number of TITLE, or -1.  */
+
+static int
+find_id (json_writer *w, char *title)
+{
+  json_id key, *id;
+
+  key.title = title;
+  id = (json_id *) htab_find (w->ids, &key);
+  return id ? id->id : -1;
+}
+
+/* Number GRAPH and the graphs and nodes in it.  */
+
+static void
+collect_ids (json_writer *w, gdl_graph *graph)
+{
+  gdl_node *node;
+  gdl_graph *subgraph;
+
+  add_id (w, graph->title);
+  for (node = graph->node; node != NULL; node = node->next)
+    add_id (w, node->title);
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    collect_ids (w, subgraph);
+}
+
+/* Print STR as a JSON string.  The runs of characters which need no
+   escape are written as a whole.  */
+
+static void
+print_json_string (FILE *fout, const char *str)
+{
+  const unsigned char *p = (const unsigned char *) str, *run = p;
+
+  putc ('"', fout);
+  for (; *p; p++)
+    {
+      if (*p >= 0x20 && *p != '"' && *p != '\\')
+        continue;
+
+      fwrite (run, 1, p - run, fout);
+      run = p + 1;
+      switch (*p)
+        {
+        case '"':
+          fputs ("\\\"", fout);
+          break;
+        case '\\':
+          fputs ("\\\\", fout);
+          break;
+        case '\n':
+          fputs ("\\n", fout);
+          break;
+        case '\t':
+          fputs ("\\t", fout);
+          break;
+        default:
+          fprintf (fout, "\\u%04x", *p);
+          break;
+        }
+    }
+  fwrite (run, 1, p - run, fout);
+  putc ('"', fout);
+}
+
+/* Print the member KEY, which must need no escape, with the value
+   STR.  */
+
+static void
+print_string_member (FILE *fout, const char *key, const char *str)
+{
+  fprintf (fout, ",\"%s\":", key);
+  print_json_string (fout, str);
+}
+
+static void
+print_span_member (FILE *fout, const char *key, const gdl_span *span)
+{
+  fprintf (fout, ",\"%s\":\"", key);
+  fwrite (span->str, 1, span->len, fout);
+  putc ('"', fout);
+}
+
+static void
+print_id_member (FILE *fout, const char *key, int id)
+{
+  if (id < 0)
+    fprintf (fout, ",\"%s\":null", key);
+  else
+    fprintf (fout, ",\"%s\":%d", key, id);
+}
+
+/* Print the member for the attribute ATTR of OBJ if it is set on OBJ, or
+   else on its style as SATTR.  KIND is NODE, EDGE or GRAPH.  */
+
+#define PRINT_INT_MEMBER(FOUT, OBJ, KIND, ATTR, SATTR) \
+  do \
+    { \
+      if ((OBJ)->set_p[GDL_##KIND##_ATTR_##ATTR]) \
+        fprintf ((FOUT), ",\"" #ATTR "\":%d", (OBJ)->ATTR); \
+      else if ((OBJ)->style != NULL \
+               && (OBJ)->style->set_p[GDL_STYLE_ATTR_##SATTR]) \
+        fprintf ((FOUT), ",\"" #ATTR "\":%d", (OBJ)->style->SATTR); \
+    } \
+  while (0)
+
+#define PRINT_SPAN_MEMBER(FOUT, OBJ, KIND, ATTR, SATTR, SPAN_FUNC) \
+  do \
+    { \
+      if ((OBJ)->set_p[GDL_##KIND##_ATTR_##ATTR]) \
+        print_span_member ((FOUT), #ATTR, SPAN_FUNC ((OBJ)->ATTR)); \
+      else if ((OBJ)->style != NULL \
+               && (OBJ)->style->set_p[GDL_STYLE_ATTR_##SATTR]) \
+        print_span_member ((FOUT), #ATTR, \
+                           SPAN_FUNC ((OBJ)->style->SATTR)); \
+    } \
+  while (0)
+
+/* Dump NODE, which belongs to the graph numbered GRAPH_ID.  */
+
+static void
+dump_node (json_writer *w, gdl_node *node, int graph_id)
+{
+  FILE *fout = w->fout;
+
+  fprintf (fout, "{\"type\":\"node\",\"id\":%d,\"graph\":%d",
+           w->object_num++, graph_id);
+  print_string_member (fout, "title", node->title);
+  if (node->set_p[GDL_NODE_ATTR_label])
+    print_string_member (fout, "label", node->label);
+  PRINT_SPAN_MEMBER (fout, node, NODE, bordercolor, bordercolor,
+                     gdl_color_span);
+  PRINT_INT_MEMBER (fout, node, NODE, borderwidth, borderwidth);
+  PRINT_SPAN_MEMBER (fout, node, NODE, color, color, gdl_color_span);
+  if (node->style != NULL && node->style->set_p[GDL_STYLE_ATTR_shape])
+    print_span_member (fout, "shape", gdl_shape_span (node->style->shape));
+  if (node->set_p[GDL_NODE_ATTR_horizontal_order])
+    fprintf (fout, ",\"horizontal_order\":%d", node->horizontal_order);
+  if (node->set_p[GDL_NODE_ATTR_vertical_order])
+    fprintf (fout, ",\"vertical_order\":%d", node->vertical_order);
+  fputs ("}\n", fout);
+}
+
+/* Dump EDGE, which belongs to the graph numbered GRAPH_ID.  */
+
+static void
+dump_edge (json_writer *w, gdl_edge *edge, int graph_id)
+{
+  FILE *fout = w->fout;
+
+  fprintf (fout, "{\"type\":\"edge\",\"id\":%d,\"graph\":%d",
+           w->edge_num++, graph_id);
+  print_span_member (fout, "kind", gdl_edge_type_span (edge->type));
+  print_id_member (fout, "source", find_id (w, edge->sourcename));
+  print_id_member (fout, "target", find_id (w, edge->targetname));
+  if (edge->set_p[GDL_EDGE_ATTR_label])
+    print_string_member (fout, "label", edge->label);
+  if (edge->style != NULL && edge->style->set_p[GDL_STYLE_ATTR_color])
+    print_span_member (fout, "color", gdl_color_span (edge->style->color));
+  PRINT_SPAN_MEMBER (fout, edge, EDGE, linestyle, linestyle,
+                     gdl_linestyle_span);
+  PRINT_INT_MEMBER (fout, edge, EDGE, thickness, thickness);
+  fputs ("}\n", fout);
+}
+
+/* Dump GRAPH, which belongs to the graph numbered PARENT_ID, and the
+   objects in it.  */
+
+static void
+dump_graph (json_writer *w, gdl_graph *graph, int parent_id)
+{
+  FILE *fout = w->fout;
+  int id = w->object_num++;
+  gdl_node *node;
+  gdl_graph *subgraph;
+  gdl_edge *edge;
+
+  fprintf (fout, "{\"type\":\"graph\",\"id\":%d", id);
+  print_id_member (fout, "parent", parent_id);
+  print_string_member (fout, "title", graph->title);
+  if (graph->set_p[GDL_GRAPH_ATTR_label])
+    print_string_member (fout, "label", graph->label);
+  PRINT_SPAN_MEMBER (fout, graph, GRAPH, color, color, gdl_color_span);
+  PRINT_INT_MEMBER (fout, graph, GRAPH, folding, folding);
+  fputs ("}\n", fout);
+
+  for (node = graph->node; node != NULL; node = node->next)
+    dump_node (w, node, id);
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    dump_graph (w, subgraph, id);
+  for (edge = graph->edge; edge != NULL; edge = edge->next)
+    dump_edge (w, edge, id);
+}
+
+/* Dump GRAPH into the file as JSON Lines, as a top graph.  */
+
+void
+gdl_dump_graph_jsonl (FILE *fout, gdl_graph *graph)
+{
+  json_writer w;
+
+  w.fout = fout;
+  w.ids = htab_create (1024, json_id_hash, json_id_eq, free);
+  w.id_num = 0;
+  w.object_num = 0;
+  w.edge_num = 0;
+  collect_ids (&w, graph);
+
+  dump_graph (&w, graph, -1);
+
+  htab_delete (w.ids);
+}
@@ -0,0 +1,582 @@
+/* Layered layout of gdl graphs.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* The layout works on the units of a graph, i.e. its direct nodes and
+   subgraphs.  An edge between the objects inside two units, at any
+   depth, is an edge between the units.  The steps are
+
+     1. break the cycles by reversing the edges which close a cycle in a
+        depth first search, where the backedges are reversed up front,
+     2. assign each unit the longest path from a source as its level,
+     3. order the units of each level by the barycenter of their
+        neighbors in the adjacent levels, sweeping down and up a bounded
+        number of times.
+
+   The levels and the positions are set as vertical_order and
+   horizontal_order, so that the viewer can skip its own layout phases.
+   Everything but the sorting is linear.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <error.h>
+#include <libiberty.h>
+#include <hashtab.h>
+
+#include "gdl.h"
+
+/* A title in the graph and the unit it belongs to.  */
+
+typedef struct
+{
+  char *title;
+  int unit;
+} title_entry;
+
+/* A unit of a level being ordered, with its sort keys.  */
+
+typedef struct
+{
+  double barycenter;
+  int pos;
+  int unit;
+} unit_key;
+
+/* The state of the layout of a graph.  */
+
+typedef struct
+{
+  /* The units.  A unit is either a node or a subgraph.  */
+  int unit_num;
+  gdl_node **unit_node;
+  gdl_graph **unit_graph;
+
+  /* The titles of the units and the objects inside them.  */
+  htab_t title_table;
+  title_entry *titles;
+  int title_num;
+
+  /* The edges between different units.  */
+  int edge_num;
+  int *sources;
+  int *targets;
+
+  /* The successors and the predecessors in compressed row form.  */
+  int *succ_offsets;
+  int *succs;
+  int *pred_offsets;
+  int *preds;
+
+  /* The level and the position in the level of each unit.  */
+  int *level;
+  int *pos;
+  unit_key *keys;
+
+  /* The units of each level, in order.  */
+  int level_num;
+  int *level_offsets;
+  int *level_units;
+} layout;
+
+static hashval_t
+title_entry_hash (const void *p)
+{
+  return htab_hash_string (((const title_entry *) p)->title);
+}
+
+static int
+title_entry_eq (const void *p1, const void *p2)
+{
+  return !strcmp (((const title_entry *) p1)->title,
+                  ((const title_entry *) p2)->title);
+}
+
+/* Map TITLE to UNIT.  The first mapping of a title wins.  */
+
+static void
+add_title (layout *l, char *title, int unit)
+{
+  title_entry *entry;
+  void **slot;
+
+  entry = &l->titles[l->title_num];
+  entry->title = title;
+  entry->unit = unit;
+
+  slot = htab_find_slot (l->title_table, entry, INSERT);
+  if (*slot == NULL)
+    {
+      *slot = entry;
+      l->title_num++;
+    }
+}
+
+/* Return the unit of TITLE, or -1 if it is not in the graph.  */
+
+static int
+find_title (layout *l, char *title)
+{
+  title_entry key, *entry;
+
+  key.title = title;
+  entry = (title_entry *) htab_find (l->title_table, &key);
+
+  return entry ? entry->unit : -1;
+}
+
+/* Count the nodes, the subgraphs and the edges in GRAPH at any depth.  */
+
+static void
+count_objects (gdl_graph *graph, int *object_num, int *edge_num)
+{
+  gdl_node *node;
+  gdl_edge *edge;
+  gdl_graph *subgraph;
+
+  for (node = gdl_get_graph_node (graph); node; node = node->next)
+    (*object_num)++;
+
+  for (edge = gdl_get_graph_edge (graph); edge; edge = edge->next)
+    (*edge_num)++;
+
+  for (subgraph = gdl_get_graph_subgraph (graph); subgraph;
+       subgraph = subgraph->next)
+    {
+      (*object_num)++;
+      count_objects (subgraph, object_num, edge_num);
+    }
+}
+
+/* Map the titles of the objects inside GRAPH to UNIT.  */
+
+static void
+add_inner_titles (layout *l, gdl_graph *graph, int unit)
+{
+  gdl_node *node;
+  gdl_graph *subgraph;
+
+  for (node = gdl_get_graph_node (graph); node; node = node->next)
+    add_title (l, gdl_get_node_title (node), unit);
+
+  for (subgraph = gdl_get_graph_subgraph (graph); subgraph;
+       subgraph = subgraph->next)
+    {
+      add_title (l, gdl_get_graph_title (subgraph), unit);
+      add_inner_titles (l, subgraph, unit);
+    }
+}
+
+/* Collect the edges between different units in GRAPH at any depth.  A
+   backedge is reversed.  */
+
+static void
+collect_edges (layout *l, gdl_graph *graph)
+{
+  gdl_edge *edge;
+  gdl_graph *subgraph;
+  int source, target;
+
+  for (edge = gdl_get_graph_edge (graph); edge; edge = edge->next)
+    {
+      source = find_title (l, gdl_get_edge_sourcename (edge));
+      target = find_title (l, gdl_get_edge_targetname (edge));
+      if (source < 0 || target < 0 || source == target)
+        continue;
+
+      if (gdl_get_edge_type (edge) == GDL_BACKEDGE)
+        {
+          l->sources[l->edge_num] = target;
+          l->targets[l->edge_num] = source;
+        }
+      else
+        {
+          l->sources[l->edge_num] = source;
+          l->targets[l->edge_num] = target;
+        }
+      l->edge_num++;
+    }
+
+  for (subgraph = gdl_get_graph_subgraph (graph); subgraph;
+       subgraph = subgraph->next)
+    collect_edges (l, subgraph);
+}
+
+/* Build the compressed rows in OFFSETS and COLUMNS from the edges, which
+   are from ROWS[I] to COLS[I].  */
+
+static void
+build_rows (layout *l, int *rows, int *cols, int *offsets, int *columns)
+{
+  int *next;
+  int i;
+
+  memset (offsets, 0, (l->unit_num + 1) * sizeof (int));
+  for (i = 0; i < l->edge_num; i++)
+    offsets[rows[i] + 1]++;
+  for (i = 0; i < l->unit_num; i++)
+    offsets[i + 1] += offsets[i];
+
+  next = XNEWVEC (int, l->unit_num + 1);
+  memcpy (next, offsets, (l->unit_num + 1) * sizeof (int));
+  for (i = 0; i < l->edge_num; i++)
+    columns[next[rows[i]]++] = cols[i];
+
+  free (next);
+}
+
+/* Break the cycles by reversing the edges which point to a unit on the
+   stack of a depth first search.  */
+
+static void
+break_cycles (layout *l)
+{
+  int *state, *stack, *next;
+  int *offsets, *edge_ids, *out_edges;
+  int i, sp, u, v, e, tmp;
+
+  offsets = XNEWVEC (int, l->unit_num + 1);
+  edge_ids = XNEWVEC (int, l->edge_num);
+  out_edges = XNEWVEC (int, l->edge_num);
+  state = XCNEWVEC (int, l->unit_num);
+  stack = XNEWVEC (int, l->unit_num);
+  next = XNEWVEC (int, l->unit_num);
+
+  /* The out edges of each unit, by edge index.  */
+  for (e = 0; e < l->edge_num; e++)
+    edge_ids[e] = e;
+  build_rows (l, l->sources, edge_ids, offsets, out_edges);
+
+  /* State 1 means on the stack, 2 means finished.  */
+  for (i = 0; i < l->unit_num; i++)
+    {
+      if (state[i])
+        continue;
+
+      sp = 0;
+      stack[sp++] = i;
+      state[i] = 1;
+      next[i] = offsets[i];
+      while (sp > 0)
+        {
+          u = stack[sp - 1];
+          if (next[u] == offsets[u + 1])
+            {
+              state[u] = 2;
+              sp--;
+              continue;
+            }
+
+          e = out_edges[next[u]++];
+          v = l->targets[e];
+          if (state[v] == 1)
+            {
+              tmp = l->sources[e];
+              l->sources[e] = l->targets[e];
+              l->targets[e] = tmp;
+            }
+          else if (state[v] == 0)
+            {
+              state[v] = 1;
+              next[v] = offsets[v];
+              stack[sp++] = v;
+            }
+        }
+    }
+
+  free (offsets);
+  free (edge_ids);
+  free (out_edges);
+  free (state);
+  free (stack);
+  free (next);
+}
+
+/* Assign each unit the longest path from a source as its level, in a
+   topological order.  */
+
+static void
+assign_levels (layout *l)
+{
+  int *in_degree, *queue;
+  int head, tail, i, j, u, v;
+
+  in_degree = XCNEWVEC (int, l->unit_num);
+  queue = XNEWVEC (int, l->unit_num);
+
+  for (i = 0; i < l->edge_num; i++)
+    in_degree[l->targets[i]]++;
+
+  head = tail = 0;
+  for (i = 0; i < l->unit_num; i++)
+    {
+      l->level[i] = 0;
+      if (in_degree[i] == 0)
+        queue[tail++] = i;
+    }
+
+  l->level_num = l->unit_num > 0 ? 1 : 0;
+  while (head < tail)
+    {
+      u = queue[head++];
+      for (j = l->succ_offsets[u]; j < l->succ_offsets[u + 1]; j++)
+        {
+          v = l->succs[j];
+          if (l->level[v] < l->level[u] + 1)
+            {
+              l->level[v] = l->level[u] + 1;
+              if (l->level_num < l->level[v] + 1)
+                l->level_num = l->level[v] + 1;
+            }
+          if (--in_degree[v] == 0)
+            queue[tail++] = v;
+        }
+    }
+
+  /* The graph is acyclic after break_cycles.  */
+  assert (tail == l->unit_num);
+
+  free (in_degree);
+  free (queue);
+}
+
+/* Group the units by level, keeping their order in the graph.  */
+
+static void
+group_levels (layout *l)
+{
+  int *next;
+  int i;
+
+  l->level_offsets = XCNEWVEC (int, l->level_num + 1);
+  l->level_units = XNEWVEC (int, l->unit_num);
+  next = XNEWVEC (int, l->level_num);
+
+  for (i = 0; i < l->unit_num; i++)
+    l->level_offsets[l->level[i] + 1]++;
+  for (i = 0; i < l->level_num; i++)
+    l->level_offsets[i + 1] += l->level_offsets[i];
+  memcpy (next, l->level_offsets, l->level_num * sizeof (int));
+
+  for (i = 0; i < l->unit_num; i++)
+    {
+      l->pos[i] = next[l->level[i]] - l->level_offsets[l->level[i]];
+      l->level_units[next[l->level[i]]++] = i;
+    }
+
+  free (next);
+}
+
+/* Compare two unit_keys by their barycenters.  The keys are sorted in
+   place, so that layouts can run in several threads at once.  */
+
+static int
+compare_barycenter (const void *p1, const void *p2)
+{
+  const unit_key *k1 = (const unit_key *) p1;
+  const unit_key *k2 = (const unit_key *) p2;
+
+  if (k1->barycenter < k2->barycenter)
+    return -1;
+  if (k1->barycenter > k2->barycenter)
+    return 1;
+
+  /* Keep the current order for the ties.  */
+  return k1->pos - k2->pos;
+}
+
+/* Return the relative position of unit U in its level, in [0, 1].  */
+
+static inline double
+relative_pos (layout *l, int u)
+{
+  int size;
+
+  size = l->level_offsets[l->level[u] + 1] - l->level_offsets[l->level[u]];
+  return (l->pos[u] + 0.5) / size;
+}
+
+/* Reorder the units of LEVEL by the barycenter of their neighbors in
+   OFFSETS and NEIGHBORS.  A unit without neighbors keeps its place.  */
+
+static void
+order_level (layout *l, int level, int *offsets, int *neighbors)
+{
+  int *units, num, i, j, u;
+  double sum;
+
+  units = l->level_units + l->level_offsets[level];
+  num = l->level_offsets[level + 1] - l->level_offsets[level];
+
+  for (i = 0; i < num; i++)
+    {
+      u = units[i];
+      sum = 0;
+      for (j = offsets[u]; j < offsets[u + 1]; j++)
+        sum += relative_pos (l, neighbors[j]);
+
+      if (offsets[u + 1] > offsets[u])
+        l->keys[i].barycenter = sum / (offsets[u + 1] - offsets[u]);
+      else
+        l->keys[i].barycenter = relative_pos (l, u);
+      l->keys[i].pos = l->pos[u];
+      l->keys[i].unit = u;
+    }
+
+  qsort (l->keys, num, sizeof (unit_key), compare_barycenter);
+
+  for (i = 0; i < num; i++)
+    {
+      units[i] = l->keys[i].unit;
+      l->pos[units[i]] = i;
+    }
+}
+
+/* Reduce the crossings by MAX_ITERATIONS down and up sweeps.  */
+
+static void
+reduce_crossings (layout *l, int max_iterations)
+{
+  int i, level;
+
+  for (i = 0; i < max_iterations; i++)
+    {
+      for (level = 1; level < l->level_num; level++)
+        order_level (l, level, l->pred_offsets, l->preds);
+
+      for (level = l->level_num - 2; level >= 0; level--)
+        order_level (l, level, l->succ_offsets, l->succs);
+    }
+}
+
+/* Set the vertical and horizontal order of the node in GRAPH if it is
+   the only object in it, e.g. the node of a basic block, so that it keeps
+   the place of GRAPH when unfolded.  The nodes of a bigger graph are left
+   to the viewer, which would stack them on one another otherwise.  The
+   objects of a shared graph are not changed, see gdl_new_graph_shared,
+   only the graph showing them is.  */
+
+static void
+set_inner_order (gdl_graph *graph, int level, int pos)
+{
+  gdl_node *node = gdl_get_graph_node (graph);
+
+  if (graph->shared != NULL || node == NULL || node->next != NULL
+      || gdl_get_graph_subgraph (graph) != NULL)
+    return;
+
+  gdl_set_node_vertical_order (node, level);
+  gdl_set_node_horizontal_order (node, pos);
+}
+
+/* Lay out GRAPH, i.e. set the vertical and horizontal order of its nodes
+   and subgraphs, and of the node inside the subgraphs with a single one,
+   see set_inner_order.  MAX_ITERATIONS
+   bounds the sweeps of the crossing reduction, 0 skips it.  Return the
+   number of levels.  */
+
+int
+gdl_layout_graph (gdl_graph *graph, int max_iterations)
+{
+  layout l;
+  gdl_node *node;
+  gdl_graph *subgraph;
+  int object_num, edge_num, i, u;
+
+  memset (&l, 0, sizeof (l));
+
+  /* Collect the units and the titles.  */
+  object_num = edge_num = 0;
+  count_objects (graph, &object_num, &edge_num);
+
+  l.unit_node = XCNEWVEC (gdl_node *, object_num);
+  l.unit_graph = XCNEWVEC (gdl_graph *, object_num);
+  l.titles = XNEWVEC (title_entry, object_num);
+  l.title_table = htab_create (object_num, title_entry_hash, title_entry_eq,
+                               NULL);
+
+  for (node = gdl_get_graph_node (graph); node; node = node->next)
+    {
+      l.unit_node[l.unit_num] = node;
+      add_title (&l, gdl_get_node_title (node), l.unit_num++);
+    }
+
+  for (subgraph = gdl_get_graph_subgraph (graph); subgraph;
+       subgraph = subgraph->next)
+    {
+      l.unit_graph[l.unit_num] = subgraph;
+      add_title (&l, gdl_get_graph_title (subgraph), l.unit_num);
+      add_inner_titles (&l, subgraph, l.unit_num++);
+    }
+
+  /* Collect the edges and make them acyclic.  */
+  l.sources = XNEWVEC (int, edge_num);
+  l.targets = XNEWVEC (int, edge_num);
+  collect_edges (&l, graph);
+  break_cycles (&l);
+
+  l.succ_offsets = XNEWVEC (int, l.unit_num + 1);
+  l.succs = XNEWVEC (int, l.edge_num);
+  l.pred_offsets = XNEWVEC (int, l.unit_num + 1);
+  l.preds = XNEWVEC (int, l.edge_num);
+  build_rows (&l, l.sources, l.targets, l.succ_offsets, l.succs);
+  build_rows (&l, l.targets, l.sources, l.pred_offsets, l.preds);
+
+  /* Assign the levels and the positions.  */
+  l.level = XNEWVEC (int, l.unit_num);
+  l.pos = XNEWVEC (int, l.unit_num);
+  l.keys = XNEWVEC (unit_key, l.unit_num);
+  assign_levels (&l);
+  group_levels (&l);
+  reduce_crossings (&l, max_iterations);
+
+  for (u = 0; u < l.unit_num; u++)
+    {
+      if (l.unit_node[u])
+        {
+          gdl_set_node_vertical_order (l.unit_node[u], l.level[u]);
+          gdl_set_node_horizontal_order (l.unit_node[u], l.pos[u]);
+        }
+      else
+        {
+          gdl_set_graph_vertical_order (l.unit_graph[u], l.level[u]);
+          gdl_set_graph_horizontal_order (l.unit_graph[u], l.pos[u]);
+          set_inner_order (l.unit_graph[u], l.level[u], l.pos[u]);
+        }
+    }
+
+  i = l.level_num;
+
+  htab_delete (l.title_table);
+  free (l.unit_node);
+  free (l.unit_graph);
+  free (l.titles);
+  free (l.sources);
+  free (l.targets);
+  free (l.succ_offsets);
+  free (l.succs);
+  free (l.pred_offsets);
+  free (l.preds);
+  free (l.level);
+  free (l.pos);
+  free (l.keys);
+  free (l.level_offsets);
+  free (l.level_units);
+
+  return i;
+}
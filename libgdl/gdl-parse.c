@@ -0,0 +1,764 @@
+/* Streaming parser of gdl files.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* The parser reads the input in blocks and keeps only the record being
+   built, i.e. a node, an edge or the leading attributes of a graph.  The
+   keys and values of the record are stored one after another in a single
+   buffer, which is reused for the next record.
+
+   The grammar accepted is
+
+     graph:      "graph" ":" "{" item* "}"
+     item:       key ":" value* | "graph" ":" "{" item* "}"
+                 | ("node" | edge-type) ":" "{" (key ":" value*)* "}"
+     key:        word | ("colorentry" | "classname" | "infoname") word
+
+   where a value is a word or a quoted string, and the comments are the
+   C and C++ ones.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libiberty.h>
+
+#include "gdl.h"
+
+#define BLOCK_SIZE 65536
+
+enum token
+{
+  TOKEN_EOF,
+  TOKEN_ERROR,
+  TOKEN_LBRACE,
+  TOKEN_RBRACE,
+  /* A word followed by ':'.  */
+  TOKEN_KEY,
+  TOKEN_WORD,
+  TOKEN_STRING
+};
+
+/* The kinds of the object whose items are being parsed.  */
+
+enum object
+{
+  OBJECT_GRAPH,
+  OBJECT_NODE,
+  OBJECT_EDGE
+};
+
+typedef struct
+{
+  FILE *fin;
+  char *block;
+  int pos;
+  int len;
+  int line;
+
+  /* The text of the last word, key or string.  */
+  char *text;
+  int text_len;
+  int text_size;
+
+  /* The keys and values of the record being built, and where each of
+     them starts.  */
+  char *pool;
+  int pool_len;
+  int pool_size;
+  int *key_pos;
+  int *value_pos;
+  int attr_size;
+
+  gdl_record record;
+  /* The value is 1 if a graph has begun but the record for it has not
+     been sent yet.  */
+  int pending_p;
+
+  gdl_record_func func;
+  void *data;
+} parser;
+
+/* Return the next character of the input, or EOF.  */
+
+static inline int
+next_char (parser *p)
+{
+  if (p->pos == p->len)
+    {
+      p->len = fread (p->block, 1, BLOCK_SIZE, p->fin);
+      p->pos = 0;
+      if (p->len == 0)
+        return EOF;
+    }
+  return (unsigned char) p->block[p->pos++];
+}
+
+/* Return the next character of the input without consuming it.  */
+
+static inline int
+peek_char (parser *p)
+{
+  int c = next_char (p);
+
+  if (c != EOF)
+    p->pos--;
+  return c;
+}
+
+static inline void
+add_text (parser *p, int c)
+{
+  if (p->text_len == p->text_size)
+    {
+      p->text_size = p->text_size * 2;
+      p->text = XRESIZEVEC (char, p->text, p->text_size);
+    }
+  p->text[p->text_len++] = c;
+}
+
+/* Skip the white spaces and comments.  Return 0 at the end of a comment
+   which is not terminated, 1 otherwise.  */
+
+static int
+skip_blanks (parser *p)
+{
+  int c;
+
+  while (1)
+    {
+      c = peek_char (p);
+      if (c == '\n')
+        p->line++;
+      if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f')
+        {
+          next_char (p);
+          continue;
+        }
+      if (c != '/')
+        return 1;
+
+      next_char (p);
+      c = next_char (p);
+      if (c == '/')
+        {
+          while ((c = next_char (p)) != EOF && c != '\n')
+            ;
+          p->line++;
+        }
+      else if (c == '*')
+        {
+          int prev = 0;
+
+          while ((c = next_char (p)) != EOF && !(prev == '*' && c == '/'))
+            {
+              if (c == '\n')
+                p->line++;
+              prev = c;
+            }
+          if (c == EOF)
+            return 0;
+        }
+      else
+        return 0;
+    }
+}
+
+/* Read the next token.  A '\' in a string escapes the following '"', and
+   is kept as it is otherwise, the way the writer does.  */
+
+static enum token
+next_token (parser *p)
+{
+  int c;
+
+  if (!skip_blanks (p))
+    return TOKEN_ERROR;
+
+  p->text_len = 0;
+  c = next_char (p);
+  switch (c)
+    {
+    case EOF:
+      return TOKEN_EOF;
+    case '{':
+      return TOKEN_LBRACE;
+    case '}':
+      return TOKEN_RBRACE;
+    case ':':
+      return TOKEN_ERROR;
+    case '"':
+      while ((c = next_char (p)) != '"')
+        {
+          if (c == EOF)
+            return TOKEN_ERROR;
+          if (c == '\n')
+            p->line++;
+          if (c == '\\')
+            {
+              if (peek_char (p) == '"')
+                c = next_char (p);
+            }
+          add_text (p, c);
+        }
+      add_text (p, '\0');
+      return TOKEN_STRING;
+    default:
+      while (1)
+        {
+          add_text (p, c);
+          c = peek_char (p);
+          if (c == EOF || c == ' ' || c == '\t' || c == '\n' || c == '\r'
+              || c == '\f' || c == '{' || c == '}' || c == ':' || c == '"')
+            break;
+          next_char (p);
+        }
+      add_text (p, '\0');
+
+      /* The ':' may be separated from the key by blanks.  */
+      if (!skip_blanks (p))
+        return TOKEN_ERROR;
+      if (peek_char (p) == ':')
+        {
+          next_char (p);
+          return TOKEN_KEY;
+        }
+      return TOKEN_WORD;
+    }
+}
+
+/* Start a new record of KIND.  */
+
+static void
+begin_record (parser *p, gdl_record_kind kind)
+{
+  p->record.kind = kind;
+  p->record.line = p->line;
+  p->record.attr_num = 0;
+  p->pool_len = 0;
+}
+
+/* Append the string S with length LEN to the pool.  If SEP_P, join it to
+   the previous string with a space.  */
+
+static void
+add_pool (parser *p, const char *s, int len, int sep_p)
+{
+  if (p->pool_len + len + 1 > p->pool_size)
+    {
+      while (p->pool_len + len + 1 > p->pool_size)
+        p->pool_size *= 2;
+      p->pool = XRESIZEVEC (char, p->pool, p->pool_size);
+    }
+  if (sep_p)
+    p->pool[p->pool_len - 1] = ' ';
+  memcpy (p->pool + p->pool_len, s, len);
+  p->pool_len += len;
+  p->pool[p->pool_len++] = '\0';
+}
+
+/* Add the current text as a key to the record, after the word FIRST if
+   it is not NULL.  */
+
+static void
+add_key (parser *p, const char *first)
+{
+  int n = p->record.attr_num;
+
+  if (n == p->attr_size)
+    {
+      p->attr_size *= 2;
+      p->key_pos = XRESIZEVEC (int, p->key_pos, p->attr_size);
+      p->value_pos = XRESIZEVEC (int, p->value_pos, p->attr_size);
+      p->record.attrs = XRESIZEVEC (gdl_record_attr, p->record.attrs,
+                                    p->attr_size);
+    }
+  p->key_pos[n] = p->pool_len;
+  p->value_pos[n] = -1;
+  p->record.attrs[n].quoted_p = 0;
+  p->record.attr_num++;
+  if (first != NULL)
+    add_pool (p, first, strlen (first), 0);
+  add_pool (p, p->text, p->text_len - 1, first != NULL);
+}
+
+/* Add the current text as (a part of) the value of the last key.  */
+
+static void
+add_value (parser *p, int quoted_p)
+{
+  int n = p->record.attr_num - 1;
+
+  if (p->value_pos[n] < 0)
+    {
+      p->value_pos[n] = p->pool_len;
+      add_pool (p, p->text, p->text_len - 1, 0);
+    }
+  else
+    add_pool (p, p->text, p->text_len - 1, 1);
+  p->record.attrs[n].quoted_p |= quoted_p;
+}
+
+/* Return 1 if the word TEXT begins a key of two words.  */
+
+static int
+first_key_word_p (const char *text)
+{
+  return (!strcmp (text, "colorentry") || !strcmp (text, "classname")
+          || !strcmp (text, "infoname"));
+}
+
+/* Add the words and strings which follow a key as its value, up to the
+   first word of a key of two words.  Return the token after them.  */
+
+static enum token
+parse_values (parser *p)
+{
+  enum token token;
+
+  while ((token = next_token (p)) == TOKEN_STRING
+         || (token == TOKEN_WORD && !first_key_word_p (p->text)))
+    add_value (p, token == TOKEN_STRING);
+  return token;
+}
+
+/* Send the record to the callback.  Return its value.  */
+
+static int
+send_record (parser *p)
+{
+  int i;
+  gdl_record_attr *attr;
+
+  for (i = 0; i < p->record.attr_num; i++)
+    {
+      attr = &p->record.attrs[i];
+      attr->key = p->pool + p->key_pos[i];
+      /* A key without value gets the '\0' which ends the key.  */
+      if (p->value_pos[i] < 0)
+        attr->value = attr->key + strlen (attr->key);
+      else
+        attr->value = p->pool + p->value_pos[i];
+    }
+  return p->func (&p->record, p->data);
+}
+
+/* Send the record of the graph which has begun, if not sent yet.  */
+
+static int
+flush_graph (parser *p)
+{
+  if (!p->pending_p)
+    return 0;
+
+  p->pending_p = 0;
+  return send_record (p);
+}
+
+/* Parse the input.  Return 0 at the end of the top graph, 1 if stopped
+   by the callback, and -1 for a syntax error.  */
+
+static int
+parse (parser *p)
+{
+  enum token token;
+  enum object object = OBJECT_GRAPH;
+  int depth = 0;
+  int type;
+  char first[16];
+
+  /* The top graph.  */
+  if (next_token (p) != TOKEN_KEY || strcmp (p->text, "graph")
+      || next_token (p) != TOKEN_LBRACE)
+    return -1;
+  begin_record (p, GDL_RECORD_GRAPH_BEGIN);
+  p->record.depth = 0;
+  p->pending_p = 1;
+
+  token = next_token (p);
+  while (1)
+    {
+      switch (token)
+        {
+        case TOKEN_RBRACE:
+          if (object != OBJECT_GRAPH)
+            {
+              if (send_record (p))
+                return 1;
+              object = OBJECT_GRAPH;
+            }
+          else
+            {
+              if (flush_graph (p))
+                return 1;
+              begin_record (p, GDL_RECORD_GRAPH_END);
+              p->record.depth = depth;
+              if (send_record (p))
+                return 1;
+              if (depth-- == 0)
+                return 0;
+            }
+          token = next_token (p);
+          break;
+
+        case TOKEN_WORD:
+          /* A key of two words.  */
+          if (!first_key_word_p (p->text))
+            return -1;
+          strcpy (first, p->text);
+          if (next_token (p) != TOKEN_KEY)
+            return -1;
+          if (object == OBJECT_GRAPH && !p->pending_p)
+            {
+              begin_record (p, GDL_RECORD_GRAPH_ATTR);
+              p->record.depth = depth;
+            }
+          add_key (p, first);
+          token = parse_values (p);
+          if (object == OBJECT_GRAPH && !p->pending_p && send_record (p))
+            return 1;
+          break;
+
+        case TOKEN_KEY:
+          if (!skip_blanks (p))
+            return -1;
+          if (peek_char (p) != '{')
+            {
+              /* An attribute.  */
+              if (object == OBJECT_GRAPH && !p->pending_p)
+                {
+                  begin_record (p, GDL_RECORD_GRAPH_ATTR);
+                  p->record.depth = depth;
+                }
+              add_key (p, NULL);
+              token = parse_values (p);
+              if (object == OBJECT_GRAPH && !p->pending_p
+                  && send_record (p))
+                return 1;
+              break;
+            }
+
+          /* A graph, node or edge.  */
+          next_char (p);
+          if (object != OBJECT_GRAPH)
+            return -1;
+          if (flush_graph (p))
+            return 1;
+          if (!strcmp (p->text, "graph"))
+            {
+              begin_record (p, GDL_RECORD_GRAPH_BEGIN);
+              p->record.depth = ++depth;
+              p->pending_p = 1;
+            }
+          else if (!strcmp (p->text, "node"))
+            {
+              begin_record (p, GDL_RECORD_NODE);
+              object = OBJECT_NODE;
+            }
+          else if ((type = gdl_edge_type_from_name (p->text)) >= 0)
+            {
+              begin_record (p, GDL_RECORD_EDGE);
+              p->record.edge_type = (gdl_edge_type) type;
+              object = OBJECT_EDGE;
+            }
+          else
+            return -1;
+          p->record.depth = depth;
+          token = next_token (p);
+          break;
+
+        default:
+          return -1;
+        }
+    }
+}
+
+/* Parse the gdl file FIN, and call FUNC with DATA for each record.
+   Return 0 on success, 1 if FUNC stopped the parsing, and -1 for a syntax
+   error, whose line is stored into ERROR_LINE if not NULL.  */
+
+int
+gdl_parse_file (FILE *fin, gdl_record_func func, void *data,
+                int *error_line)
+{
+  parser p;
+  int ret;
+
+  memset (&p, 0, sizeof (p));
+  p.fin = fin;
+  p.block = XNEWVEC (char, BLOCK_SIZE);
+  p.line = 1;
+  p.text_size = 256;
+  p.text = XNEWVEC (char, p.text_size);
+  p.pool_size = 1024;
+  p.pool = XNEWVEC (char, p.pool_size);
+  p.attr_size = 16;
+  p.key_pos = XNEWVEC (int, p.attr_size);
+  p.value_pos = XNEWVEC (int, p.attr_size);
+  p.record.attrs = XNEWVEC (gdl_record_attr, p.attr_size);
+  p.func = func;
+  p.data = data;
+
+  ret = parse (&p);
+  if (ret < 0 && error_line != NULL)
+    *error_line = p.line;
+
+  free (p.block);
+  free (p.text);
+  free (p.pool);
+  free (p.key_pos);
+  free (p.value_pos);
+  free (p.record.attrs);
+  return ret;
+}
+
+/* Return the value of the attribute KEY in RECORD, or NULL.  */
+
+char *
+gdl_get_record_attr (gdl_record *record, const char *key)
+{
+  int i;
+
+  for (i = 0; i < record->attr_num; i++)
+    if (!strcmp (record->attrs[i].key, key))
+      return record->attrs[i].value;
+
+  return NULL;
+}
+
+/* The state of gdl_read_graph.  */
+
+typedef struct
+{
+  gdl_graph *top;
+  /* The graph being read.  */
+  gdl_graph *graph;
+  /* The line of the last record.  */
+  int line;
+} reader;
+
+/* The styles which carry the node shapes and the edge colors read, as
+   the objects themselves can not hold them.  They are shared by all the
+   graphs read, and never freed.  */
+
+static gdl_style *shape_styles[GDL_SHAPE_MAX];
+static gdl_style *color_styles[GDL_COLOR_MAX];
+
+/* Return the style for the node shape named VALUE, or NULL if it is not
+   a predefined one.  */
+
+static gdl_style *
+shape_style (char *value)
+{
+  gdl_shape shape = gdl_shape_from_name (value);
+
+  if (shape >= GDL_SHAPE_MAX)
+    return NULL;
+  if (shape_styles[shape] == NULL)
+    {
+      shape_styles[shape] = gdl_new_style (value);
+      gdl_set_style_shape (shape_styles[shape], shape);
+    }
+  return shape_styles[shape];
+}
+
+/* Likewise for the edge color named VALUE.  */
+
+static gdl_style *
+color_style (char *value)
+{
+  gdl_color color = gdl_color_from_name (value);
+
+  if (color >= GDL_COLOR_MAX)
+    return NULL;
+  if (color_styles[color] == NULL)
+    {
+      color_styles[color] = gdl_new_style (value);
+      gdl_set_style_color (color_styles[color], color);
+    }
+  return color_styles[color];
+}
+
+/* Set the attribute KEY of GRAPH to VALUE.  The unknown attributes are
+   ignored.  */
+
+static void
+read_graph_attr (gdl_graph *top, gdl_graph *graph, char *key, char *value)
+{
+  int id, r, g, b;
+
+  if (!strcmp (key, "color"))
+    gdl_set_graph_color (graph, gdl_color_from_name (value));
+  else if (!strncmp (key, "colorentry ", 11))
+    {
+      id = atoi (key + 11);
+      if (id >= 0 && id < 256
+          && sscanf (value, "%d %d %d", &r, &g, &b) == 3)
+        gdl_set_graph_colorentry (graph, id, r, g, b);
+    }
+  else if (!strcmp (key, "folding"))
+    gdl_set_graph_folding (graph, atoi (value));
+  else if (!strcmp (key, "horizontal_order"))
+    gdl_set_graph_horizontal_order (graph, atoi (value));
+  else if (!strcmp (key, "label"))
+    gdl_set_graph_label (graph, gdl_graph_strdup (top, value));
+  else if (!strcmp (key, "layout_algorithm"))
+    gdl_set_graph_layout_algorithm (graph, gdl_graph_strdup (top, value));
+  else if (!strcmp (key, "near_edges"))
+    gdl_set_graph_near_edges (graph, gdl_graph_strdup (top, value));
+  else if (!strcmp (key, "node_alignment"))
+    gdl_set_graph_node_alignment (graph, gdl_graph_strdup (top, value));
+  else if (!strcmp (key, "orientation"))
+    gdl_set_graph_orientation (graph, gdl_graph_strdup (top, value));
+  else if (!strcmp (key, "port_sharing"))
+    gdl_set_graph_port_sharing (graph, gdl_graph_strdup (top, value));
+  else if (!strcmp (key, "shape"))
+    gdl_set_graph_shape (graph, gdl_shape_from_name (value));
+  else if (!strcmp (key, "splines"))
+    gdl_set_graph_splines (graph, gdl_graph_strdup (top, value));
+  else if (!strcmp (key, "vertical_order"))
+    gdl_set_graph_vertical_order (graph, atoi (value));
+  else if (!strcmp (key, "xspace"))
+    gdl_set_graph_xspace (graph, atoi (value));
+  else if (!strcmp (key, "yspace"))
+    gdl_set_graph_yspace (graph, atoi (value));
+  else if (!strcmp (key, "node.borderwidth"))
+    gdl_set_graph_node_borderwidth (graph, atoi (value));
+  else if (!strcmp (key, "node.color"))
+    gdl_set_graph_node_color (graph, gdl_color_from_name (value));
+  else if (!strcmp (key, "node.shape"))
+    gdl_set_graph_node_shape (graph, gdl_shape_from_name (value));
+  else if (!strcmp (key, "node.textcolor"))
+    gdl_set_graph_node_textcolor (graph, gdl_color_from_name (value));
+  else if (!strcmp (key, "edge.color"))
+    gdl_set_graph_edge_color (graph, gdl_color_from_name (value));
+  else if (!strcmp (key, "edge.thickness"))
+    gdl_set_graph_edge_thickness (graph, atoi (value));
+}
+
+/* Likewise for NODE.  */
+
+static void
+read_node_attr (gdl_graph *top, gdl_node *node, char *key, char *value)
+{
+  if (!strcmp (key, "bordercolor"))
+    gdl_set_node_bordercolor (node, gdl_color_from_name (value));
+  else if (!strcmp (key, "borderwidth"))
+    gdl_set_node_borderwidth (node, atoi (value));
+  else if (!strcmp (key, "color"))
+    gdl_set_node_color (node, gdl_color_from_name (value));
+  else if (!strcmp (key, "horizontal_order"))
+    gdl_set_node_horizontal_order (node, atoi (value));
+  else if (!strcmp (key, "label"))
+    gdl_set_node_label (node, gdl_graph_strdup (top, value));
+  else if (!strcmp (key, "shape"))
+    gdl_set_node_style (node, shape_style (value));
+  else if (!strcmp (key, "vertical_order"))
+    gdl_set_node_vertical_order (node, atoi (value));
+}
+
+/* Likewise for EDGE.  */
+
+static void
+read_edge_attr (gdl_graph *top, gdl_edge *edge, char *key, char *value)
+{
+  if (!strcmp (key, "color"))
+    gdl_set_edge_style (edge, color_style (value));
+  else if (!strcmp (key, "label"))
+    gdl_set_edge_label (edge, gdl_graph_strdup (top, value));
+  else if (!strcmp (key, "linestyle"))
+    gdl_set_edge_linestyle (edge, gdl_linestyle_from_name (value));
+  else if (!strcmp (key, "thickness"))
+    gdl_set_edge_thickness (edge, atoi (value));
+}
+
+/* Add the object of RECORD to the graph being read by DATA.  */
+
+static int
+read_record (gdl_record *record, void *data)
+{
+  reader *r = (reader *) data;
+  gdl_node *node;
+  gdl_edge *edge;
+  char *key, *title, *source, *target;
+  int i;
+
+  r->line = record->line;
+  switch (record->kind)
+    {
+    case GDL_RECORD_GRAPH_BEGIN:
+      title = gdl_get_record_attr (record, "title");
+      if (r->top == NULL)
+        r->graph = r->top = gdl_new_graph (title);
+      else
+        r->graph = gdl_new_graph_subgraph (r->graph, title);
+      /* Fall through.  */
+    case GDL_RECORD_GRAPH_ATTR:
+      for (i = 0; i < record->attr_num; i++)
+        if (strcmp (key = record->attrs[i].key, "title"))
+          read_graph_attr (r->top, r->graph, key, record->attrs[i].value);
+      break;
+
+    case GDL_RECORD_GRAPH_END:
+      r->graph = r->graph->parent;
+      break;
+
+    case GDL_RECORD_NODE:
+      title = gdl_get_record_attr (record, "title");
+      node = gdl_new_graph_node (r->graph, title);
+      for (i = 0; i < record->attr_num; i++)
+        if (strcmp (key = record->attrs[i].key, "title"))
+          read_node_attr (r->top, node, key, record->attrs[i].value);
+      break;
+
+    case GDL_RECORD_EDGE:
+      source = gdl_get_record_attr (record, "sourcename");
+      target = gdl_get_record_attr (record, "targetname");
+      if (source == NULL || target == NULL)
+        return 1;
+      edge = gdl_new_graph_edge (r->graph, source, target);
+      gdl_set_edge_type (edge, record->edge_type);
+      for (i = 0; i < record->attr_num; i++)
+        read_edge_attr (r->top, edge, record->attrs[i].key,
+                        record->attrs[i].value);
+      break;
+    }
+
+  return 0;
+}
+
+/* Read the gdl file FIN into a graph.  The strings of the graph are kept
+   in its pool, and the attributes which libgdl does not know are
+   dropped.  Return NULL for a syntax error or an edge without source or
+   target, whose line is stored into ERROR_LINE if not NULL.  */
+
+gdl_graph *
+gdl_read_graph (FILE *fin, int *error_line)
+{
+  reader r;
+  int ret;
+
+  memset (&r, 0, sizeof (r));
+  ret = gdl_parse_file (fin, read_record, &r, error_line);
+  if (ret == 0 && r.top != NULL)
+    return r.top;
+
+  if (ret > 0 && error_line != NULL)
+    *error_line = r.line;
+  if (r.top != NULL)
+    gdl_free_graph (r.top);
+  return NULL;
+}
@@ -0,0 +1,58 @@
+/* The routines shared by the writers of libgdl.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef GDL_PRINT_H
+#define GDL_PRINT_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gdl.h"
+
+/* Print the string into the file and add a '\' before each '"'.  The
+   runs between the quotes are written as a whole.  */
+
+static inline void
+print_string (FILE *fout, char *str)
+{
+  char *quote;
+
+  while ((quote = strchr (str, '"')) != NULL)
+    {
+      fwrite (str, 1, quote - str, fout);
+      fwrite ("\\\"", 1, 2, fout);
+      str = quote + 1;
+    }
+  fputs (str, fout);
+}
+
+/* Print the attribute KEY, whose length is KEY_LEN, followed by the name
+   in SPAN.  */
+
+static inline void
+print_span_attr (FILE *fout, const char *key, int key_len,
+                 const gdl_span *span)
+{
+  fwrite (key, 1, key_len, fout);
+  fwrite (span->str, 1, span->len, fout);
+  putc ('\n', fout);
+}
+
+#define PRINT_SPAN_ATTR(FOUT, KEY, SPAN) \
+  print_span_attr ((FOUT), (KEY), sizeof (KEY) - 1, (SPAN))
+
+#endif
@@ -0,0 +1,880 @@
+/* Render gdl graphs as SVG.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* The renderer needs no viewer.  Each graph is laid out by
+   gdl_layout_graph, which places its nodes and subgraphs in levels, and
+   the units of a level are put side by side in their order.  A folded
+   subgraph is drawn as a box of its own, and an unfolded one as a frame
+   around the layout of its contents, which is done the same way inside
+   out.  The edges are straight lines between the boxes they connect,
+   where an object inside a folded subgraph stands for the subgraph.
+
+   If the graph has more nodes than the cutoff, the layout is coarser:
+   all the subgraphs are folded, there is a single sweep to reduce the
+   crossings, and the labels are cut to their first line.
+
+   The sizes of the labels are estimated for a monospace font, counting
+   both the newlines and the "\n" escapes of gdl as line breaks.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <libiberty.h>
+#include <hashtab.h>
+
+#include "gdl.h"
+
+/* The geometry, in pixels.  */
+
+#define FONT_SIZE 12
+#define CHAR_WIDTH 7
+#define LINE_HEIGHT 15
+#define BOX_PAD 6
+#define FRAME_PAD 10
+#define MARGIN 10
+#define XSPACE 20
+#define YSPACE 40
+#define ARROW_LENGTH 8
+#define ARROW_WIDTH 4
+
+/* The crossing reduction sweeps of the full and coarse layouts.  */
+
+#define FULL_ITERATIONS 8
+#define COARSE_ITERATIONS 1
+
+/* A box drawn for a node, a folded subgraph or the frame of an unfolded
+   subgraph.  */
+
+typedef struct
+{
+  gdl_node *node;
+  gdl_graph *graph;
+  /* The graph which the node or subgraph is in.  It is not always the
+     parent of the object, which may be in a shared graph.  */
+  gdl_graph *owner;
+  int frame_p;
+  /* The index of the box of the enclosing frame, or -1.  */
+  int parent;
+  int level;
+  int pos;
+  /* The position is relative to the contents of the parent until all
+     the boxes are placed.  */
+  double x;
+  double y;
+  double width;
+  double height;
+} svg_box;
+
+/* A title and the box which stands for it.  */
+
+typedef struct
+{
+  char *title;
+  int box;
+} svg_title;
+
+typedef struct
+{
+  FILE *fout;
+  int coarse_p;
+  svg_box *boxes;
+  int box_num;
+  int box_size;
+  htab_t titles;
+} svg_writer;
+
+static hashval_t
+svg_title_hash (const void *p)
+{
+  return htab_hash_string (((const svg_title *) p)->title);
+}
+
+static int
+svg_title_eq (const void *p1, const void *p2)
+{
+  return strcmp (((const svg_title *) p1)->title,
+                 ((const svg_title *) p2)->title) == 0;
+}
+
+/* Map TITLE to BOX.  The first mapping of a title wins.  */
+
+static void
+add_title (svg_writer *s, char *title, int box)
+{
+  svg_title key, *t;
+  void **slot;
+
+  key.title = title;
+  slot = htab_find_slot (s->titles, &key, INSERT);
+  if (*slot != NULL)
+    return;
+
+  t = XNEW (svg_title);
+  t->title = title;
+  t->box = box;
+  *slot = t;
+}
+
+/* Return the box of TITLE, or -1.  */
+
+static int
+find_title (svg_writer *s, char *title)
+{
+  svg_title key, *t;
+
+  key.title = title;
+  t = (svg_title *) htab_find (s->titles, &key);
+  return t ? t->box : -1;
+}
+
+/* Map the titles of the objects inside GRAPH to BOX.  */
+
+static void
+add_inner_titles (svg_writer *s, gdl_graph *graph, int box)
+{
+  gdl_node *node;
+  gdl_graph *subgraph;
+
+  for (node = graph->node; node != NULL; node = node->next)
+    add_title (s, node->title, box);
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    {
+      add_title (s, subgraph->title, box);
+      add_inner_titles (s, subgraph, box);
+    }
+}
+
+/* Return the index of a new box in PARENT.  */
+
+static int
+new_box (svg_writer *s, int parent)
+{
+  svg_box *box;
+
+  if (s->box_num == s->box_size)
+    {
+      s->box_size = s->box_size ? s->box_size * 2 : 64;
+      s->boxes = XRESIZEVEC (svg_box, s->boxes, s->box_size);
+    }
+  box = &s->boxes[s->box_num];
+  memset (box, 0, sizeof (*box));
+  box->parent = parent;
+  return s->box_num++;
+}
+
+/* Return the end of the line of a label which starts at P.  */
+
+static const char *
+line_end (const char *p)
+{
+  for (; *p; p++)
+    if (*p == '\n' || (p[0] == '\\' && p[1] == 'n'))
+      break;
+  return p;
+}
+
+/* Return the start of the line after the one which ends at P, or NULL if
+   it is the last line.  */
+
+static const char *
+next_line (const char *p)
+{
+  if (*p == '\0')
+    return NULL;
+  return p + (*p == '\n' ? 1 : 2);
+}
+
+/* Return the text drawn for NODE.  */
+
+static char *
+node_text (gdl_node *node)
+{
+  return node->set_p[GDL_NODE_ATTR_label] ? node->label : node->title;
+}
+
+static char *
+graph_text (gdl_graph *graph)
+{
+  return graph->set_p[GDL_GRAPH_ATTR_label] ? graph->label : graph->title;
+}
+
+/* Store the size of the box for the label TEXT into BOX.  */
+
+static void
+size_box (svg_writer *s, svg_box *box, const char *text)
+{
+  const char *p = text, *end;
+  int cols = 0, lines = 0;
+
+  do
+    {
+      end = line_end (p);
+      if (end - p > cols)
+        cols = end - p;
+      lines++;
+    }
+  while (!s->coarse_p && (p = next_line (end)) != NULL);
+
+  box->width = cols * CHAR_WIDTH + 2 * BOX_PAD;
+  box->height = lines * LINE_HEIGHT + 2 * BOX_PAD;
+}
+
+/* Return 1 if GRAPH is drawn folded.  */
+
+static int
+folded_p (svg_writer *s, gdl_graph *graph)
+{
+  if (s->coarse_p)
+    return 1;
+  if (graph->set_p[GDL_GRAPH_ATTR_folding])
+    return graph->folding != 0;
+  return (graph->style != NULL && graph->style->set_p[GDL_STYLE_ATTR_folding]
+          && graph->style->folding != 0);
+}
+
+/* A box being placed, with its sort keys.  */
+
+typedef struct
+{
+  int level;
+  int pos;
+  int unit;
+} unit_key;
+
+/* Compare two unit_keys by level and position.  The keys are sorted in
+   place, so that graphs can be written in several threads at once.  */
+
+static int
+compare_units (const void *p1, const void *p2)
+{
+  const unit_key *k1 = (const unit_key *) p1;
+  const unit_key *k2 = (const unit_key *) p2;
+
+  if (k1->level != k2->level)
+    return k1->level - k2->level;
+  return k1->pos - k2->pos;
+}
+
+/* Place the boxes FIRST to FIRST + NUM - 1, which are the units of GRAPH
+   and have their sizes, by level and position.  Store the size of the
+   whole into WIDTH and HEIGHT.  */
+
+static void
+place_units (svg_writer *s, gdl_graph *graph, int first, int num,
+             double *width, double *height)
+{
+  unit_key *keys;
+  int *units, i, j, k;
+  double xspace, yspace, level_width, level_height, x, y;
+  svg_box *box;
+
+  xspace = graph->set_p[GDL_GRAPH_ATTR_xspace] ? graph->xspace : XSPACE;
+  yspace = graph->set_p[GDL_GRAPH_ATTR_yspace] ? graph->yspace : YSPACE;
+
+  keys = XNEWVEC (unit_key, num);
+  for (i = 0; i < num; i++)
+    {
+      keys[i].level = s->boxes[first + i].level;
+      keys[i].pos = s->boxes[first + i].pos;
+      keys[i].unit = first + i;
+    }
+  qsort (keys, num, sizeof (unit_key), compare_units);
+  units = XNEWVEC (int, num);
+  for (i = 0; i < num; i++)
+    units[i] = keys[i].unit;
+  free (keys);
+
+  /* Find the widest level.  */
+  *width = 0;
+  for (i = 0; i < num; i = j)
+    {
+      level_width = 0;
+      for (j = i; j < num && (s->boxes[units[j]].level
+                              == s->boxes[units[i]].level); j++)
+        level_width += s->boxes[units[j]].width + (j > i ? xspace : 0);
+      if (level_width > *width)
+        *width = level_width;
+    }
+
+  /* Center each level under the widest one.  */
+  y = 0;
+  for (i = 0; i < num; i = j)
+    {
+      level_width = level_height = 0;
+      for (j = i; j < num && (s->boxes[units[j]].level
+                              == s->boxes[units[i]].level); j++)
+        {
+          box = &s->boxes[units[j]];
+          level_width += box->width + (j > i ? xspace : 0);
+          if (box->height > level_height)
+            level_height = box->height;
+        }
+
+      x = (*width - level_width) / 2;
+      for (k = i; k < j; k++)
+        {
+          box = &s->boxes[units[k]];
+          box->x = x;
+          box->y = y + (level_height - box->height) / 2;
+          x += box->width + xspace;
+        }
+      y += level_height + yspace;
+    }
+  *height = y > 0 ? y - yspace : 0;
+
+  free (units);
+}
+
+/* Lay out the contents of GRAPH, whose frame is the box PARENT, or -1 for
+   the top graph.  Store the size of the contents into WIDTH and HEIGHT.  */
+
+static void
+layout_contents (svg_writer *s, gdl_graph *graph, int parent,
+                 double *width, double *height)
+{
+  gdl_node *node;
+  gdl_graph *subgraph;
+  svg_box *box;
+  int first = s->box_num, num, b;
+  double inner_width, inner_height, title_width;
+
+  *width = *height = 0;
+  if (graph->node == NULL && graph->subgraph == NULL)
+    return;
+
+  gdl_layout_graph (graph, s->coarse_p ? COARSE_ITERATIONS
+                                       : FULL_ITERATIONS);
+
+  /* Make the boxes of the units first, as the inner layouts change the
+     orders of the objects inside them.  */
+  for (node = graph->node; node != NULL; node = node->next)
+    {
+      b = new_box (s, parent);
+      box = &s->boxes[b];
+      box->node = node;
+      box->owner = graph;
+      box->level = node->vertical_order;
+      box->pos = node->horizontal_order;
+      size_box (s, box, node_text (node));
+      add_title (s, node->title, b);
+    }
+
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    {
+      b = new_box (s, parent);
+      box = &s->boxes[b];
+      box->graph = subgraph;
+      box->owner = graph;
+      box->level = subgraph->vertical_order;
+      box->pos = subgraph->horizontal_order;
+      add_title (s, subgraph->title, b);
+    }
+  num = s->box_num - first;
+
+  /* Size the subgraphs.  */
+  for (b = first; b < first + num; b++)
+    {
+      subgraph = s->boxes[b].graph;
+      if (subgraph == NULL)
+        continue;
+
+      if (folded_p (s, subgraph))
+        {
+          size_box (s, &s->boxes[b], graph_text (subgraph));
+          add_inner_titles (s, subgraph, b);
+          continue;
+        }
+
+      layout_contents (s, subgraph, b, &inner_width, &inner_height);
+      title_width = strlen (graph_text (subgraph)) * CHAR_WIDTH;
+      box = &s->boxes[b];
+      box->frame_p = 1;
+      box->width = (inner_width > title_width ? inner_width : title_width)
+                   + 2 * FRAME_PAD;
+      box->height = inner_height + LINE_HEIGHT + 2 * FRAME_PAD;
+    }
+
+  place_units (s, graph, first, num, width, height);
+}
+
+/* Make the positions of the boxes absolute.  The frames come before the
+   boxes inside them.  */
+
+static void
+place_boxes (svg_writer *s)
+{
+  int i;
+  svg_box *box, *parent;
+
+  for (i = 0; i < s->box_num; i++)
+    {
+      box = &s->boxes[i];
+      if (box->parent < 0)
+        {
+          box->x += MARGIN;
+          box->y += MARGIN;
+        }
+      else
+        {
+          parent = &s->boxes[box->parent];
+          /* The contents are centered in the frame.  */
+          box->x += parent->x + FRAME_PAD;
+          box->y += parent->y + FRAME_PAD + LINE_HEIGHT;
+        }
+    }
+}
+
+/* Print STR, up to END if not NULL, escaped for XML.  */
+
+static void
+print_xml (FILE *fout, const char *str, const char *end)
+{
+  const char *run = str;
+
+  for (; end ? str < end : *str != '\0'; str++)
+    {
+      if (*str != '&' && *str != '<' && *str != '>' && *str != '"')
+        continue;
+
+      fwrite (run, 1, str - run, fout);
+      run = str + 1;
+      switch (*str)
+        {
+        case '&':
+          fputs ("&amp;", fout);
+          break;
+        case '<':
+          fputs ("&lt;", fout);
+          break;
+        case '>':
+          fputs ("&gt;", fout);
+          break;
+        default:
+          fputs ("&quot;", fout);
+          break;
+        }
+    }
+  fwrite (run, 1, str - run, fout);
+}
+
+/* Print the color attribute KEY for COLOR of GRAPH.  */
+
+static void
+print_color (FILE *fout, const char *key, gdl_graph *graph,
+             gdl_color color)
+{
+  int rgb[3];
+
+  if (gdl_get_color_rgb (graph, color, rgb))
+    fprintf (fout, " %s=\"#%02x%02x%02x\"", key, rgb[0], rgb[1], rgb[2]);
+  else
+    {
+      fprintf (fout, " %s=\"", key);
+      print_xml (fout, gdl_color_span (color)->str, NULL);
+      putc ('"', fout);
+    }
+}
+
+/* The attributes of a node in effect, after the node itself, its style
+   and the defaults of the enclosing graphs, from GRAPH.  */
+
+static gdl_color
+node_color (gdl_node *node, gdl_graph *graph)
+{
+  if (node->set_p[GDL_NODE_ATTR_color])
+    return node->color;
+  if (node->style != NULL && node->style->set_p[GDL_STYLE_ATTR_color])
+    return node->style->color;
+  for (; graph != NULL; graph = graph->parent)
+    if (graph->set_p[GDL_GRAPH_ATTR_node_color])
+      return graph->node_color;
+  return GDL_COLOR_WHITE;
+}
+
+static gdl_color
+node_textcolor (gdl_graph *graph)
+{
+  for (; graph != NULL; graph = graph->parent)
+    if (graph->set_p[GDL_GRAPH_ATTR_node_textcolor])
+      return graph->node_textcolor;
+  return GDL_COLOR_BLACK;
+}
+
+static gdl_color
+node_bordercolor (gdl_node *node)
+{
+  if (node->set_p[GDL_NODE_ATTR_bordercolor])
+    return node->bordercolor;
+  if (node->style != NULL && node->style->set_p[GDL_STYLE_ATTR_bordercolor])
+    return node->style->bordercolor;
+  return GDL_COLOR_BLACK;
+}
+
+static int
+node_borderwidth (gdl_node *node, gdl_graph *graph)
+{
+  if (node->set_p[GDL_NODE_ATTR_borderwidth])
+    return node->borderwidth;
+  if (node->style != NULL && node->style->set_p[GDL_STYLE_ATTR_borderwidth])
+    return node->style->borderwidth;
+  for (; graph != NULL; graph = graph->parent)
+    if (graph->set_p[GDL_GRAPH_ATTR_node_borderwidth])
+      return graph->node_borderwidth;
+  return 1;
+}
+
+static gdl_shape
+node_shape (gdl_node *node, gdl_graph *graph)
+{
+  if (node->style != NULL && node->style->set_p[GDL_STYLE_ATTR_shape])
+    return node->style->shape;
+  for (; graph != NULL; graph = graph->parent)
+    if (graph->set_p[GDL_GRAPH_ATTR_node_shape])
+      return graph->node_shape;
+  return GDL_BOX;
+}
+
+/* The attributes of a subgraph in effect.  */
+
+static gdl_color
+graph_color (gdl_graph *graph)
+{
+  if (graph->set_p[GDL_GRAPH_ATTR_color])
+    return graph->color;
+  if (graph->style != NULL && graph->style->set_p[GDL_STYLE_ATTR_color])
+    return graph->style->color;
+  return GDL_COLOR_WHITE;
+}
+
+static gdl_shape
+graph_shape (gdl_graph *graph)
+{
+  if (graph->set_p[GDL_GRAPH_ATTR_shape])
+    return graph->shape;
+  if (graph->style != NULL && graph->style->set_p[GDL_STYLE_ATTR_shape])
+    return graph->style->shape;
+  return GDL_BOX;
+}
+
+/* Draw the outline of BOX with SHAPE, leaving the element open for its
+   colors.  */
+
+static void
+draw_shape (FILE *fout, svg_box *box, gdl_shape shape)
+{
+  double x = box->x, y = box->y, w = box->width, h = box->height;
+
+  switch (shape)
+    {
+    case GDL_RHOMB:
+      fprintf (fout, "<polygon points=\"%g,%g %g,%g %g,%g %g,%g\"",
+               x + w / 2, y, x + w, y + h / 2, x + w / 2, y + h,
+               x, y + h / 2);
+      break;
+    case GDL_ELLIPSE:
+      fprintf (fout, "<ellipse cx=\"%g\" cy=\"%g\" rx=\"%g\" ry=\"%g\"",
+               x + w / 2, y + h / 2, w / 2, h / 2);
+      break;
+    case GDL_TRIANGLE:
+      fprintf (fout, "<polygon points=\"%g,%g %g,%g %g,%g\"",
+               x + w / 2, y, x + w, y + h, x, y + h);
+      break;
+    default:
+      fprintf (fout, "<rect x=\"%g\" y=\"%g\" width=\"%g\" height=\"%g\"",
+               x, y, w, h);
+      break;
+    }
+}
+
+/* Draw TEXT centered in BOX, in the color COLOR of GRAPH.  */
+
+static void
+draw_text (svg_writer *s, svg_box *box, const char *text, gdl_graph *graph,
+           gdl_color color)
+{
+  FILE *fout = s->fout;
+  const char *p = text, *end;
+  int lines = 0;
+  double y;
+
+  do
+    lines++;
+  while (!s->coarse_p && (p = next_line (line_end (p))) != NULL);
+
+  y = box->y + (box->height - lines * LINE_HEIGHT) / 2 + FONT_SIZE;
+  fprintf (fout, "<text x=\"%g\" y=\"%g\" text-anchor=\"middle\"",
+           box->x + box->width / 2, y);
+  print_color (fout, "fill", graph, color);
+  putc ('>', fout);
+
+  p = text;
+  do
+    {
+      end = line_end (p);
+      fprintf (fout, "<tspan x=\"%g\" y=\"%g\">", box->x + box->width / 2, y);
+      print_xml (fout, p, end);
+      fputs ("</tspan>", fout);
+      y += LINE_HEIGHT;
+    }
+  while (!s->coarse_p && (p = next_line (end)) != NULL);
+
+  fputs ("</text>\n", fout);
+}
+
+/* Draw the frames of the unfolded subgraphs.  */
+
+static void
+draw_frames (svg_writer *s)
+{
+  FILE *fout = s->fout;
+  svg_box *box;
+  int i;
+
+  for (i = 0; i < s->box_num; i++)
+    {
+      box = &s->boxes[i];
+      if (!box->frame_p)
+        continue;
+
+      draw_shape (fout, box, GDL_BOX);
+      print_color (fout, "fill", box->graph, graph_color (box->graph));
+      fputs (" stroke=\"#000000\"/>\n", fout);
+      fprintf (fout, "<text x=\"%g\" y=\"%g\">", box->x + FRAME_PAD,
+               box->y + FRAME_PAD + FONT_SIZE);
+      print_xml (fout, graph_text (box->graph), NULL);
+      fputs ("</text>\n", fout);
+    }
+}
+
+/* Draw the nodes and the folded subgraphs.  */
+
+static void
+draw_boxes (svg_writer *s)
+{
+  FILE *fout = s->fout;
+  svg_box *box;
+  gdl_node *node;
+  gdl_graph *graph;
+  int i;
+
+  for (i = 0; i < s->box_num; i++)
+    {
+      box = &s->boxes[i];
+      if (box->frame_p)
+        continue;
+
+      if ((node = box->node) != NULL)
+        {
+          graph = box->owner;
+          draw_shape (fout, box, node_shape (node, graph));
+          print_color (fout, "fill", graph, node_color (node, graph));
+          print_color (fout, "stroke", graph, node_bordercolor (node));
+          fprintf (fout, " stroke-width=\"%d\"/>\n",
+                   node_borderwidth (node, graph));
+          draw_text (s, box, node_text (node), graph,
+                     node_textcolor (graph));
+        }
+      else
+        {
+          graph = box->graph;
+          draw_shape (fout, box, graph_shape (graph));
+          print_color (fout, "fill", graph, graph_color (graph));
+          fputs (" stroke=\"#000000\" stroke-width=\"2\"/>\n", fout);
+          draw_text (s, box, graph_text (graph), graph,
+                     node_textcolor (box->owner));
+        }
+    }
+}
+
+/* Move the point (X, Y) at the center of BOX towards (TX, TY) until it
+   reaches the border of the box.  */
+
+static void
+clip_to_box (svg_box *box, double *x, double *y, double tx, double ty)
+{
+  double dx = tx - *x, dy = ty - *y, t = 1;
+
+  if (dx != 0 && box->width / 2 / fabs (dx) < t)
+    t = box->width / 2 / fabs (dx);
+  if (dy != 0 && box->height / 2 / fabs (dy) < t)
+    t = box->height / 2 / fabs (dy);
+  *x += dx * t;
+  *y += dy * t;
+}
+
+/* Draw EDGE, which is in OWNER, unless it is inside a box.  */
+
+static void
+draw_edge (svg_writer *s, gdl_edge *edge, gdl_graph *owner)
+{
+  FILE *fout = s->fout;
+  int source, target, thickness;
+  svg_box *sb, *tb;
+  double x1, y1, x2, y2, len, ux, uy;
+  gdl_color color = GDL_COLOR_BLACK;
+  gdl_linestyle linestyle = GDL_CONTINUOUS;
+  gdl_graph *graph;
+
+  source = find_title (s, edge->sourcename);
+  target = find_title (s, edge->targetname);
+  if (source < 0 || target < 0 || source == target)
+    return;
+
+  /* The attributes in effect.  */
+  thickness = 1;
+  for (graph = owner; graph != NULL; graph = graph->parent)
+    if (graph->set_p[GDL_GRAPH_ATTR_edge_thickness])
+      {
+        thickness = graph->edge_thickness;
+        break;
+      }
+  for (graph = owner; graph != NULL; graph = graph->parent)
+    if (graph->set_p[GDL_GRAPH_ATTR_edge_color])
+      {
+        color = graph->edge_color;
+        break;
+      }
+  if (edge->style != NULL)
+    {
+      if (edge->style->set_p[GDL_STYLE_ATTR_color])
+        color = edge->style->color;
+      if (edge->style->set_p[GDL_STYLE_ATTR_thickness])
+        thickness = edge->style->thickness;
+      if (edge->style->set_p[GDL_STYLE_ATTR_linestyle])
+        linestyle = edge->style->linestyle;
+    }
+  if (edge->set_p[GDL_EDGE_ATTR_thickness])
+    thickness = edge->thickness;
+  if (edge->set_p[GDL_EDGE_ATTR_linestyle])
+    linestyle = edge->linestyle;
+  if (linestyle == GDL_INVISIBLE)
+    return;
+
+  sb = &s->boxes[source];
+  tb = &s->boxes[target];
+  x1 = sb->x + sb->width / 2;
+  y1 = sb->y + sb->height / 2;
+  x2 = tb->x + tb->width / 2;
+  y2 = tb->y + tb->height / 2;
+  clip_to_box (sb, &x1, &y1, x2, y2);
+  clip_to_box (tb, &x2, &y2, x1, y1);
+  len = sqrt ((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+  if (len < 1)
+    return;
+  ux = (x2 - x1) / len;
+  uy = (y2 - y1) / len;
+
+  fprintf (fout, "<line x1=\"%g\" y1=\"%g\" x2=\"%g\" y2=\"%g\"",
+           x1, y1, x2 - ux * ARROW_LENGTH, y2 - uy * ARROW_LENGTH);
+  print_color (fout, "stroke", owner, color);
+  fprintf (fout, " stroke-width=\"%d\"", thickness);
+  if (linestyle == GDL_DASHED)
+    fputs (" stroke-dasharray=\"6,4\"", fout);
+  else if (linestyle == GDL_DOTTED)
+    fputs (" stroke-dasharray=\"2,3\"", fout);
+  fputs ("/>\n", fout);
+
+  fprintf (fout, "<polygon points=\"%g,%g %g,%g %g,%g\"", x2, y2,
+           x2 - ux * ARROW_LENGTH - uy * ARROW_WIDTH,
+           y2 - uy * ARROW_LENGTH + ux * ARROW_WIDTH,
+           x2 - ux * ARROW_LENGTH + uy * ARROW_WIDTH,
+           y2 - uy * ARROW_LENGTH - ux * ARROW_WIDTH);
+  print_color (fout, "fill", owner, color);
+  fputs ("/>\n", fout);
+
+  if (edge->set_p[GDL_EDGE_ATTR_label] && !s->coarse_p)
+    {
+      fprintf (fout, "<text x=\"%g\" y=\"%g\">", (x1 + x2) / 2 + 3,
+               (y1 + y2) / 2);
+      print_xml (fout, edge->label, line_end (edge->label));
+      fputs ("</text>\n", fout);
+    }
+}
+
+/* Draw the edges in GRAPH and its subgraphs.  */
+
+static void
+draw_edges (svg_writer *s, gdl_graph *graph)
+{
+  gdl_edge *edge;
+  gdl_graph *subgraph;
+
+  for (edge = graph->edge; edge != NULL; edge = edge->next)
+    draw_edge (s, edge, graph);
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    draw_edges (s, subgraph);
+}
+
+/* Count the nodes in GRAPH at any depth.  */
+
+static int
+count_nodes (gdl_graph *graph)
+{
+  gdl_node *node;
+  gdl_graph *subgraph;
+  int num = 0;
+
+  for (node = graph->node; node != NULL; node = node->next)
+    num++;
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    num += count_nodes (subgraph);
+  return num;
+}
+
+/* Render GRAPH into the file as SVG, with the coarse layout if it has
+   more than MAX_NODES nodes.  The graph is laid out by gdl_layout_graph,
+   which sets the vertical and horizontal orders of its objects.  */
+
+void
+gdl_dump_graph_svg (FILE *fout, gdl_graph *graph, int max_nodes)
+{
+  svg_writer s;
+  double width, height;
+
+  memset (&s, 0, sizeof (s));
+  s.fout = fout;
+  s.coarse_p = count_nodes (graph) > max_nodes;
+  s.titles = htab_create (1024, svg_title_hash, svg_title_eq, free);
+
+  layout_contents (&s, graph, -1, &width, &height);
+  place_boxes (&s);
+
+  width += 2 * MARGIN;
+  height += 2 * MARGIN;
+  fprintf (fout, "<svg xmlns=\"http://www.w3.org/2000/svg\" "
+                 "width=\"%g\" height=\"%g\" viewBox=\"0 0 %g %g\" "
+                 "font-family=\"monospace\" font-size=\"%d\">\n",
+           width, height, width, height, FONT_SIZE);
+  fputs ("<title>", fout);
+  print_xml (fout, graph_text (graph), NULL);
+  fputs ("</title>\n", fout);
+
+  draw_frames (&s);
+  draw_edges (&s, graph);
+  draw_boxes (&s);
+
+  fputs ("</svg>\n", fout);
+
+  htab_delete (s.titles);
+  free (s.boxes);
+}
@@ -22,8 +22,49 @@
 
 #include <error.h>
 #include <libiberty.h>
+#include <hashtab.h>
 
 #include "gdl.h"
+#include "gdl-print.h"
+#include "gdl-budget.h"
+
+/* A block holding the nodes and edges created in bulk, followed by their
+   titles.  */
+
+struct gdl_bulk
+{
+  gdl_bulk *next;
+  /* The end of the block.  */
+  char *end;
+};
+
+/* A block of strings owned by a graph.  */
+
+struct gdl_pool
+{
+  gdl_pool *next;
+  /* The free space of the block.  */
+  char *ptr;
+  char *end;
+};
+
+#define POOL_BLOCK_SIZE 16384
+
+/* An edge which stands for the parallel edges added to a graph.  */
+
+typedef struct
+{
+  gdl_edge *edge;
+  int count;
+  char label[16];
+} aggregate_edge;
+
+struct gdl_aggregate
+{
+  gdl_aggregate_mode mode;
+  /* The aggregate_edge of the edges by source and target.  */
+  htab_t edges;
+};
 
 /* Used to create a node/graph with no title.  */
 static unsigned anonymous_title_id = 0;
@@ -47,21 +88,33 @@ gdl_new_node (char *title)
     }
   gdl_set_node_title (node, strdup (title));
 
+  node->style = NULL;
   node->next = NULL;
   node->parent = NULL;
   
   return node;
 }
 
+/* Create a node for TITLE in GRAPH.  If the budget of the graph is used
+   up, the node is elided and the returned one is not in the graph.  */
+
 gdl_node *
 gdl_new_graph_node (gdl_graph *graph, char *title)
 {
   gdl_node *node;
+  gdl_budget *budget;
 
   assert (graph);
 
+  budget = find_budget (graph);
+  if (budget != NULL
+      && (node = gdl_budget_elide_node (budget, graph, title)) != NULL)
+    return node;
+
   node = gdl_new_node (title);
   gdl_add_node (graph, node);
+  if (budget != NULL)
+    gdl_budget_add_node (budget, node);
 
   return node;
 }
@@ -80,21 +133,147 @@ gdl_new_edge (char *source, char *target)
   gdl_set_edge_sourcename (edge, strdup (source));
   gdl_set_edge_targetname (edge, strdup (target));
 
+  edge->style = NULL;
   edge->type = GDL_EDGE;
   edge->next = NULL;
+  edge->parent = NULL;
   
   return edge;
 }
 
+static hashval_t
+aggregate_edge_hash (const void *p)
+{
+  gdl_edge *edge = ((const aggregate_edge *) p)->edge;
+
+  return htab_hash_string (edge->sourcename) * 31
+         + htab_hash_string (edge->targetname);
+}
+
+static int
+aggregate_edge_eq (const void *p1, const void *p2)
+{
+  gdl_edge *edge1 = ((const aggregate_edge *) p1)->edge;
+  gdl_edge *edge2 = ((const aggregate_edge *) p2)->edge;
+
+  return !strcmp (edge1->sourcename, edge2->sourcename)
+         && !strcmp (edge1->targetname, edge2->targetname);
+}
+
+/* Merge the parallel edges added to GRAPH from now on by MODE.  An edge
+   from the source to the target of an edge already added is not created,
+   and the existing one is returned instead, which records the number of
+   such edges as MODE tells.  The label or thickness of the edge given by
+   the caller is replaced once the edge is merged.  GDL_AGGREGATE_NONE
+   stops merging.  The edges of the subgraphs are not merged.  */
+
+void
+gdl_set_graph_edge_aggregation (gdl_graph *graph, gdl_aggregate_mode mode)
+{
+  if (graph->aggregate == NULL)
+    {
+      graph->aggregate = XNEW (gdl_aggregate);
+      graph->aggregate->edges = htab_create (1024, aggregate_edge_hash,
+                                             aggregate_edge_eq, free);
+    }
+  graph->aggregate->mode = mode;
+}
+
+/* Return the number of edges which EDGE stands for.  */
+
+int
+gdl_get_edge_multiplicity (gdl_edge *edge)
+{
+  gdl_graph *graph = edge->parent;
+  aggregate_edge key, *e;
+
+  if (graph == NULL || graph->aggregate == NULL)
+    return 1;
+
+  key.edge = edge;
+  e = (aggregate_edge *) htab_find (graph->aggregate->edges, &key);
+  return e != NULL && e->edge == edge ? e->count : 1;
+}
+
+/* Return the edge from SOURCE to TARGET in GRAPH which merges the new one
+   of them, or NULL if it is the first one.  */
+
+static gdl_edge *
+find_aggregate_edge (gdl_graph *graph, char *source, char *target)
+{
+  gdl_aggregate *aggregate = graph->aggregate;
+  aggregate_edge key, *e;
+  gdl_edge edge;
+
+  edge.sourcename = source;
+  edge.targetname = target;
+  key.edge = &edge;
+  e = (aggregate_edge *) htab_find (aggregate->edges, &key);
+  if (e == NULL)
+    return NULL;
+
+  e->count++;
+  if (aggregate->mode == GDL_AGGREGATE_LABEL)
+    {
+      sprintf (e->label, "%d", e->count);
+      e->edge->label = e->label;
+      e->edge->set_p[GDL_EDGE_ATTR_label] = 1;
+    }
+  else
+    gdl_set_edge_thickness (e->edge,
+                            e->count < GDL_MAX_AGGREGATE_THICKNESS
+                            ? e->count : GDL_MAX_AGGREGATE_THICKNESS);
+  return e->edge;
+}
+
+/* Record EDGE, which is the first one from its source to its target in
+   GRAPH.  */
+
+static void
+add_aggregate_edge (gdl_graph *graph, gdl_edge *edge)
+{
+  aggregate_edge *e;
+  void **slot;
+
+  e = XNEW (aggregate_edge);
+  e->edge = edge;
+  e->count = 1;
+  slot = htab_find_slot (graph->aggregate->edges, e, INSERT);
+  *slot = e;
+}
+
+/* Create an edge from SOURCE to TARGET in GRAPH.  If the graph merges
+   the parallel edges, the edge which stands for them may be returned, see
+   gdl_set_graph_edge_aggregation.  If the budget of the graph is used up,
+   the edge is elided and the returned one is not in the graph.  */
+
 gdl_edge *
 gdl_new_graph_edge (gdl_graph *graph, char *source, char *target)
 {
   gdl_edge *edge;
+  gdl_budget *budget;
+  int aggregate_p;
 
   assert (graph);
 
+  aggregate_p = (graph->aggregate != NULL
+                 && graph->aggregate->mode != GDL_AGGREGATE_NONE);
+  if (aggregate_p
+      && (edge = find_aggregate_edge (graph, source, target)) != NULL)
+    return edge;
+
+  budget = find_budget (graph);
+  if (budget != NULL
+      && (edge = gdl_budget_elide_edge (budget, graph, &source,
+                                        &target)) != NULL)
+    return edge;
+
   edge = gdl_new_edge (source, target);
   gdl_add_edge (graph, edge);
+  if (budget != NULL)
+    gdl_budget_add_edge (budget, edge);
+  if (aggregate_p)
+    add_aggregate_edge (graph, edge);
 
   return edge;
 }
@@ -118,6 +297,7 @@ gdl_new_graph (char *title)
     }
   gdl_set_graph_title (graph, strdup (title));
 
+  graph->style = NULL;
   graph->node = NULL;
   graph->last_node = NULL;
   graph->subgraph = NULL;
@@ -126,23 +306,404 @@ gdl_new_graph (char *title)
   graph->last_edge = NULL;
   graph->next = NULL;
   graph->parent = NULL;
+  graph->bulk = NULL;
+  graph->pool = NULL;
+  graph->budget = NULL;
+  graph->shared = NULL;
+  graph->refcount = 1;
+  graph->aggregate = NULL;
 
   return graph;
 }
 
+/* Create a subgraph for TITLE in GRAPH.  If the budget of the graph is
+   used up, the subgraph is elided and the returned one is not in the
+   graph.  */
+
 gdl_graph *
 gdl_new_graph_subgraph (gdl_graph *graph, char *title)
 {
   gdl_graph *subgraph;
+  gdl_budget *budget;
 
   assert (graph);
 
+  budget = find_budget (graph);
+  if (budget != NULL
+      && (subgraph = gdl_budget_elide_graph (budget, graph, title)) != NULL)
+    return subgraph;
+
   subgraph = gdl_new_graph (title);
   gdl_add_subgraph (graph, subgraph);
 
   return subgraph;
 }
 
+/* Return a new graph with the attributes of HEADER, which shows the
+   objects of HEADER or of the graph which HEADER shows.  */
+
+static gdl_graph *
+new_graph_proxy (gdl_graph *header)
+{
+  gdl_graph *proxy;
+
+  proxy = XNEW (gdl_graph);
+  *proxy = *header;
+  proxy->title = xstrdup (header->title);
+  proxy->next = NULL;
+  proxy->parent = NULL;
+  proxy->bulk = NULL;
+  proxy->pool = NULL;
+  proxy->budget = NULL;
+  proxy->aggregate = NULL;
+  proxy->refcount = 1;
+  if (proxy->shared == NULL)
+    proxy->shared = header;
+  gdl_ref_graph (proxy->shared);
+
+  return proxy;
+}
+
+/* Add to GRAPH a subgraph which shows the nodes, edges and subgraphs of
+   SHARED, and return it.  SHARED is a graph of its own, which must not
+   be changed from then on, nor be added to a graph, so that any number
+   of graphs can share it.  The new subgraph starts with the attributes
+   of SHARED, and may get its own ones, e.g. the orders set by
+   gdl_layout_graph, which leaves the objects of SHARED alone.  Adding an
+   object to it copies the objects of SHARED first.
+
+   SHARED is freed with the last reference to it, by gdl_unref_graph.
+   Its creator holds one, and each subgraph showing it holds one.  */
+
+gdl_graph *
+gdl_new_graph_shared (gdl_graph *graph, gdl_graph *shared)
+{
+  gdl_graph *subgraph;
+
+  assert (graph);
+
+  subgraph = new_graph_proxy (shared);
+  gdl_add_subgraph (graph, subgraph);
+
+  return subgraph;
+}
+
+/* Create the nodes and edges of new_graph_bulk one by one, so that the
+   budget of GRAPH and its edge aggregation see each of them.  */
+
+static void
+new_graph_each (gdl_graph *graph, int node_num,
+                gdl_node_name_func title_func, gdl_node_name_func label_func,
+                void *data, int edge_num, int *offsets, int *sources,
+                int *targets)
+{
+  gdl_node *node;
+  char **titles;
+  int i, j;
+
+  titles = XNEWVEC (char *, node_num);
+  for (i = 0; i < node_num; i++)
+    {
+      if (title_func)
+        titles[i] = xstrdup (title_func (i, data));
+      else
+        {
+          titles[i] = XNEWVEC (char, strlen (graph->title)
+                                     + snprintf (NULL, 0, ".%d", i) + 1);
+          sprintf (titles[i], "%s.%d", graph->title, i);
+        }
+
+      node = gdl_new_graph_node (graph, titles[i]);
+      if (label_func)
+        gdl_set_node_label (node, label_func (i, data));
+    }
+
+  for (i = 0, j = 0; j < edge_num; j++)
+    {
+      if (offsets)
+        while (offsets[i + 1] <= j)
+          i++;
+      else
+        i = sources[j];
+
+      assert (i >= 0 && i < node_num);
+      assert (targets[j] >= 0 && targets[j] < node_num);
+
+      gdl_new_graph_edge (graph, titles[i], titles[targets[j]]);
+    }
+
+  for (i = 0; i < node_num; i++)
+    free (titles[i]);
+  free (titles);
+}
+
+/* Create NODE_NUM nodes and the edges between them in GRAPH with a single
+   allocation.  The title and the label of the node with index I are
+   given by TITLE_FUNC (I, DATA) and LABEL_FUNC (I, DATA).  The titles are
+   copied, and they are "<graph title>.I" if TITLE_FUNC is NULL.  The
+   labels are not copied like gdl_set_node_label, and they are not set if
+   LABEL_FUNC is NULL.
+
+   The edges are given by the node indexes in TARGETS.  The sources are
+   the nodes in SOURCES for the edges in coordinate form (OFFSETS is NULL),
+   or the node I for the edges from OFFSETS[I] to OFFSETS[I + 1] - 1 in
+   compressed row form.  Return the nodes, which are in an array, or NULL
+   if they are created one by one, see new_graph_each.  */
+
+static gdl_node *
+new_graph_bulk (gdl_graph *graph, int node_num, gdl_node_name_func title_func,
+                gdl_node_name_func label_func, void *data, int edge_num,
+                int *offsets, int *sources, int *targets)
+{
+  gdl_bulk *bulk;
+  gdl_node *nodes, *node;
+  gdl_edge *edges, *edge;
+  char *title, *str;
+  size_t size;
+  int i, j, len;
+
+  assert (graph);
+
+  if (node_num == 0)
+    return NULL;
+
+  if (find_budget (graph) != NULL
+      || (graph->aggregate != NULL
+          && graph->aggregate->mode != GDL_AGGREGATE_NONE))
+    {
+      new_graph_each (graph, node_num, title_func, label_func, data,
+                      edge_num, offsets, sources, targets);
+      return NULL;
+    }
+
+  /* Compute the size of the titles.  */
+  size = 0;
+  for (i = 0; i < node_num; i++)
+    {
+      if (title_func)
+        size += strlen (title_func (i, data)) + 1;
+      else
+        size += strlen (graph->title) + snprintf (NULL, 0, ".%d", i) + 1;
+    }
+
+  size += sizeof (gdl_bulk) + node_num * sizeof (gdl_node)
+          + edge_num * sizeof (gdl_edge);
+  bulk = (gdl_bulk *) xmalloc (size);
+  bulk->end = (char *) bulk + size;
+  bulk->next = graph->bulk;
+  graph->bulk = bulk;
+
+  nodes = (gdl_node *) (bulk + 1);
+  edges = (gdl_edge *) (nodes + node_num);
+  str = (char *) (edges + edge_num);
+
+  /* Create the nodes.  */
+  for (i = 0; i < node_num; i++)
+    {
+      node = &nodes[i];
+      memset (node->set_p, 0, GDL_NODE_ATTR_MAX * sizeof (int));
+
+      if (title_func)
+        {
+          title = title_func (i, data);
+          len = strlen (title) + 1;
+          memcpy (str, title, len);
+        }
+      else
+        len = sprintf (str, "%s.%d", graph->title, i) + 1;
+      gdl_set_node_title (node, str);
+      str += len;
+
+      if (label_func)
+        gdl_set_node_label (node, label_func (i, data));
+
+      node->style = NULL;
+      node->next = i + 1 < node_num ? &nodes[i + 1] : NULL;
+      node->parent = graph;
+    }
+
+  if (graph->node == NULL)
+    graph->node = nodes;
+  else
+    graph->last_node->next = nodes;
+  graph->last_node = &nodes[node_num - 1];
+
+  /* Create the edges, which share the titles of the nodes.  */
+  for (i = 0, j = 0; j < edge_num; j++)
+    {
+      if (offsets)
+        while (offsets[i + 1] <= j)
+          i++;
+      else
+        i = sources[j];
+
+      assert (i >= 0 && i < node_num);
+      assert (targets[j] >= 0 && targets[j] < node_num);
+
+      edge = &edges[j];
+      memset (edge->set_p, 0, GDL_EDGE_ATTR_MAX * sizeof (int));
+      gdl_set_edge_sourcename (edge, nodes[i].title);
+      gdl_set_edge_targetname (edge, nodes[targets[j]].title);
+
+      edge->style = NULL;
+      edge->type = GDL_EDGE;
+      edge->next = j + 1 < edge_num ? &edges[j + 1] : NULL;
+      edge->parent = graph;
+    }
+
+  if (edge_num > 0)
+    {
+      if (graph->edge == NULL)
+        graph->edge = edges;
+      else
+        graph->last_edge->next = edges;
+      graph->last_edge = &edges[edge_num - 1];
+    }
+
+  return nodes;
+}
+
+/* Create nodes and edges in bulk, where the edges are given in coordinate
+   form, i.e. the EDGE_NUM edges are from SOURCES[I] to TARGETS[I].  See
+   new_graph_bulk.  */
+
+gdl_node *
+gdl_new_graph_bulk_coo (gdl_graph *graph, int node_num,
+                        gdl_node_name_func title_func,
+                        gdl_node_name_func label_func, void *data,
+                        int edge_num, int *sources, int *targets)
+{
+  return new_graph_bulk (graph, node_num, title_func, label_func, data,
+                         edge_num, NULL, sources, targets);
+}
+
+/* Create nodes and edges in bulk, where the edges are given in compressed
+   row form, i.e. the edges of the node I are to TARGETS[OFFSETS[I]] ...
+   TARGETS[OFFSETS[I + 1] - 1].  See new_graph_bulk.  */
+
+gdl_node *
+gdl_new_graph_bulk_csr (gdl_graph *graph, int node_num,
+                        gdl_node_name_func title_func,
+                        gdl_node_name_func label_func, void *data,
+                        int *offsets, int *targets)
+{
+  return new_graph_bulk (graph, node_num, title_func, label_func, data,
+                         offsets[node_num], offsets, NULL, targets);
+}
+
+/* Copy STR into the string pool of the top graph of GRAPH, so that it is
+   freed together with the graph.  This is for the labels etc., which the
+   graph only refers to.  */
+
+char *
+gdl_graph_strdup (gdl_graph *graph, const char *str)
+{
+  size_t len = strlen (str) + 1, size;
+  gdl_pool *pool;
+  char *p;
+
+  while (graph->parent != NULL)
+    graph = graph->parent;
+
+  pool = graph->pool;
+  if (pool == NULL || (size_t) (pool->end - pool->ptr) < len)
+    {
+      /* A long string gets a block of its own, behind the current one.  */
+      size = len > POOL_BLOCK_SIZE / 4 ? len : POOL_BLOCK_SIZE;
+      pool = (gdl_pool *) xmalloc (sizeof (gdl_pool) + size);
+      pool->ptr = (char *) (pool + 1);
+      pool->end = pool->ptr + size;
+      if (size == len && graph->pool != NULL)
+        {
+          pool->next = graph->pool->next;
+          graph->pool->next = pool;
+        }
+      else
+        {
+          pool->next = graph->pool;
+          graph->pool = pool;
+        }
+    }
+
+  p = pool->ptr;
+  memcpy (p, str, len);
+  pool->ptr += len;
+  return p;
+}
+
+/* Copy the string attribute ATTR of OBJ, if it is set, into the string
+   pool of TOP.  KIND is NODE, EDGE or GRAPH.  */
+
+#define INTERN_ATTR(TOP, OBJ, KIND, ATTR) \
+  do \
+    { \
+      if ((OBJ)->set_p[GDL_##KIND##_ATTR_##ATTR] && (OBJ)->ATTR != NULL) \
+        (OBJ)->ATTR = gdl_graph_strdup ((TOP), (OBJ)->ATTR); \
+    } \
+  while (0)
+
+static void
+intern_graph (gdl_graph *top, gdl_graph *graph)
+{
+  gdl_node *node;
+  gdl_edge *edge;
+  gdl_graph *subgraph;
+
+  INTERN_ATTR (top, graph, GRAPH, label);
+  INTERN_ATTR (top, graph, GRAPH, layout_algorithm);
+  INTERN_ATTR (top, graph, GRAPH, near_edges);
+  INTERN_ATTR (top, graph, GRAPH, node_alignment);
+  INTERN_ATTR (top, graph, GRAPH, orientation);
+  INTERN_ATTR (top, graph, GRAPH, port_sharing);
+  INTERN_ATTR (top, graph, GRAPH, splines);
+
+  /* The objects of a shared graph are not ours to change.  */
+  if (graph->shared != NULL)
+    return;
+
+  for (node = graph->node; node != NULL; node = node->next)
+    INTERN_ATTR (top, node, NODE, label);
+  for (edge = graph->edge; edge != NULL; edge = edge->next)
+    INTERN_ATTR (top, edge, EDGE, label);
+  for (subgraph = graph->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    intern_graph (top, subgraph);
+}
+
+#undef INTERN_ATTR
+
+/* Copy the strings which GRAPH and its objects only refer to, e.g. the
+   labels, into its string pool, so that the graph no longer depends on
+   the memory of its builder, e.g. when it is handed to another thread.
+   The objects of the shared graphs are left alone, their strings are
+   expected to be owned by them already.  */
+
+void
+gdl_intern_graph (gdl_graph *graph)
+{
+  gdl_graph *top;
+
+  for (top = graph; top->parent != NULL; top = top->parent)
+    ;
+  intern_graph (top, graph);
+}
+
+/* Create a style for a given NAME.  */
+
+gdl_style *
+gdl_new_style (char *name)
+{
+  gdl_style *style;
+
+  style = XNEW (gdl_style);
+  memset (style->set_p, 0, GDL_STYLE_ATTR_MAX * sizeof (int));
+
+  /* Duplicate the string.  */
+  style->name = strdup (name);
+
+  return style;
+}
+
 /* Free the NODE.  */
 
 void
@@ -162,21 +723,51 @@ gdl_free_edge (gdl_edge *edge)
   free (edge);
 }
 
-/* Free the GRAPH.  */
+/* Return 1 if P is in one of the bulk blocks of GRAPH.  */
 
-void
-gdl_free_graph (gdl_graph *graph)
+static inline int
+bulk_p (gdl_graph *graph, void *p)
+{
+  gdl_bulk *bulk;
+
+  for (bulk = graph->bulk; bulk != NULL; bulk = bulk->next)
+    if ((char *) p > (char *) bulk && (char *) p < bulk->end)
+      return 1;
+
+  return 0;
+}
+
+/* Free the budget and the merged edges of GRAPH.  */
+
+static void
+free_graph_tables (gdl_graph *graph)
+{
+  if (graph->budget != NULL)
+    gdl_free_budget (graph->budget);
+  if (graph->aggregate != NULL)
+    {
+      htab_delete (graph->aggregate->edges);
+      free (graph->aggregate);
+    }
+}
+
+/* Free the nodes, edges and subgraphs of GRAPH.  */
+
+static void
+free_graph_objects (gdl_graph *graph)
 {
   gdl_graph *subgraphs, *subgraph, *next_subgraph;
   gdl_node *nodes, *node, *next_node;
   gdl_edge *edges, *edge, *next_edge;
+  gdl_bulk *bulk, *next_bulk;
 
   /* Free the nodes.  */
   nodes = gdl_get_graph_node (graph);
   for (node = nodes; node != NULL;)
     {
       next_node = node->next;
-      gdl_free_node (node);
+      if (!bulk_p (graph, node))
+        gdl_free_node (node);
       node = next_node;
     }
 
@@ -185,10 +776,19 @@ gdl_free_graph (gdl_graph *graph)
   for (edge = edges; edge != NULL;)
     {
       next_edge = edge->next;
-      gdl_free_edge (edge);
+      if (!bulk_p (graph, edge))
+        gdl_free_edge (edge);
       edge = next_edge;
     }
 
+  /* Free the nodes and edges created in bulk.  */
+  for (bulk = graph->bulk; bulk != NULL;)
+    {
+      next_bulk = bulk->next;
+      free (bulk);
+      bulk = next_bulk;
+    }
+
   /* Free the subgraphs.  */
   subgraphs = gdl_get_graph_subgraph (graph);
   for (subgraph = subgraphs; subgraph != NULL;)
@@ -197,17 +797,205 @@ gdl_free_graph (gdl_graph *graph)
       gdl_free_graph (subgraph);
       subgraph = next_subgraph;
     }
+}
+
+/* Free the GRAPH.  A graph showing a shared one only drops its
+   reference.  */
+
+void
+gdl_free_graph (gdl_graph *graph)
+{
+  gdl_pool *pool, *next_pool;
+
+  if (graph->shared != NULL)
+    {
+      gdl_unref_graph (graph->shared);
+      free_graph_tables (graph);
+      free (graph->title);
+      free (graph);
+      return;
+    }
+
+  free_graph_objects (graph);
+
+  /* Free the strings.  */
+  for (pool = graph->pool; pool != NULL;)
+    {
+      next_pool = pool->next;
+      free (pool);
+      pool = next_pool;
+    }
+
+  free_graph_tables (graph);
 
   /* Free the graph.  */
   free (graph->title);
   free (graph);
 }
 
+/* Empty the top graph GRAPH for reuse, as if it was just created with
+   its title.  The objects, the attributes and the strings of GRAPH are
+   dropped, but the first block of the string pool is kept, so that
+   filling the graph again does not allocate it again.  */
+
+void
+gdl_clear_graph (gdl_graph *graph)
+{
+  gdl_pool *pool, *next_pool;
+
+  assert (graph->parent == NULL && graph->shared == NULL);
+
+  free_graph_objects (graph);
+  free_graph_tables (graph);
+
+  /* Keep the first block if it has the usual size.  */
+  pool = graph->pool;
+  if (pool != NULL && pool->end - (char *) (pool + 1) == POOL_BLOCK_SIZE)
+    {
+      pool->ptr = (char *) (pool + 1);
+      next_pool = pool->next;
+      pool->next = NULL;
+      pool = next_pool;
+    }
+  else
+    graph->pool = NULL;
+  while (pool != NULL)
+    {
+      next_pool = pool->next;
+      free (pool);
+      pool = next_pool;
+    }
+
+  memset (graph->set_p, 0, GDL_GRAPH_ATTR_MAX * sizeof (int));
+  memset (graph->colorentry_set_p, 0, 256 * sizeof (int));
+  graph->set_p[GDL_GRAPH_ATTR_title] = 1;
+
+  graph->style = NULL;
+  graph->node = NULL;
+  graph->last_node = NULL;
+  graph->subgraph = NULL;
+  graph->last_subgraph = NULL;
+  graph->edge = NULL;
+  graph->last_edge = NULL;
+  graph->budget = NULL;
+  graph->aggregate = NULL;
+}
+
+/* Take a reference to GRAPH.  The count is atomic, so that the graphs
+   sharing GRAPH can be freed by other threads.  */
+
+void
+gdl_ref_graph (gdl_graph *graph)
+{
+  __sync_fetch_and_add (&graph->refcount, 1);
+}
+
+/* Drop a reference to GRAPH, and free it with the last one.  */
+
+void
+gdl_unref_graph (gdl_graph *graph)
+{
+  if (__sync_sub_and_fetch (&graph->refcount, 1) == 0)
+    gdl_free_graph (graph);
+}
+
+/* Free the STYLE.  The nodes, edges and graphs which still refer to it
+   must not be dumped afterwards.  */
+
+void
+gdl_free_style (gdl_style *style)
+{
+  free (style->name);
+  free (style);
+}
+
+/* Link SUBGRAPH into GRAPH, which does not show a shared graph.  */
+
+static void
+link_subgraph (gdl_graph *graph, gdl_graph *subgraph)
+{
+  if (graph->subgraph == NULL)
+    {
+      graph->subgraph = subgraph;
+      graph->last_subgraph = subgraph;
+    }
+  else
+    {
+      graph->last_subgraph->next = subgraph;
+      graph->last_subgraph = subgraph;
+    }
+  subgraph->parent = graph;
+}
+
+/* Make GRAPH, which shows a shared graph, own copies of its objects
+   before it is changed.  The strings of the copies are owned by the
+   graph, see gdl_graph_strdup.  */
+
+static void
+unshare_graph (gdl_graph *graph)
+{
+  gdl_graph *shared = graph->shared, *subgraph, *copy_graph;
+  gdl_node *node, *copy;
+  gdl_edge *edge, *copy_edge;
+  gdl_budget *budget = find_budget (graph);
+
+  graph->shared = NULL;
+  graph->node = graph->last_node = NULL;
+  graph->edge = graph->last_edge = NULL;
+  graph->subgraph = graph->last_subgraph = NULL;
+  if (graph->set_p[GDL_GRAPH_ATTR_label] && graph->label == shared->label)
+    graph->label = gdl_graph_strdup (graph, graph->label);
+
+  for (node = shared->node; node != NULL; node = node->next)
+    {
+      copy = XNEW (gdl_node);
+      *copy = *node;
+      copy->title = xstrdup (node->title);
+      if (node->set_p[GDL_NODE_ATTR_label])
+        copy->label = gdl_graph_strdup (graph, node->label);
+      copy->next = NULL;
+      gdl_add_node (graph, copy);
+      if (budget != NULL)
+        gdl_budget_move_title (budget, copy->title);
+    }
+
+  for (edge = shared->edge; edge != NULL; edge = edge->next)
+    {
+      copy_edge = XNEW (gdl_edge);
+      *copy_edge = *edge;
+      copy_edge->sourcename = xstrdup (edge->sourcename);
+      copy_edge->targetname = xstrdup (edge->targetname);
+      if (edge->set_p[GDL_EDGE_ATTR_label])
+        copy_edge->label = gdl_graph_strdup (graph, edge->label);
+      copy_edge->next = NULL;
+      gdl_add_edge (graph, copy_edge);
+    }
+
+  /* The subgraphs which show shared graphs go on showing them, and the
+     others are copied the same way.  The copies are counted by the
+     budget already, but the titles it refers to may go away.  */
+  for (subgraph = shared->subgraph; subgraph != NULL;
+       subgraph = subgraph->next)
+    {
+      copy_graph = new_graph_proxy (subgraph);
+      link_subgraph (graph, copy_graph);
+      if (budget != NULL)
+        gdl_budget_move_title (budget, copy_graph->title);
+      if (subgraph->shared == NULL)
+        unshare_graph (copy_graph);
+    }
+
+  gdl_unref_graph (shared);
+}
+
 /* Add NODE into GRAPH.  */
 
 void 
 gdl_add_node (gdl_graph *graph, gdl_node *node)
 {
+  if (graph->shared != NULL)
+    unshare_graph (graph);
+
   if (graph->node == NULL)
     {
       graph->node = node;
@@ -226,6 +1014,9 @@ gdl_add_node (gdl_graph *graph, gdl_node *node)
 void 
 gdl_add_edge (gdl_graph *graph, gdl_edge *edge)
 {
+  if (graph->shared != NULL)
+    unshare_graph (graph);
+
   if (graph->edge == NULL)
     {
       graph->edge = edge;
@@ -236,6 +1027,7 @@ gdl_add_edge (gdl_graph *graph, gdl_edge *edge)
       graph->last_edge->next = edge;
       graph->last_edge = edge;
     }
+  edge->parent = graph;
 }
 
 /* Add SUBGRAPH into GRAPH.  */
@@ -243,17 +1035,15 @@ gdl_add_edge (gdl_graph *graph, gdl_edge *edge)
 void 
 gdl_add_subgraph (gdl_graph *graph, gdl_graph *subgraph)
 {
-  if (graph->subgraph == NULL)
-    {
-      graph->subgraph = subgraph;
-      graph->last_subgraph = subgraph;
-    }
-  else
-    {
-      graph->last_subgraph->next = subgraph;
-      graph->last_subgraph = subgraph;
-    }
-  subgraph->parent = graph;
+  gdl_budget *budget;
+
+  if (graph->shared != NULL)
+    unshare_graph (graph);
+  link_subgraph (graph, subgraph);
+
+  budget = find_budget (graph);
+  if (budget != NULL)
+    gdl_budget_add_subgraph (budget, subgraph);
 }
 
 /* Find the node in GRAPH for a given TITLE.  */
@@ -306,43 +1096,160 @@ gdl_find_subgraph (gdl_graph *graph, char *title)
   return NULL;
 }
 
-/* Print the string into the file and add a '\' before each '"'.  */
+/* Collect the default node and edge attributes set by GRAPH into
+   NODE_DEFAULTS and EDGE_DEFAULTS, overriding the ones collected from
+   the enclosing graphs.  */
 
-static inline void
-print_string (FILE *fout, char *str)
+static void
+collect_defaults (gdl_graph *graph, gdl_style *node_defaults,
+                  gdl_style *edge_defaults)
 {
-  int i;
+  if (graph->set_p[GDL_GRAPH_ATTR_node_borderwidth])
+    gdl_set_style_borderwidth (node_defaults, graph->node_borderwidth);
+
+  if (graph->set_p[GDL_GRAPH_ATTR_node_color])
+    gdl_set_style_color (node_defaults, graph->node_color);
+
+  if (graph->set_p[GDL_GRAPH_ATTR_node_shape])
+    gdl_set_style_shape (node_defaults, graph->node_shape);
+
+  if (graph->set_p[GDL_GRAPH_ATTR_edge_color])
+    gdl_set_style_color (edge_defaults, graph->edge_color);
+
+  if (graph->set_p[GDL_GRAPH_ATTR_edge_thickness])
+    gdl_set_style_thickness (edge_defaults, graph->edge_thickness);
+}
+
+/* Like collect_defaults, but for GRAPH and all of its enclosing graphs.  */
+
+static void
+collect_enclosing_defaults (gdl_graph *graph, gdl_style *node_defaults,
+                            gdl_style *edge_defaults)
+{
+  memset (node_defaults->set_p, 0, GDL_STYLE_ATTR_MAX * sizeof (int));
+  memset (edge_defaults->set_p, 0, GDL_STYLE_ATTR_MAX * sizeof (int));
+
+  if (graph == NULL)
+    return;
+
+  collect_enclosing_defaults (graph->parent, node_defaults, edge_defaults);
+  collect_defaults (graph, node_defaults, edge_defaults);
+}
+
+/* Collect the attributes of GRAPH which its subgraphs inherit, set on it
+   or by its style, into GRAPH_DEFAULTS, overriding the ones collected
+   from the enclosing graphs.  */
+
+static void
+collect_graph_defaults (gdl_graph *graph, gdl_style *graph_defaults)
+{
+  gdl_style *style = graph->style;
+
+  if (style != NULL && style->set_p[GDL_STYLE_ATTR_bordercolor])
+    gdl_set_style_bordercolor (graph_defaults, style->bordercolor);
+
+  if (style != NULL && style->set_p[GDL_STYLE_ATTR_borderwidth])
+    gdl_set_style_borderwidth (graph_defaults, style->borderwidth);
+
+  if (graph->set_p[GDL_GRAPH_ATTR_color])
+    gdl_set_style_color (graph_defaults, graph->color);
+  else if (style != NULL && style->set_p[GDL_STYLE_ATTR_color])
+    gdl_set_style_color (graph_defaults, style->color);
+
+  if (graph->set_p[GDL_GRAPH_ATTR_shape])
+    gdl_set_style_shape (graph_defaults, graph->shape);
+  else if (style != NULL && style->set_p[GDL_STYLE_ATTR_shape])
+    gdl_set_style_shape (graph_defaults, style->shape);
+}
 
-  for (i = 0; i < strlen (str); i++)
+/* Like collect_graph_defaults, but for GRAPH and all of its enclosing
+   graphs.  */
+
+static void
+collect_enclosing_graph_defaults (gdl_graph *graph,
+                                  gdl_style *graph_defaults)
+{
+  memset (graph_defaults->set_p, 0, GDL_STYLE_ATTR_MAX * sizeof (int));
+
+  if (graph == NULL)
+    return;
+
+  collect_enclosing_graph_defaults (graph->parent, graph_defaults);
+  collect_graph_defaults (graph, graph_defaults);
+}
+
+/* Return 1 if STYLE sets ATTR to a value which differs from the one in
+   DEFAULTS, i.e. the attribute needs to be dumped.  */
+
+static int
+style_attr_p (gdl_style *style, gdl_style *defaults, enum gdl_style_attr attr)
+{
+  if (style == NULL || !style->set_p[attr])
+    return 0;
+
+  if (!defaults->set_p[attr])
+    return 1;
+
+  switch (attr)
     {
-      if (str[i] == '"')
-        fprintf (fout,  "\\");
-      fprintf (fout, "%c", str[i]);
+    case GDL_STYLE_ATTR_bordercolor:
+      return style->bordercolor != defaults->bordercolor;
+    case GDL_STYLE_ATTR_borderwidth:
+      return style->borderwidth != defaults->borderwidth;
+    case GDL_STYLE_ATTR_color:
+      return style->color != defaults->color;
+    case GDL_STYLE_ATTR_folding:
+      return style->folding != defaults->folding;
+    case GDL_STYLE_ATTR_linestyle:
+      return style->linestyle != defaults->linestyle;
+    case GDL_STYLE_ATTR_shape:
+      return style->shape != defaults->shape;
+    case GDL_STYLE_ATTR_thickness:
+      return style->thickness != defaults->thickness;
+    default:
+      abort ();
     }
 }
 
-/* Dump NODE into the file.  */
+/* Dump NODE into the file.  DEFAULTS are the default node attributes in
+   effect for it.  */
 
-void
-gdl_dump_node (FILE *fout, gdl_node *node)
+static void
+dump_node (FILE *fout, gdl_node *node, gdl_style *defaults)
 {
+  gdl_style *style = node->style;
+
   fputs ("node: {\n", fout);
 
   /* Dump the attributes.  */
 
   if (node->set_p[GDL_NODE_ATTR_bordercolor])
     {
-      fprintf (fout, "bordercolor: %s\n", node->bordercolor);
+      PRINT_SPAN_ATTR (fout, "bordercolor: ",
+                       gdl_color_span (node->bordercolor));
+    }
+  else if (style_attr_p (style, defaults, GDL_STYLE_ATTR_bordercolor))
+    {
+      PRINT_SPAN_ATTR (fout, "bordercolor: ",
+                       gdl_color_span (style->bordercolor));
     }
 
   if (node->set_p[GDL_NODE_ATTR_borderwidth])
     {
       fprintf (fout, "borderwidth: %d\n", node->borderwidth);
     }
+  else if (style_attr_p (style, defaults, GDL_STYLE_ATTR_borderwidth))
+    {
+      fprintf (fout, "borderwidth: %d\n", style->borderwidth);
+    }
 
   if (node->set_p[GDL_NODE_ATTR_color])
     {
-      fprintf (fout, "color: %s\n", node->color);
+      PRINT_SPAN_ATTR (fout, "color: ", gdl_color_span (node->color));
+    }
+  else if (style_attr_p (style, defaults, GDL_STYLE_ATTR_color))
+    {
+      PRINT_SPAN_ATTR (fout, "color: ", gdl_color_span (style->color));
     }
 
   if (node->set_p[GDL_NODE_ATTR_horizontal_order])
@@ -357,6 +1264,11 @@ gdl_dump_node (FILE *fout, gdl_node *node)
       fprintf (fout, "\"\n");
     }
 
+  if (style_attr_p (style, defaults, GDL_STYLE_ATTR_shape))
+    {
+      PRINT_SPAN_ATTR (fout, "shape: ", gdl_shape_span (style->shape));
+    }
+
   if (node->set_p[GDL_NODE_ATTR_title])
     {
       fprintf (fout, "title: \"");
@@ -372,11 +1284,25 @@ gdl_dump_node (FILE *fout, gdl_node *node)
   fputs ("}\n", fout);
 }
 
-/* Dump EDGE into the file.  */
+/* Dump NODE into the file.  */
 
 void
-gdl_dump_edge (FILE *fout, gdl_edge *edge)
+gdl_dump_node (FILE *fout, gdl_node *node)
+{
+  gdl_style node_defaults, edge_defaults;
+
+  collect_enclosing_defaults (node->parent, &node_defaults, &edge_defaults);
+  dump_node (fout, node, &node_defaults);
+}
+
+/* Dump EDGE into the file.  DEFAULTS are the default edge attributes in
+   effect for it.  */
+
+static void
+dump_edge (FILE *fout, gdl_edge *edge, gdl_style *defaults)
 {
+  gdl_style *style = edge->style;
+
   switch (edge->type)
     {
     case GDL_EDGE:
@@ -409,6 +1335,11 @@ gdl_dump_edge (FILE *fout, gdl_edge *edge)
 
   /* Dump the attributes.  */
 
+  if (style_attr_p (style, defaults, GDL_STYLE_ATTR_color))
+    {
+      PRINT_SPAN_ATTR (fout, "color: ", gdl_color_span (style->color));
+    }
+
   if (edge->set_p[GDL_EDGE_ATTR_label])
     {
       fprintf (fout, "label: \"");
@@ -418,7 +1349,13 @@ gdl_dump_edge (FILE *fout, gdl_edge *edge)
 
   if (edge->set_p[GDL_EDGE_ATTR_linestyle])
     {
-      fprintf (fout, "linestyle: %s\n", edge->linestyle);
+      PRINT_SPAN_ATTR (fout, "linestyle: ",
+                       gdl_linestyle_span (edge->linestyle));
+    }
+  else if (style_attr_p (style, defaults, GDL_STYLE_ATTR_linestyle))
+    {
+      PRINT_SPAN_ATTR (fout, "linestyle: ",
+                       gdl_linestyle_span (style->linestyle));
     }
 
   if (edge->set_p[GDL_EDGE_ATTR_sourcename])
@@ -439,19 +1376,38 @@ gdl_dump_edge (FILE *fout, gdl_edge *edge)
     {
       fprintf (fout, "thickness: %d\n", edge->thickness);
     }
+  else if (style_attr_p (style, defaults, GDL_STYLE_ATTR_thickness))
+    {
+      fprintf (fout, "thickness: %d\n", style->thickness);
+    }
 
   fputs ("}\n", fout);
 }
 
-/* Dump GRAPH into the file.  */
+/* Dump EDGE into the file.  */
 
 void
-gdl_dump_graph (FILE *fout, gdl_graph *graph)
+gdl_dump_edge (FILE *fout, gdl_edge *edge)
+{
+  gdl_style node_defaults, edge_defaults;
+
+  collect_enclosing_defaults (edge->parent, &node_defaults, &edge_defaults);
+  dump_edge (fout, edge, &edge_defaults);
+}
+
+/* Dump GRAPH into the file.  NODE_DEFAULTS and EDGE_DEFAULTS are the
+   default node and edge attributes set by the enclosing graphs.  */
+
+static void
+dump_graph (FILE *fout, gdl_graph *graph, gdl_style *graph_defaults,
+            gdl_style *node_defaults, gdl_style *edge_defaults)
 {
   int i;
   gdl_node *nodes, *node;
   gdl_edge *edges, *edge;
   gdl_graph *subgraphs, *subgraph;
+  gdl_style *style = graph->style;
+  gdl_style inner_graph_defaults, inner_node_defaults, inner_edge_defaults;
 
   fputs ("graph: {\n", fout);
 
@@ -467,15 +1423,39 @@ gdl_dump_graph (FILE *fout, gdl_graph *graph)
                    graph->colorentry[i][2]);
     }
 
+  if (style_attr_p (style, graph_defaults, GDL_STYLE_ATTR_bordercolor))
+    {
+      PRINT_SPAN_ATTR (fout, "bordercolor: ",
+                       gdl_color_span (style->bordercolor));
+    }
+
+  if (style_attr_p (style, graph_defaults, GDL_STYLE_ATTR_borderwidth))
+    {
+      fprintf (fout, "borderwidth: %d\n", style->borderwidth);
+    }
+
   if (graph->set_p[GDL_GRAPH_ATTR_color])
     {
-      fprintf (fout, "color: %s\n", graph->color);
+      PRINT_SPAN_ATTR (fout, "color: ", gdl_color_span (graph->color));
+    }
+  else if (style_attr_p (style, graph_defaults, GDL_STYLE_ATTR_color))
+    {
+      PRINT_SPAN_ATTR (fout, "color: ", gdl_color_span (style->color));
     }
 
   if (graph->set_p[GDL_GRAPH_ATTR_folding])
     {
       fprintf (fout, "folding: %d\n", graph->folding);
     }
+  else if (style != NULL && style->set_p[GDL_STYLE_ATTR_folding])
+    {
+      fprintf (fout, "folding: %d\n", style->folding);
+    }
+
+  if (graph->set_p[GDL_GRAPH_ATTR_horizontal_order])
+    {
+      fprintf (fout, "horizontal_order: %d\n", graph->horizontal_order);
+    }
 
   if (graph->set_p[GDL_GRAPH_ATTR_label])
     {
@@ -511,7 +1491,11 @@ gdl_dump_graph (FILE *fout, gdl_graph *graph)
 
   if (graph->set_p[GDL_GRAPH_ATTR_shape])
     {
-      fprintf (fout, "shape: %s\n", graph->shape);
+      PRINT_SPAN_ATTR (fout, "shape: ", gdl_shape_span (graph->shape));
+    }
+  else if (style_attr_p (style, graph_defaults, GDL_STYLE_ATTR_shape))
+    {
+      PRINT_SPAN_ATTR (fout, "shape: ", gdl_shape_span (style->shape));
     }
 
   if (graph->set_p[GDL_GRAPH_ATTR_title])
@@ -543,22 +1527,26 @@ gdl_dump_graph (FILE *fout, gdl_graph *graph)
 
   if (graph->set_p[GDL_GRAPH_ATTR_node_color])
     {
-      fprintf (fout, "node.color: %s\n", graph->node_color);
+      PRINT_SPAN_ATTR (fout, "node.color: ",
+                       gdl_color_span (graph->node_color));
     }
 
   if (graph->set_p[GDL_GRAPH_ATTR_node_shape])
     {
-      fprintf (fout, "node.shape: %s\n", graph->node_shape);
+      PRINT_SPAN_ATTR (fout, "node.shape: ",
+                       gdl_shape_span (graph->node_shape));
     }
 
   if (graph->set_p[GDL_GRAPH_ATTR_node_textcolor])
     {
-      fprintf (fout, "node.textcolor: %s\n", graph->node_textcolor);
+      PRINT_SPAN_ATTR (fout, "node.textcolor: ",
+                       gdl_color_span (graph->node_textcolor));
     }
 
   if (graph->set_p[GDL_GRAPH_ATTR_edge_color])
     {
-      fprintf (fout, "edge.color: %s\n", graph->edge_color);
+      PRINT_SPAN_ATTR (fout, "edge.color: ",
+                       gdl_color_span (graph->edge_color));
     }
 
   if (graph->set_p[GDL_GRAPH_ATTR_edge_thickness])
@@ -566,21 +1554,101 @@ gdl_dump_graph (FILE *fout, gdl_graph *graph)
       fprintf (fout, "edge.thickness: %d\n", graph->edge_thickness);
     }
 
+  /* The defaults in effect for the objects inside the graph.  */
+  inner_graph_defaults = *graph_defaults;
+  inner_node_defaults = *node_defaults;
+  inner_edge_defaults = *edge_defaults;
+  collect_graph_defaults (graph, &inner_graph_defaults);
+  collect_defaults (graph, &inner_node_defaults, &inner_edge_defaults);
+
   /* Dump the nodes.  */
   nodes = gdl_get_graph_node (graph);
   for (node = nodes; node != NULL; node = node->next)
-    gdl_dump_node (fout, node);
+    dump_node (fout, node, &inner_node_defaults);
 
   /* Dump the subgraphs.  */
   subgraphs = gdl_get_graph_subgraph (graph);
   for (subgraph = subgraphs; subgraph != NULL; subgraph = subgraph->next)
-    gdl_dump_graph (fout, subgraph);
+    dump_graph (fout, subgraph, &inner_graph_defaults, &inner_node_defaults,
+                &inner_edge_defaults);
 
   /* Dump the edges.  */
   edges = gdl_get_graph_edge (graph);
   for (edge = edges; edge != NULL; edge = edge->next)
-    gdl_dump_edge (fout, edge);
+    dump_edge (fout, edge, &inner_edge_defaults);
 
   fputs ("}\n", fout);
 }
 
+/* Dump GRAPH into the file.  */
+
+void
+gdl_dump_graph (FILE *fout, gdl_graph *graph)
+{
+  gdl_style graph_defaults, node_defaults, edge_defaults;
+
+  collect_enclosing_graph_defaults (graph->parent, &graph_defaults);
+  collect_enclosing_defaults (graph->parent, &node_defaults, &edge_defaults);
+  dump_graph (fout, graph, &graph_defaults, &node_defaults, &edge_defaults);
+}
+
+/* Dump the attributes of RECORD into the file.  */
+
+static void
+dump_record_attrs (FILE *fout, gdl_record *record)
+{
+  int i;
+  gdl_record_attr *attr;
+
+  for (i = 0; i < record->attr_num; i++)
+    {
+      attr = &record->attrs[i];
+      fputs (attr->key, fout);
+      fputs (": ", fout);
+      if (attr->quoted_p)
+        {
+          fputc ('"', fout);
+          print_string (fout, attr->value);
+          fputc ('"', fout);
+        }
+      else
+        fputs (attr->value, fout);
+      fputc ('\n', fout);
+    }
+}
+
+/* Dump RECORD into the file, the way it was read by gdl_parse_file.  */
+
+void
+gdl_dump_record (FILE *fout, gdl_record *record)
+{
+  const gdl_span *span;
+
+  switch (record->kind)
+    {
+    case GDL_RECORD_GRAPH_BEGIN:
+      fputs ("graph: {\n", fout);
+      dump_record_attrs (fout, record);
+      break;
+    case GDL_RECORD_GRAPH_ATTR:
+      dump_record_attrs (fout, record);
+      break;
+    case GDL_RECORD_NODE:
+      fputs ("node: {\n", fout);
+      dump_record_attrs (fout, record);
+      fputs ("}\n", fout);
+      break;
+    case GDL_RECORD_EDGE:
+      span = gdl_edge_type_span (record->edge_type);
+      fwrite (span->str, 1, span->len, fout);
+      fputs (": {\n", fout);
+      dump_record_attrs (fout, record);
+      fputs ("}\n", fout);
+      break;
+    case GDL_RECORD_GRAPH_END:
+      fputs ("}\n", fout);
+      break;
+    default:
+      abort ();
+    }
+}
@@ -20,30 +20,78 @@
 
 #include <assert.h>
 
+/* A constant string together with its length, so that the writer can
+   emit it without formatting.  */
+
+typedef struct
+{
+  const char *str;
+  int len;
+} gdl_span;
+
+/* The values past the last predefined one of the shapes, colors and line
+   styles refer to arbitrary strings, see gdl_shape_from_name etc.  */
+
 /* shape */
 
-#define GDL_BOX			"box"
-#define GDL_RHOMB		"rhomb"
-#define GDL_ELLIPSE		"ellipse"
-#define GDL_TRIANGLE		"triangle"
+typedef enum
+{
+  GDL_BOX,
+  GDL_RHOMB,
+  GDL_ELLIPSE,
+  GDL_TRIANGLE,
+  GDL_SHAPE_MAX
+} gdl_shape;
 
-/* color */
+/* color, the 32 predefined colors followed by the color entries.  */
 
-#define GDL_COLOR_BLACK		"black"
-#define GDL_COLOR_BLUE		"blue"
-#define GDL_COLOR_LIGHTBLUE	"lightblue"
-#define GDL_COLOR_RED		"red"
-#define GDL_COLOR_GREEN		"green"
-#define GDL_COLOR_YELLOW	"yellow"
-#define GDL_COLOR_WHITE		"white"
-#define GDL_COLOR_LIGHTGREY	"lightgrey"
+typedef enum
+{
+  GDL_COLOR_WHITE,
+  GDL_COLOR_BLUE,
+  GDL_COLOR_RED,
+  GDL_COLOR_GREEN,
+  GDL_COLOR_YELLOW,
+  GDL_COLOR_MAGENTA,
+  GDL_COLOR_CYAN,
+  GDL_COLOR_DARKGREY,
+  GDL_COLOR_DARKBLUE,
+  GDL_COLOR_DARKRED,
+  GDL_COLOR_DARKGREEN,
+  GDL_COLOR_DARKYELLOW,
+  GDL_COLOR_DARKMAGENTA,
+  GDL_COLOR_DARKCYAN,
+  GDL_COLOR_GOLD,
+  GDL_COLOR_LIGHTGREY,
+  GDL_COLOR_LIGHTBLUE,
+  GDL_COLOR_LIGHTRED,
+  GDL_COLOR_LIGHTGREEN,
+  GDL_COLOR_LIGHTYELLOW,
+  GDL_COLOR_LIGHTMAGENTA,
+  GDL_COLOR_LIGHTCYAN,
+  GDL_COLOR_LILAC,
+  GDL_COLOR_TURQUOISE,
+  GDL_COLOR_AQUAMARINE,
+  GDL_COLOR_KHAKI,
+  GDL_COLOR_PURPLE,
+  GDL_COLOR_YELLOWGREEN,
+  GDL_COLOR_PINK,
+  GDL_COLOR_ORANGE,
+  GDL_COLOR_ORCHID,
+  GDL_COLOR_BLACK,
+  GDL_COLOR_MAX = 256
+} gdl_color;
 
 /* line style */
 
-#define GDL_CONTINUOUS		"continuous"
-#define GDL_DASHED		"dashed"
-#define GDL_DOTTED		"dotted"
-#define GDL_INVISIBLE		"invisible"
+typedef enum
+{
+  GDL_CONTINUOUS,
+  GDL_DASHED,
+  GDL_DOTTED,
+  GDL_INVISIBLE,
+  GDL_LINESTYLE_MAX
+} gdl_linestyle;
 
 /* layout algorithm */
 
@@ -53,6 +101,51 @@
 typedef struct gdl_node gdl_node;
 typedef struct gdl_edge gdl_edge;
 typedef struct gdl_graph gdl_graph;
+typedef struct gdl_style gdl_style;
+typedef struct gdl_bulk gdl_bulk;
+typedef struct gdl_pool gdl_pool;
+typedef struct gdl_budget gdl_budget;
+typedef struct gdl_aggregate gdl_aggregate;
+typedef struct gdl_delta gdl_delta;
+
+/* The structural hash of a node, an edge or a graph.  */
+typedef unsigned long long gdl_hashval;
+
+/* The callback to get the title or label of the node with INDEX when the
+   nodes are created in bulk.  */
+typedef char *(*gdl_node_name_func) (int index, void *data);
+
+enum gdl_style_attr
+{
+  GDL_STYLE_ATTR_bordercolor,
+  GDL_STYLE_ATTR_borderwidth,
+  GDL_STYLE_ATTR_color,
+  GDL_STYLE_ATTR_folding,
+  GDL_STYLE_ATTR_linestyle,
+  GDL_STYLE_ATTR_shape,
+  GDL_STYLE_ATTR_thickness,
+  GDL_STYLE_ATTR_MAX
+};
+
+/* A named attribute preset, which is shared by nodes, edges and graphs
+   by pointer.  Only the attributes that apply to the referencing object
+   are used, and the attributes set on the object itself take precedence
+   over its style.  */
+
+struct gdl_style
+{
+  gdl_color bordercolor;
+  int borderwidth;
+  gdl_color color;
+  int folding;
+  gdl_linestyle linestyle;
+  gdl_shape shape;
+  int thickness;
+  /* The value is 1 if the attribute is set.  */
+  int set_p[GDL_STYLE_ATTR_MAX];
+
+  char *name;
+};
 
 enum gdl_node_attr
 {
@@ -68,9 +161,9 @@ enum gdl_node_attr
 
 struct gdl_node 
 {
-  char *bordercolor;
+  gdl_color bordercolor;
   int borderwidth;
-  char *color;
+  gdl_color color;
   int horizontal_order;
   char *label;
   char *title;
@@ -78,6 +171,7 @@ struct gdl_node
   /* The value is 1 if the attribute is set.  */
   int set_p[GDL_NODE_ATTR_MAX];
 
+  gdl_style *style;
   gdl_node *next;
   /* The graph who it belongs to.  */
   gdl_graph *parent;
@@ -95,6 +189,21 @@ typedef enum
   GDL_RIGHTBENTNEAREDGE 
 } gdl_edge_type;
 
+/* How the parallel edges added to a graph are merged, see
+   gdl_set_graph_edge_aggregation.  */
+
+typedef enum
+{
+  GDL_AGGREGATE_NONE,
+  /* The label of a merged edge is the number of edges.  */
+  GDL_AGGREGATE_LABEL,
+  /* The thickness of a merged edge grows with the number of edges.  */
+  GDL_AGGREGATE_THICKNESS
+} gdl_aggregate_mode;
+
+/* The thickness of a merged edge is capped.  */
+#define GDL_MAX_AGGREGATE_THICKNESS 8
+
 enum gdl_edge_attr
 {
   GDL_EDGE_ATTR_label,
@@ -108,15 +217,18 @@ enum gdl_edge_attr
 struct gdl_edge
 {
   char *label;
-  char *linestyle;
+  gdl_linestyle linestyle;
   char *sourcename;
   char *targetname;
   int thickness;
   /* The value is 1 if the attribute is set.  */
   int set_p[GDL_EDGE_ATTR_MAX];
 
+  gdl_style *style;
   gdl_edge_type type;
   gdl_edge *next;
+  /* The graph who it belongs to.  */
+  gdl_graph *parent;
 };
 
 enum gdl_graph_attr
@@ -124,6 +236,7 @@ enum gdl_graph_attr
   GDL_GRAPH_ATTR_color,
   GDL_GRAPH_ATTR_colorentry,
   GDL_GRAPH_ATTR_folding,
+  GDL_GRAPH_ATTR_horizontal_order,
   GDL_GRAPH_ATTR_label,
   GDL_GRAPH_ATTR_layout_algorithm,
   GDL_GRAPH_ATTR_near_edges,
@@ -149,16 +262,17 @@ enum gdl_graph_attr
 
 struct gdl_graph
 {
-  char *color;
+  gdl_color color;
   int colorentry[256][3];
   int folding;
+  int horizontal_order;
   char *label;
   char *layout_algorithm;
   char *near_edges;
   char *node_alignment;
   char *orientation;
   char *port_sharing;
-  char *shape;
+  gdl_shape shape;
   char *splines;
   char *title;
   int vertical_order;
@@ -166,16 +280,18 @@ struct gdl_graph
   int yspace;
 
   int node_borderwidth;
-  char *node_color;
-  char *node_shape;
-  char *node_textcolor;
+  gdl_color node_color;
+  gdl_shape node_shape;
+  gdl_color node_textcolor;
 
-  char *edge_color;
+  gdl_color edge_color;
   int edge_thickness;
   /* The value is 1 if the attribute is set.  */
   int set_p[GDL_GRAPH_ATTR_MAX];
   int colorentry_set_p[256];
 
+  gdl_style *style;
+
   /* nodes or subgraphs */
   int node_num;
   int subgraph_num;
@@ -189,36 +305,51 @@ struct gdl_graph
   gdl_graph *next;
   /* The graph who it belongs to.  */
   gdl_graph *parent;
+  /* The blocks of nodes and edges created in bulk.  */
+  gdl_bulk *bulk;
+  /* The blocks of strings owned by the graph, see gdl_graph_strdup.  */
+  gdl_pool *pool;
+  /* The size limits of the graph, see gdl_set_graph_budget.  */
+  gdl_budget *budget;
+  /* The graph whose objects this one shows, see gdl_new_graph_shared.  */
+  gdl_graph *shared;
+  /* The references to the graph, which is freed with the last one.  */
+  int refcount;
+  /* The parallel edges merged so far, see
+     gdl_set_graph_edge_aggregation.  */
+  gdl_aggregate *aggregate;
 };
 
-extern char *gdl_get_node_bordercolor (gdl_node *node);
+extern gdl_color gdl_get_node_bordercolor (gdl_node *node);
 extern int gdl_get_node_borderwidth (gdl_node *node);
-extern char *gdl_get_node_color (gdl_node *node);
+extern gdl_color gdl_get_node_color (gdl_node *node);
+extern int gdl_get_node_horizontal_order (gdl_node *node);
 extern char *gdl_get_node_label (gdl_node *node);
 extern char *gdl_get_node_title (gdl_node *node);
 extern int gdl_get_node_vertical_order (gdl_node *node);
 extern char *gdl_get_edge_label (gdl_edge *edge);
-extern char *gdl_get_edge_linestyle (gdl_edge *edge);
+extern gdl_linestyle gdl_get_edge_linestyle (gdl_edge *edge);
 extern char *gdl_get_edge_sourcename (gdl_edge *edge);
 extern char *gdl_get_edge_targetname (gdl_edge *edge);
 extern int gdl_get_edge_thickness (gdl_edge *edge);
-extern char *gdl_get_graph_color (gdl_graph *graph);
+extern gdl_color gdl_get_graph_color (gdl_graph *graph);
 extern int gdl_get_graph_folding (gdl_graph *graph);
+extern int gdl_get_graph_horizontal_order (gdl_graph *graph);
 extern char *gdl_get_graph_label (gdl_graph *graph);
 extern char *gdl_get_graph_layout_algorithm (gdl_graph *graph);
 extern char *gdl_get_graph_near_edges (gdl_graph *graph);
 extern char *gdl_get_graph_orientation (gdl_graph *graph);
 extern char *gdl_get_graph_port_sharing (gdl_graph *graph);
-extern char *gdl_get_graph_shape (gdl_graph *graph);
+extern gdl_shape gdl_get_graph_shape (gdl_graph *graph);
 extern char *gdl_get_graph_splines (gdl_graph *graph);
 extern char *gdl_get_graph_title (gdl_graph *graph);
 extern int gdl_get_graph_vertical_order (gdl_graph *graph);
 extern int gdl_get_graph_xspace (gdl_graph *graph);
 extern int gdl_get_graph_yspace (gdl_graph *graph);
 extern int gdl_get_graph_node_borderwidth (gdl_graph *graph);
-extern char *gdl_get_graph_node_color (gdl_graph *graph);
-extern char *gdl_get_graph_node_shape (gdl_graph *graph);
-extern char *gdl_get_graph_edge_color (gdl_graph *graph);
+extern gdl_color gdl_get_graph_node_color (gdl_graph *graph);
+extern gdl_shape gdl_get_graph_node_shape (gdl_graph *graph);
+extern gdl_color gdl_get_graph_edge_color (gdl_graph *graph);
 extern int gdl_get_graph_edge_thickness (gdl_graph *graph);
 extern gdl_node *gdl_get_graph_node (gdl_graph *graph);
 extern gdl_edge *gdl_get_graph_edge (gdl_graph *graph);
@@ -226,42 +357,68 @@ extern gdl_graph *gdl_get_graph_subgraph (gdl_graph *graph);
 extern gdl_graph *gdl_get_graph_parent (gdl_graph *graph);
 extern gdl_graph *gdl_get_node_parent (gdl_node *node);
 extern gdl_edge_type gdl_get_edge_type (gdl_edge *edge);
+extern gdl_style *gdl_get_node_style (gdl_node *node);
+extern gdl_style *gdl_get_edge_style (gdl_edge *edge);
+extern gdl_style *gdl_get_graph_style (gdl_graph *graph);
+extern char *gdl_get_style_name (gdl_style *style);
 
-extern void gdl_set_node_bordercolor (gdl_node *node, char *value);
+extern void gdl_set_node_bordercolor (gdl_node *node, gdl_color value);
 extern void gdl_set_node_borderwidth (gdl_node *node, int value);
-extern void gdl_set_node_color (gdl_node *node, char *value);
+extern void gdl_set_node_color (gdl_node *node, gdl_color value);
 extern void gdl_set_node_horizontal_order (gdl_node *node, int value);
 extern void gdl_set_node_label (gdl_node *node, char *value);
 extern void gdl_set_node_title (gdl_node *node, char *value);
 extern void gdl_set_node_vertical_order (gdl_node *node, int value);
 extern void gdl_set_edge_label (gdl_edge *edge, char *value);
-extern void gdl_set_edge_linestyle (gdl_edge *edge, char *value);
+extern void gdl_set_edge_linestyle (gdl_edge *edge, gdl_linestyle value);
 extern void gdl_set_edge_sourcename (gdl_edge *edge, char *value);
 extern void gdl_set_edge_targetname (gdl_edge *edge, char *value);
 extern void gdl_set_edge_thickness (gdl_edge *edge, int value);
-extern void gdl_set_graph_color (gdl_graph *graph, char *value);
+extern void gdl_set_graph_color (gdl_graph *graph, gdl_color value);
 extern void gdl_set_graph_colorentry (gdl_graph *graph, int id,
                                       int r, int g, int b);
 extern void gdl_set_graph_folding (gdl_graph *graph, int value);
+extern void gdl_set_graph_horizontal_order (gdl_graph *graph, int value);
 extern void gdl_set_graph_label (gdl_graph *graph, char *value);
 extern void gdl_set_graph_layout_algorithm (gdl_graph *graph, char *value);
 extern void gdl_set_graph_near_edges (gdl_graph *graph, char *value);
 extern void gdl_set_graph_node_alignment (gdl_graph *graph, char *value);
 extern void gdl_set_graph_orientation (gdl_graph *graph, char *value);
 extern void gdl_set_graph_port_sharing (gdl_graph *graph, char *value);
-extern void gdl_set_graph_shape (gdl_graph *graph, char *value);
+extern void gdl_set_graph_shape (gdl_graph *graph, gdl_shape value);
 extern void gdl_set_graph_splines (gdl_graph *graph, char *value);
 extern void gdl_set_graph_title (gdl_graph *graph, char *value);
 extern void gdl_set_graph_vertical_order (gdl_graph *graph, int value);
 extern void gdl_set_graph_xspace (gdl_graph *graph, int value);
 extern void gdl_set_graph_yspace (gdl_graph *graph, int value);
 extern void gdl_set_graph_node_borderwidth (gdl_graph *graph, int value);
-extern void gdl_set_graph_node_color (gdl_graph *graph, char *value);
-extern void gdl_set_graph_node_shape (gdl_graph *graph, char *value);
-extern void gdl_set_graph_node_textcolor (gdl_graph *graph, char *value);
-extern void gdl_set_graph_edge_color (gdl_graph *graph, char *value);
+extern void gdl_set_graph_node_color (gdl_graph *graph, gdl_color value);
+extern void gdl_set_graph_node_shape (gdl_graph *graph, gdl_shape value);
+extern void gdl_set_graph_node_textcolor (gdl_graph *graph, gdl_color value);
+extern void gdl_set_graph_edge_color (gdl_graph *graph, gdl_color value);
 extern void gdl_set_graph_edge_thickness (gdl_graph *graph, int value);
 extern void gdl_set_edge_type (gdl_edge *edge, gdl_edge_type type);
+extern void gdl_set_node_style (gdl_node *node, gdl_style *style);
+extern void gdl_set_edge_style (gdl_edge *edge, gdl_style *style);
+extern void gdl_set_graph_style (gdl_graph *graph, gdl_style *style);
+extern void gdl_set_style_bordercolor (gdl_style *style, gdl_color value);
+extern void gdl_set_style_borderwidth (gdl_style *style, int value);
+extern void gdl_set_style_color (gdl_style *style, gdl_color value);
+extern void gdl_set_style_folding (gdl_style *style, int value);
+extern void gdl_set_style_linestyle (gdl_style *style, gdl_linestyle value);
+extern void gdl_set_style_shape (gdl_style *style, gdl_shape value);
+extern void gdl_set_style_thickness (gdl_style *style, int value);
+
+extern gdl_shape gdl_shape_from_name (char *name);
+extern gdl_color gdl_color_from_name (char *name);
+extern gdl_linestyle gdl_linestyle_from_name (char *name);
+extern const gdl_span *gdl_shape_span (gdl_shape shape);
+extern const gdl_span *gdl_color_span (gdl_color color);
+extern const gdl_span *gdl_linestyle_span (gdl_linestyle linestyle);
+extern int gdl_edge_type_from_name (char *name);
+extern const gdl_span *gdl_edge_type_span (gdl_edge_type type);
+extern int gdl_get_color_rgb (gdl_graph *graph, gdl_color color,
+                              int rgb[3]);
 
 extern gdl_graph *gdl_new_graph (char *title); 
 extern gdl_node *gdl_new_node (char *title);
@@ -271,10 +428,34 @@ extern gdl_edge *gdl_new_graph_edge (gdl_graph *graph,
                                      char *source, char *target);
 extern gdl_graph *gdl_new_graph (char *title); 
 extern gdl_graph *gdl_new_graph_subgraph (gdl_graph *graph, char *title); 
+extern gdl_graph *gdl_new_graph_shared (gdl_graph *graph, gdl_graph *shared);
+extern char *gdl_graph_strdup (gdl_graph *graph, const char *str);
+extern void gdl_intern_graph (gdl_graph *graph);
+extern void gdl_set_graph_budget (gdl_graph *graph, int max_nodes,
+                                  int max_edges, long max_label_bytes);
+extern long gdl_graph_label_room (gdl_graph *graph);
+extern void gdl_set_graph_edge_aggregation (gdl_graph *graph,
+                                            gdl_aggregate_mode mode);
+extern int gdl_get_edge_multiplicity (gdl_edge *edge);
+extern gdl_node *gdl_new_graph_bulk_coo (gdl_graph *graph, int node_num,
+                                         gdl_node_name_func title_func,
+                                         gdl_node_name_func label_func,
+                                         void *data, int edge_num,
+                                         int *sources, int *targets);
+extern gdl_node *gdl_new_graph_bulk_csr (gdl_graph *graph, int node_num,
+                                         gdl_node_name_func title_func,
+                                         gdl_node_name_func label_func,
+                                         void *data, int *offsets,
+                                         int *targets);
+extern gdl_style *gdl_new_style (char *name);
 
 extern void gdl_free_node (gdl_node *node);
 extern void gdl_free_edge (gdl_edge *edge);
 extern void gdl_free_graph (gdl_graph *graph);
+extern void gdl_clear_graph (gdl_graph *graph);
+extern void gdl_free_style (gdl_style *style);
+extern void gdl_ref_graph (gdl_graph *graph);
+extern void gdl_unref_graph (gdl_graph *graph);
 
 extern void gdl_add_node (gdl_graph *graph, gdl_node *node); 
 extern void gdl_add_edge (gdl_graph *graph, gdl_edge *edge);
@@ -284,8 +465,95 @@ extern gdl_node *gdl_find_node (gdl_graph *graph, char *title);
 extern gdl_edge *gdl_find_edge (gdl_graph *graph, char *source, char *target);
 extern gdl_graph *gdl_find_subgraph (gdl_graph *graph, char *title);
 
+/* The streaming parser.  It reports a gdl file as a sequence of records
+   instead of building the graphs, so that the memory used is bounded by
+   the largest record.  */
+
+typedef enum
+{
+  /* A graph, with the attributes which come before its first node, edge
+     or subgraph.  */
+  GDL_RECORD_GRAPH_BEGIN,
+  /* An attribute of a graph which comes after its first node, edge or
+     subgraph.  */
+  GDL_RECORD_GRAPH_ATTR,
+  GDL_RECORD_NODE,
+  GDL_RECORD_EDGE,
+  GDL_RECORD_GRAPH_END
+} gdl_record_kind;
+
+typedef struct
+{
+  char *key;
+  char *value;
+  /* The value is 1 if the value is a quoted string.  */
+  int quoted_p;
+} gdl_record_attr;
+
+typedef struct
+{
+  gdl_record_kind kind;
+  /* The type of an edge record.  */
+  gdl_edge_type edge_type;
+  /* The nesting depth of the graph which the record belongs to, or which
+     it begins or ends.  The top graph is at depth 0.  */
+  int depth;
+  /* The line of the input where the record starts.  */
+  int line;
+  int attr_num;
+  gdl_record_attr *attrs;
+} gdl_record;
+
+/* The callback to receive each record, the parsing stops if it returns
+   nonzero.  The record is only valid during the call.  */
+typedef int (*gdl_record_func) (gdl_record *record, void *data);
+
+extern int gdl_parse_file (FILE *fin, gdl_record_func func, void *data,
+                           int *error_line);
+extern char *gdl_get_record_attr (gdl_record *record, const char *key);
+extern gdl_graph *gdl_read_graph (FILE *fin, int *error_line);
+extern void gdl_dump_record (FILE *fout, gdl_record *record);
+
+extern int gdl_layout_graph (gdl_graph *graph, int max_iterations);
+
+extern gdl_hashval gdl_hash_node (gdl_node *node);
+extern gdl_hashval gdl_hash_edge (gdl_edge *edge);
+extern gdl_hashval gdl_hash_graph (gdl_graph *graph);
+
+/* The counts of the objects found by gdl_diff_graph.  */
+
+typedef struct
+{
+  int added_nodes;
+  int removed_nodes;
+  int relabeled_nodes;
+  int same_nodes;
+  int added_subgraphs;
+  int removed_subgraphs;
+  int same_subgraphs;
+  int added_edges;
+  int removed_edges;
+  int same_edges;
+} gdl_diff_summary;
+
+extern void gdl_diff_graph (gdl_graph *old_graph, gdl_graph *new_graph,
+                            gdl_diff_summary *summary);
+extern int gdl_diff_summary_changed_p (gdl_diff_summary *summary);
+extern void gdl_dump_diff_summary (FILE *fout, gdl_diff_summary *summary);
+
 extern void gdl_dump_node (FILE *fout, gdl_node *node);
 extern void gdl_dump_edge (FILE *fout, gdl_edge *edge);
 extern void gdl_dump_graph (FILE *fout, gdl_graph *graph);
+extern void gdl_dump_graph_dot (FILE *fout, gdl_graph *graph);
+extern void gdl_dump_graph_jsonl (FILE *fout, gdl_graph *graph);
+extern void gdl_dump_graph_svg (FILE *fout, gdl_graph *graph,
+                                int max_nodes);
+
+extern gdl_delta *gdl_new_delta (FILE *fout);
+extern int gdl_dump_delta_step (gdl_delta *delta, const char *name,
+                                gdl_graph *graph);
+extern void gdl_free_delta (gdl_delta *delta);
+extern gdl_graph *gdl_read_delta (FILE *fin, int step, char **name,
+                                  int *error_line);
 
 #endif
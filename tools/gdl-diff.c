@@ -0,0 +1,99 @@
+/* The diff command of gdl-tool.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* Both files are read into graphs, and the new one is turned into the
+   colored difference graph by gdl_diff_graph.  The summary goes to the
+   standard error if the graph goes to the standard output.  The exit
+   status is 0 if the graphs do not differ, and 1 otherwise, like
+   diff (1).  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gdl-tool.h"
+
+/* Read the file FNAME into a graph.  Return NULL on error.  */
+
+static gdl_graph *
+read_input (const char *fname)
+{
+  FILE *fin;
+  gdl_graph *graph;
+  int line;
+
+  if ((fin = open_input (fname)) == NULL)
+    return NULL;
+
+  graph = gdl_read_graph (fin, &line);
+  if (graph == NULL)
+    tool_error ("%s:%d: syntax error.", fname, line);
+
+  close_input (fin);
+  return graph;
+}
+
+int
+do_diff (int argc, char **argv)
+{
+  gdl_graph *old_graph, *new_graph;
+  gdl_diff_summary summary;
+  const char *output = NULL;
+  FILE *fout = stdout;
+  int ret;
+
+  if (argc > 1 && !strcmp (argv[0], "-o"))
+    {
+      output = argv[1];
+      argc -= 2;
+      argv += 2;
+    }
+  if (argc != 2)
+    return -1;
+
+  if ((old_graph = read_input (argv[0])) == NULL)
+    return 2;
+  if ((new_graph = read_input (argv[1])) == NULL)
+    {
+      gdl_free_graph (old_graph);
+      return 2;
+    }
+
+  gdl_diff_graph (old_graph, new_graph, &summary);
+  ret = gdl_diff_summary_changed_p (&summary);
+
+  if (output != NULL && (fout = fopen (output, "w")) == NULL)
+    {
+      tool_error ("failed to open file %s.", output);
+      ret = 2;
+    }
+  else
+    {
+      gdl_dump_graph (fout, new_graph);
+      if (fout != stdout)
+        {
+          fclose (fout);
+          gdl_dump_diff_summary (stdout, &summary);
+        }
+      else
+        gdl_dump_diff_summary (stderr, &summary);
+    }
+
+  gdl_free_graph (old_graph);
+  gdl_free_graph (new_graph);
+  return ret;
+}
@@ -0,0 +1,529 @@
+/* Merge of gdl files into a single graph.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* The files are parsed in parallel by a pool of threads, each taking the
+   next file which is not parsed yet.  The nodes are unified by title and
+   the edges by their ends and type, in hash tables which are split into
+   shards with a lock each, so that the threads rarely wait for each
+   other.  The subgraphs are flattened.
+
+   A node keeps the attributes it has in the first file, in the order of
+   the command line, and an edge gets the number of times it appears as
+   its label, and as its thickness up to GDL_MAX_AGGREGATE_THICKNESS like
+   the edges merged by gdl_set_graph_edge_aggregation.  The output lists the nodes and edges in the order they
+   first appear, so it does not depend on the scheduling of the
+   threads.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <libiberty.h>
+#include <hashtab.h>
+
+#include "gdl-tool.h"
+
+#define SHARD_NUM 64
+
+/* A copy of the attributes of a record, with the strings in the same
+   block.  */
+
+typedef struct
+{
+  int attr_num;
+  gdl_record_attr *attrs;
+} attr_copy;
+
+typedef struct
+{
+  char *title;
+  attr_copy copy;
+  /* The file and the record where the node first appears.  */
+  unsigned long long order;
+} merged_node;
+
+typedef struct
+{
+  char *source;
+  char *target;
+  gdl_edge_type type;
+  long count;
+  unsigned long long order;
+} merged_edge;
+
+typedef struct
+{
+  pthread_mutex_t lock;
+  htab_t nodes;
+  htab_t edges;
+} shard;
+
+typedef struct
+{
+  shard shards[SHARD_NUM];
+
+  char **files;
+  int file_num;
+  int next_file;
+  pthread_mutex_t lock;
+
+  /* The attributes of the top graph, from the first file.  */
+  attr_copy top;
+  int top_file;
+
+  int error_p;
+} merge_state;
+
+/* What a thread knows about the file it parses.  */
+
+typedef struct
+{
+  merge_state *ms;
+  int file;
+  unsigned int seq;
+} merge_worker;
+
+/* Copy the attributes of RECORD into COPY, without the ones named
+   SKIP.  */
+
+static void
+copy_attrs (attr_copy *copy, gdl_record *record, const char *skip)
+{
+  int i, n = 0;
+  size_t size = 0;
+  char *p;
+  size_t len;
+
+  for (i = 0; i < record->attr_num; i++)
+    size += strlen (record->attrs[i].key) + strlen (record->attrs[i].value)
+            + 2;
+
+  copy->attrs = (gdl_record_attr *) xmalloc (record->attr_num
+                                             * sizeof (gdl_record_attr)
+                                             + size);
+  p = (char *) (copy->attrs + record->attr_num);
+  for (i = 0; i < record->attr_num; i++)
+    {
+      if (!strcmp (record->attrs[i].key, skip))
+        continue;
+      len = strlen (record->attrs[i].key) + 1;
+      copy->attrs[n].key = memcpy (p, record->attrs[i].key, len);
+      p += len;
+      len = strlen (record->attrs[i].value) + 1;
+      copy->attrs[n].value = memcpy (p, record->attrs[i].value, len);
+      p += len;
+      copy->attrs[n].quoted_p = record->attrs[i].quoted_p;
+      n++;
+    }
+  copy->attr_num = n;
+}
+
+static hashval_t
+node_hash (const void *p)
+{
+  return htab_hash_string (((const merged_node *) p)->title);
+}
+
+static int
+node_eq (const void *p1, const void *p2)
+{
+  return !strcmp (((const merged_node *) p1)->title,
+                  ((const merged_node *) p2)->title);
+}
+
+static void
+node_del (void *p)
+{
+  merged_node *node = (merged_node *) p;
+
+  free (node->title);
+  free (node->copy.attrs);
+  free (node);
+}
+
+static hashval_t
+edge_hash_1 (const char *source, const char *target, gdl_edge_type type)
+{
+  return (htab_hash_string (source) * 31 + htab_hash_string (target)) * 8
+         + type;
+}
+
+static hashval_t
+edge_hash (const void *p)
+{
+  const merged_edge *edge = (const merged_edge *) p;
+
+  return edge_hash_1 (edge->source, edge->target, edge->type);
+}
+
+static int
+edge_eq (const void *p1, const void *p2)
+{
+  const merged_edge *e1 = (const merged_edge *) p1;
+  const merged_edge *e2 = (const merged_edge *) p2;
+
+  return e1->type == e2->type && !strcmp (e1->source, e2->source)
+         && !strcmp (e1->target, e2->target);
+}
+
+static void
+edge_del (void *p)
+{
+  merged_edge *edge = (merged_edge *) p;
+
+  free (edge->source);
+  free (edge->target);
+  free (edge);
+}
+
+/* Add the node RECORD, titled TITLE, into the merged graph.  */
+
+static void
+merge_node (merge_worker *w, gdl_record *record, char *title,
+            unsigned long long order)
+{
+  merged_node key, *node;
+  hashval_t hash;
+  shard *sh;
+  void **slot;
+
+  key.title = title;
+  hash = htab_hash_string (title);
+  sh = &w->ms->shards[hash % SHARD_NUM];
+
+  pthread_mutex_lock (&sh->lock);
+  slot = htab_find_slot_with_hash (sh->nodes, &key, hash, INSERT);
+  node = (merged_node *) *slot;
+  if (node == NULL)
+    {
+      node = XNEW (merged_node);
+      node->title = xstrdup (title);
+      copy_attrs (&node->copy, record, "");
+      node->order = order;
+      *slot = node;
+    }
+  else if (order < node->order)
+    {
+      free (node->copy.attrs);
+      copy_attrs (&node->copy, record, "");
+      node->order = order;
+    }
+  pthread_mutex_unlock (&sh->lock);
+}
+
+/* Add the edge RECORD from SOURCE to TARGET into the merged graph.  */
+
+static void
+merge_edge (merge_worker *w, gdl_record *record, char *source, char *target,
+            unsigned long long order)
+{
+  merged_edge key, *edge;
+  hashval_t hash;
+  shard *sh;
+  void **slot;
+
+  key.source = source;
+  key.target = target;
+  key.type = record->edge_type;
+  hash = edge_hash_1 (source, target, record->edge_type);
+  sh = &w->ms->shards[hash % SHARD_NUM];
+
+  pthread_mutex_lock (&sh->lock);
+  slot = htab_find_slot_with_hash (sh->edges, &key, hash, INSERT);
+  edge = (merged_edge *) *slot;
+  if (edge == NULL)
+    {
+      edge = XNEW (merged_edge);
+      edge->source = xstrdup (source);
+      edge->target = xstrdup (target);
+      edge->type = record->edge_type;
+      edge->count = 0;
+      edge->order = order;
+      *slot = edge;
+    }
+  edge->count++;
+  if (order < edge->order)
+    edge->order = order;
+  pthread_mutex_unlock (&sh->lock);
+}
+
+static int
+merge_record (gdl_record *record, void *data)
+{
+  merge_worker *w = (merge_worker *) data;
+  merge_state *ms = w->ms;
+  unsigned long long order;
+  char *title, *source, *target;
+
+  order = ((unsigned long long) w->file << 32) | w->seq++;
+  switch (record->kind)
+    {
+    case GDL_RECORD_GRAPH_BEGIN:
+      if (record->depth != 0)
+        break;
+      pthread_mutex_lock (&ms->lock);
+      if (w->file < ms->top_file)
+        {
+          free (ms->top.attrs);
+          copy_attrs (&ms->top, record, "title");
+          ms->top_file = w->file;
+        }
+      pthread_mutex_unlock (&ms->lock);
+      break;
+    case GDL_RECORD_NODE:
+      if ((title = gdl_get_record_attr (record, "title")) != NULL)
+        merge_node (w, record, title, order);
+      break;
+    case GDL_RECORD_EDGE:
+      source = gdl_get_record_attr (record, "sourcename");
+      target = gdl_get_record_attr (record, "targetname");
+      if (source != NULL && target != NULL)
+        merge_edge (w, record, source, target, order);
+      break;
+    default:
+      break;
+    }
+  return 0;
+}
+
+/* The body of each thread.  */
+
+static void *
+merge_thread (void *data)
+{
+  merge_state *ms = (merge_state *) data;
+  merge_worker w;
+
+  w.ms = ms;
+  while (1)
+    {
+      pthread_mutex_lock (&ms->lock);
+      w.file = ms->next_file++;
+      pthread_mutex_unlock (&ms->lock);
+      if (w.file >= ms->file_num)
+        break;
+
+      w.seq = 0;
+      if (parse_input (ms->files[w.file], merge_record, &w) < 0)
+        {
+          pthread_mutex_lock (&ms->lock);
+          ms->error_p = 1;
+          pthread_mutex_unlock (&ms->lock);
+        }
+    }
+  return NULL;
+}
+
+/* Collect the entries of a hash table into an array.  */
+
+typedef struct
+{
+  void **entries;
+  size_t num;
+} collector;
+
+static int
+collect_entry (void **slot, void *data)
+{
+  collector *c = (collector *) data;
+
+  c->entries[c->num++] = *slot;
+  return 1;
+}
+
+static int
+node_order_cmp (const void *p1, const void *p2)
+{
+  const merged_node *n1 = *(const merged_node * const *) p1;
+  const merged_node *n2 = *(const merged_node * const *) p2;
+
+  return n1->order < n2->order ? -1 : n1->order > n2->order;
+}
+
+static int
+edge_order_cmp (const void *p1, const void *p2)
+{
+  const merged_edge *e1 = *(const merged_edge * const *) p1;
+  const merged_edge *e2 = *(const merged_edge * const *) p2;
+
+  return e1->order < e2->order ? -1 : e1->order > e2->order;
+}
+
+/* Write the merged graph into FOUT.  */
+
+static void
+write_merged (FILE *fout, merge_state *ms)
+{
+  collector nodes, edges;
+  size_t node_num = 0, edge_num = 0, i;
+  gdl_record record;
+  gdl_record_attr attrs[4];
+  char label[32], thickness[32];
+  merged_node *node;
+  merged_edge *edge;
+  int k;
+
+  for (k = 0; k < SHARD_NUM; k++)
+    {
+      node_num += htab_elements (ms->shards[k].nodes);
+      edge_num += htab_elements (ms->shards[k].edges);
+    }
+  nodes.entries = XNEWVEC (void *, node_num + 1);
+  nodes.num = 0;
+  edges.entries = XNEWVEC (void *, edge_num + 1);
+  edges.num = 0;
+  for (k = 0; k < SHARD_NUM; k++)
+    {
+      htab_traverse_noresize (ms->shards[k].nodes, collect_entry, &nodes);
+      htab_traverse_noresize (ms->shards[k].edges, collect_entry, &edges);
+    }
+  qsort (nodes.entries, nodes.num, sizeof (void *), node_order_cmp);
+  qsort (edges.entries, edges.num, sizeof (void *), edge_order_cmp);
+
+  memset (&record, 0, sizeof (record));
+  record.kind = GDL_RECORD_GRAPH_BEGIN;
+  record.attr_num = ms->top.attr_num;
+  record.attrs = ms->top.attrs;
+  gdl_dump_record (fout, &record);
+
+  record.kind = GDL_RECORD_NODE;
+  for (i = 0; i < nodes.num; i++)
+    {
+      node = (merged_node *) nodes.entries[i];
+      record.attr_num = node->copy.attr_num;
+      record.attrs = node->copy.attrs;
+      gdl_dump_record (fout, &record);
+    }
+
+  record.kind = GDL_RECORD_EDGE;
+  record.attrs = attrs;
+  record.attr_num = 4;
+  attrs[0].key = "sourcename";
+  attrs[0].quoted_p = 1;
+  attrs[1].key = "targetname";
+  attrs[1].quoted_p = 1;
+  attrs[2].key = "label";
+  attrs[2].value = label;
+  attrs[2].quoted_p = 1;
+  attrs[3].key = "thickness";
+  attrs[3].value = thickness;
+  attrs[3].quoted_p = 0;
+  for (i = 0; i < edges.num; i++)
+    {
+      edge = (merged_edge *) edges.entries[i];
+      record.edge_type = edge->type;
+      attrs[0].value = edge->source;
+      attrs[1].value = edge->target;
+      sprintf (label, "%ld", edge->count);
+      sprintf (thickness, "%ld", edge->count < GDL_MAX_AGGREGATE_THICKNESS
+                                 ? edge->count : GDL_MAX_AGGREGATE_THICKNESS);
+      gdl_dump_record (fout, &record);
+    }
+
+  record.kind = GDL_RECORD_GRAPH_END;
+  record.attr_num = 0;
+  gdl_dump_record (fout, &record);
+
+  free (nodes.entries);
+  free (edges.entries);
+}
+
+/* merge [-j N] [-o OUTPUT] FILE...  */
+
+int
+do_merge (int argc, char **argv)
+{
+  merge_state ms;
+  pthread_t *threads;
+  int thread_num = 0, i, ret = 0;
+  const char *output = NULL;
+  FILE *fout = stdout;
+
+  while (argc > 1 && argv[0][0] == '-' && argv[0][1] != '\0')
+    {
+      if (!strcmp (argv[0], "-j"))
+        thread_num = atoi (argv[1]);
+      else if (!strcmp (argv[0], "-o"))
+        output = argv[1];
+      else
+        return -1;
+      argc -= 2;
+      argv += 2;
+    }
+  if (argc < 1)
+    return -1;
+
+  if (thread_num <= 0)
+    thread_num = sysconf (_SC_NPROCESSORS_ONLN);
+  if (thread_num <= 0)
+    thread_num = 1;
+  if (thread_num > argc)
+    thread_num = argc;
+
+  memset (&ms, 0, sizeof (ms));
+  ms.files = argv;
+  ms.file_num = argc;
+  ms.top_file = argc;
+  pthread_mutex_init (&ms.lock, NULL);
+  for (i = 0; i < SHARD_NUM; i++)
+    {
+      pthread_mutex_init (&ms.shards[i].lock, NULL);
+      ms.shards[i].nodes = htab_create (256, node_hash, node_eq, node_del);
+      ms.shards[i].edges = htab_create (256, edge_hash, edge_eq, edge_del);
+    }
+
+  threads = XNEWVEC (pthread_t, thread_num);
+  for (i = 0; i < thread_num; i++)
+    if (pthread_create (&threads[i], NULL, merge_thread, &ms) != 0)
+      {
+        tool_error ("failed to create thread.");
+        thread_num = i;
+        break;
+      }
+  /* Parse in this thread too if no thread could be created.  */
+  if (thread_num == 0)
+    merge_thread (&ms);
+  for (i = 0; i < thread_num; i++)
+    pthread_join (threads[i], NULL);
+  free (threads);
+
+  if (ms.error_p)
+    ret = 2;
+  else if (output != NULL && (fout = fopen (output, "w")) == NULL)
+    {
+      tool_error ("failed to open file %s.", output);
+      ret = 2;
+    }
+  else
+    {
+      write_merged (fout, &ms);
+      if (fout != stdout)
+        fclose (fout);
+    }
+
+  for (i = 0; i < SHARD_NUM; i++)
+    {
+      htab_delete (ms.shards[i].nodes);
+      htab_delete (ms.shards[i].edges);
+      pthread_mutex_destroy (&ms.shards[i].lock);
+    }
+  pthread_mutex_destroy (&ms.lock);
+  free (ms.top.attrs);
+  return ret;
+}
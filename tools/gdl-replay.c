@@ -0,0 +1,80 @@
+/* Replay a delta log of gdl graphs.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* The log is replayed up to the step by gdl_read_delta, and the graph of
+   the step is printed with its name in a comment on top.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gdl-tool.h"
+
+int
+do_replay (int argc, char **argv)
+{
+  const char *output = NULL;
+  FILE *fin, *fout = stdout;
+  gdl_graph *graph;
+  char *name, *end;
+  int step = -1, line;
+
+  if (argc > 1 && !strcmp (argv[0], "-o"))
+    {
+      output = argv[1];
+      argc -= 2;
+      argv += 2;
+    }
+  if (argc == 2)
+    {
+      step = strtol (argv[1], &end, 10);
+      if (*end != '\0' || step < 0)
+        return -1;
+    }
+  else if (argc != 1)
+    return -1;
+
+  if ((fin = open_input (argv[0])) == NULL)
+    return 2;
+  graph = gdl_read_delta (fin, step, &name, &line);
+  close_input (fin);
+  if (graph == NULL)
+    {
+      if (line > 0)
+        tool_error ("%s:%d: syntax error.", argv[0], line);
+      else
+        tool_error ("%s: no step %d.", argv[0], step);
+      return 2;
+    }
+
+  if (output != NULL && (fout = fopen (output, "w")) == NULL)
+    {
+      tool_error ("failed to open file %s.", output);
+      gdl_free_graph (graph);
+      free (name);
+      return 2;
+    }
+
+  fprintf (fout, "// step: %s\n", name ? name : "");
+  gdl_dump_graph (fout, graph);
+  if (fout != stdout)
+    fclose (fout);
+
+  gdl_free_graph (graph);
+  free (name);
+  return 0;
+}
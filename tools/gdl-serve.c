@@ -0,0 +1,228 @@
+/* Receive the graphs pushed by the plugin to a persistent viewer.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* The plugin connects once and pushes each viewed graph as a line
+   "graph N" followed by the N bytes of the dumped file.  Each graph is
+   printed, or replaces the output file at once through a rename, so that
+   a viewer which reloads the file when it changes shows the new graph
+   without starting again.  Each client is served by a thread of its
+   own, since a plugin keeps its connection for the whole session and
+   would block the others, until the command is killed.  The graphs are
+   in the vcg format, which is what the plugin shows.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <libiberty.h>
+
+#include "gdl-tool.h"
+
+/* The state shared by the threads serving the clients, which take
+   turns to write the output.  */
+
+typedef struct
+{
+  const char *output;
+  const char *path;
+  int graph_num;
+  pthread_mutex_t lock;
+} serve_state;
+
+/* A client connection, for its thread.  */
+
+typedef struct
+{
+  serve_state *ss;
+  int fd;
+} serve_client;
+
+/* Read a graph from FIN into *BUF, which grows to *SIZE.  Return its
+   length, 0 at the end of the connection, or -1 on error.  */
+
+static long
+read_graph (FILE *fin, char **buf, size_t *size)
+{
+  char header[32];
+  long len;
+
+  if (fgets (header, sizeof (header), fin) == NULL)
+    return 0;
+  if (sscanf (header, "graph %ld", &len) != 1 || len < 0)
+    return -1;
+
+  if ((size_t) len + 1 > *size)
+    {
+      *size = len + 1;
+      *buf = XRESIZEVEC (char, *buf, *size);
+    }
+  if (fread (*buf, 1, len, fin) != (size_t) len)
+    return -1;
+  return len;
+}
+
+/* Write LEN bytes of BUF into OUTPUT, replacing it at once.  Return 0 on
+   error.  */
+
+static int
+replace_output (const char *output, const char *buf, long len)
+{
+  char *tmp;
+  FILE *fout;
+  int ret = 1;
+
+  tmp = concat (output, ".tmp", NULL);
+  if ((fout = fopen (tmp, "w")) == NULL)
+    {
+      tool_error ("failed to open file %s.", tmp);
+      free (tmp);
+      return 0;
+    }
+  fwrite (buf, 1, len, fout);
+  if (fclose (fout) != 0 || rename (tmp, output) != 0)
+    {
+      tool_error ("failed to write file %s.", output);
+      unlink (tmp);
+      ret = 0;
+    }
+  free (tmp);
+  return ret;
+}
+
+/* The thread serving a client, which is freed at the end of the
+   connection.  */
+
+static void *
+serve_thread (void *data)
+{
+  serve_client *client = (serve_client *) data;
+  serve_state *ss = client->ss;
+  char *buf = NULL;
+  size_t size = 0;
+  long len;
+  FILE *fin;
+
+  if ((fin = fdopen (client->fd, "r")) == NULL)
+    {
+      tool_error ("failed to read from a client of %s.", ss->path);
+      close (client->fd);
+      free (client);
+      return NULL;
+    }
+
+  while ((len = read_graph (fin, &buf, &size)) > 0)
+    {
+      pthread_mutex_lock (&ss->lock);
+      ss->graph_num++;
+      if (ss->output == NULL)
+        {
+          fwrite (buf, 1, len, stdout);
+          fflush (stdout);
+        }
+      else if (replace_output (ss->output, buf, len))
+        {
+          printf ("graph %d: %ld bytes\n", ss->graph_num, len);
+          fflush (stdout);
+        }
+      pthread_mutex_unlock (&ss->lock);
+    }
+  if (len < 0)
+    tool_error ("%s: bad graph from the client.", ss->path);
+
+  fclose (fin);
+  free (buf);
+  free (client);
+  return NULL;
+}
+
+int
+do_serve (int argc, char **argv)
+{
+  const char *output = NULL, *path;
+  struct sockaddr_un addr;
+  serve_client *client;
+  /* Static, since the threads outlive the function.  */
+  static serve_state ss;
+  pthread_t thread;
+  int fd, client_fd;
+
+  if (argc > 1 && !strcmp (argv[0], "-o"))
+    {
+      output = argv[1];
+      argc -= 2;
+      argv += 2;
+    }
+  if (argc != 1)
+    return -1;
+
+  path = argv[0];
+  if (strlen (path) >= sizeof (addr.sun_path))
+    {
+      tool_error ("socket name %s is too long.", path);
+      return 2;
+    }
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, path);
+
+  /* A socket left by an earlier run is taken over.  */
+  unlink (path);
+  if ((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0
+      || bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0
+      || listen (fd, 16) < 0)
+    {
+      tool_error ("failed to listen on %s.", path);
+      return 2;
+    }
+
+  ss.output = output;
+  ss.path = path;
+  ss.graph_num = 0;
+  pthread_mutex_init (&ss.lock, NULL);
+
+  for (;;)
+    {
+      if ((client_fd = accept (fd, NULL, NULL)) < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          tool_error ("failed to accept on %s.", path);
+          break;
+        }
+
+      client = XNEW (serve_client);
+      client->ss = &ss;
+      client->fd = client_fd;
+      if (pthread_create (&thread, NULL, serve_thread, client) != 0)
+        {
+          tool_error ("failed to start a thread for a client of %s.", path);
+          close (client_fd);
+          free (client);
+          continue;
+        }
+      pthread_detach (thread);
+    }
+
+  close (fd);
+  unlink (path);
+  return 2;
+}
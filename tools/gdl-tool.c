@@ -0,0 +1,638 @@
+/* Command line tool to process gdl files.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* The commands stream through the files with gdl_parse_file, so that
+   the memory used does not grow with the size of the files.  Only extract
+   keeps a set of titles, which is bounded by the size of its output.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <regex.h>
+
+#include <libiberty.h>
+#include <hashtab.h>
+
+#include "gdl-tool.h"
+
+static const char *program_name = "gdl-tool";
+
+/* Print error messages.  */
+
+void
+tool_error (const char *format, ...)
+{
+  va_list ap;
+
+  va_start (ap, format);
+  fprintf (stderr, "%s: error: ", program_name);
+  vfprintf (stderr, format, ap);
+  va_end (ap);
+  fputc ('\n', stderr);
+}
+
+/* Open the file FNAME for reading, "-" is the standard input.  */
+
+FILE *
+open_input (const char *fname)
+{
+  FILE *fin;
+
+  if (!strcmp (fname, "-"))
+    return stdin;
+
+  if ((fin = fopen (fname, "r")) == NULL)
+    tool_error ("failed to open file %s.", fname);
+  return fin;
+}
+
+void
+close_input (FILE *fin)
+{
+  if (fin != stdin)
+    fclose (fin);
+}
+
+/* Parse the file FNAME with FUNC and DATA.  Return 0 on success, 1 if
+   FUNC stopped the parsing, and -1 on error.  */
+
+int
+parse_input (const char *fname, gdl_record_func func, void *data)
+{
+  FILE *fin;
+  int ret, line;
+
+  if ((fin = open_input (fname)) == NULL)
+    return -1;
+
+  ret = gdl_parse_file (fin, func, data, &line);
+  if (ret < 0)
+    tool_error ("%s:%d: syntax error.", fname, line);
+
+  close_input (fin);
+  return ret;
+}
+
+/* A set of strings.  */
+
+static int
+str_eq (const void *p1, const void *p2)
+{
+  return strcmp ((const char *) p1, (const char *) p2) == 0;
+}
+
+static htab_t
+new_str_set (void)
+{
+  return htab_create (64, htab_hash_string, str_eq, free);
+}
+
+/* Add STR into SET.  Return 1 if it is new.  */
+
+static int
+add_str (htab_t set, const char *str)
+{
+  void **slot;
+
+  slot = htab_find_slot (set, str, INSERT);
+  if (*slot != NULL)
+    return 0;
+  *slot = xstrdup (str);
+  return 1;
+}
+
+static int
+has_str (htab_t set, const char *str)
+{
+  return htab_find (set, str) != NULL;
+}
+
+/* stats  */
+
+typedef struct
+{
+  long graph_num;
+  long node_num;
+  long edge_num;
+  long backedge_num;
+  long label_num;
+  long label_bytes;
+  int max_depth;
+} stats;
+
+static int
+stats_record (gdl_record *record, void *data)
+{
+  stats *st = (stats *) data;
+  char *label;
+
+  switch (record->kind)
+    {
+    case GDL_RECORD_GRAPH_BEGIN:
+      st->graph_num++;
+      if (record->depth > st->max_depth)
+        st->max_depth = record->depth;
+      break;
+    case GDL_RECORD_NODE:
+      st->node_num++;
+      break;
+    case GDL_RECORD_EDGE:
+      st->edge_num++;
+      if (record->edge_type == GDL_BACKEDGE)
+        st->backedge_num++;
+      break;
+    default:
+      break;
+    }
+
+  if ((label = gdl_get_record_attr (record, "label")) != NULL)
+    {
+      st->label_num++;
+      st->label_bytes += strlen (label);
+    }
+  return 0;
+}
+
+static int
+do_stats (int argc, char **argv)
+{
+  int i, ret = 0;
+  stats st;
+
+  if (argc < 1)
+    return -1;
+
+  for (i = 0; i < argc; i++)
+    {
+      memset (&st, 0, sizeof (st));
+      if (parse_input (argv[i], stats_record, &st) < 0)
+        {
+          ret = 2;
+          continue;
+        }
+      printf ("%s:\n"
+              "  graphs:      %ld\n"
+              "  max depth:   %d\n"
+              "  nodes:       %ld\n"
+              "  edges:       %ld\n"
+              "  backedges:   %ld\n"
+              "  labels:      %ld\n"
+              "  label bytes: %ld\n",
+              argv[i], st.graph_num, st.max_depth, st.node_num,
+              st.edge_num, st.backedge_num, st.label_num, st.label_bytes);
+    }
+  return ret;
+}
+
+/* grep  */
+
+typedef struct
+{
+  regex_t regex;
+  const char *fname;
+  long match_num;
+} grep_state;
+
+static int
+grep_record (gdl_record *record, void *data)
+{
+  grep_state *st = (grep_state *) data;
+  char *label, *title;
+
+  if (record->kind != GDL_RECORD_NODE)
+    return 0;
+
+  label = gdl_get_record_attr (record, "label");
+  if (label == NULL || regexec (&st->regex, label, 0, NULL, 0) != 0)
+    return 0;
+
+  title = gdl_get_record_attr (record, "title");
+  printf ("%s:%d: %s\n", st->fname, record->line, title ? title : "");
+  st->match_num++;
+  return 0;
+}
+
+static int
+do_grep (int argc, char **argv)
+{
+  int i, ret = 0, flags = REG_EXTENDED | REG_NOSUB;
+  grep_state st;
+
+  if (argc > 0 && !strcmp (argv[0], "-i"))
+    {
+      flags |= REG_ICASE;
+      argc--;
+      argv++;
+    }
+  if (argc < 2)
+    return -1;
+
+  if (regcomp (&st.regex, argv[0], flags) != 0)
+    {
+      tool_error ("invalid regular expression %s.", argv[0]);
+      return 2;
+    }
+
+  st.match_num = 0;
+  for (i = 1; i < argc; i++)
+    {
+      st.fname = argv[i];
+      if (parse_input (argv[i], grep_record, &st) < 0)
+        ret = 2;
+    }
+
+  regfree (&st.regex);
+  if (ret == 0 && st.match_num == 0)
+    ret = 1;
+  return ret;
+}
+
+/* extract  */
+
+typedef struct
+{
+  const char *title;
+  /* The depth of the subgraph being extracted, or -1.  */
+  int depth;
+  int found_p;
+  /* The titles in the neighborhood, and the ones added in this pass.  */
+  htab_t titles;
+  htab_t frontier;
+  htab_t next_frontier;
+  /* The nodes already printed.  */
+  htab_t printed;
+} extract_state;
+
+/* Print RECORD if it is inside the subgraph titled ST->title, and collect
+   the neighbors of the node titled ST->title.  */
+
+static int
+extract_subgraph_record (gdl_record *record, void *data)
+{
+  extract_state *st = (extract_state *) data;
+  char *title, *source, *target;
+
+  if (st->depth < 0 && record->kind == GDL_RECORD_GRAPH_BEGIN
+      && (title = gdl_get_record_attr (record, "title")) != NULL
+      && !strcmp (title, st->title))
+    {
+      st->depth = record->depth;
+      st->found_p = 1;
+    }
+
+  if (st->depth >= 0)
+    {
+      gdl_dump_record (stdout, record);
+      if (record->kind == GDL_RECORD_GRAPH_END
+          && record->depth == st->depth)
+        return 1;
+      return 0;
+    }
+
+  if (record->kind == GDL_RECORD_EDGE)
+    {
+      source = gdl_get_record_attr (record, "sourcename");
+      target = gdl_get_record_attr (record, "targetname");
+      if (source == NULL || target == NULL)
+        return 0;
+      if (!strcmp (source, st->title) && add_str (st->titles, target))
+        add_str (st->next_frontier, target);
+      if (!strcmp (target, st->title) && add_str (st->titles, source))
+        add_str (st->next_frontier, source);
+    }
+  return 0;
+}
+
+/* Collect the neighbors of the titles in the frontier.  */
+
+static int
+extract_neighbor_record (gdl_record *record, void *data)
+{
+  extract_state *st = (extract_state *) data;
+  char *source, *target;
+
+  if (record->kind != GDL_RECORD_EDGE)
+    return 0;
+
+  source = gdl_get_record_attr (record, "sourcename");
+  target = gdl_get_record_attr (record, "targetname");
+  if (source == NULL || target == NULL)
+    return 0;
+  if (has_str (st->frontier, source) && add_str (st->titles, target))
+    add_str (st->next_frontier, target);
+  if (has_str (st->frontier, target) && add_str (st->titles, source))
+    add_str (st->next_frontier, source);
+  return 0;
+}
+
+/* Print the nodes and edges inside the neighborhood.  */
+
+static int
+extract_print_record (gdl_record *record, void *data)
+{
+  extract_state *st = (extract_state *) data;
+  char *title, *source, *target;
+
+  if (record->kind == GDL_RECORD_NODE)
+    {
+      title = gdl_get_record_attr (record, "title");
+      if (title != NULL && has_str (st->titles, title)
+          && add_str (st->printed, title))
+        gdl_dump_record (stdout, record);
+    }
+  else if (record->kind == GDL_RECORD_EDGE)
+    {
+      source = gdl_get_record_attr (record, "sourcename");
+      target = gdl_get_record_attr (record, "targetname");
+      if (source != NULL && target != NULL && has_str (st->titles, source)
+          && has_str (st->titles, target))
+        gdl_dump_record (stdout, record);
+    }
+  return 0;
+}
+
+/* Print the title attribute TITLE, with each '"' escaped.  */
+
+static void
+print_title (const char *title)
+{
+  fputs ("title: \"", stdout);
+  for (; *title; title++)
+    {
+      if (*title == '"')
+        fputc ('\\', stdout);
+      fputc (*title, stdout);
+    }
+  fputs ("\"\n", stdout);
+}
+
+/* Print a plain node for each title which is not a node, e.g. the title
+   of a subgraph, so that the edges to it stay valid.  */
+
+static int
+print_missing_node (void **slot, void *data)
+{
+  extract_state *st = (extract_state *) data;
+  char *title = (char *) *slot;
+
+  if (!has_str (st->printed, title))
+    {
+      fputs ("node: {\n", stdout);
+      print_title (title);
+      fputs ("}\n", stdout);
+    }
+  return 1;
+}
+
+static int
+do_extract (int argc, char **argv)
+{
+  int radius = 1, i, ret = 0;
+  const char *fname;
+  extract_state st;
+  htab_t tmp;
+
+  if (argc > 1 && !strcmp (argv[0], "-r"))
+    {
+      radius = atoi (argv[1]);
+      argc -= 2;
+      argv += 2;
+    }
+  if (argc != 2 || radius < 0)
+    return -1;
+
+  memset (&st, 0, sizeof (st));
+  st.title = argv[0];
+  st.depth = -1;
+  fname = argv[1];
+  st.titles = new_str_set ();
+  st.frontier = new_str_set ();
+  st.next_frontier = new_str_set ();
+  st.printed = new_str_set ();
+  add_str (st.titles, st.title);
+
+  /* The first pass either finds the subgraph, or the direct neighbors of
+     the node.  */
+  if (parse_input (fname, extract_subgraph_record, &st) < 0)
+    ret = 2;
+  else if (!st.found_p)
+    {
+      if (radius == 0)
+        {
+          htab_empty (st.titles);
+          add_str (st.titles, st.title);
+        }
+
+      /* Grow the neighborhood by one edge per pass, and print it in a
+         last one, which needs to read the file again.  */
+      if (!strcmp (fname, "-"))
+        {
+          tool_error ("extract needs a file to read more than once.");
+          ret = 2;
+          goto out;
+        }
+
+      for (i = 1; i < radius && htab_elements (st.next_frontier) > 0; i++)
+        {
+          tmp = st.frontier;
+          st.frontier = st.next_frontier;
+          st.next_frontier = tmp;
+          htab_empty (st.next_frontier);
+          if (parse_input (fname, extract_neighbor_record, &st) < 0)
+            {
+              ret = 2;
+              goto out;
+            }
+        }
+
+      fputs ("graph: {\n", stdout);
+      print_title (st.title);
+      if (parse_input (fname, extract_print_record, &st) < 0)
+        ret = 2;
+      htab_traverse (st.titles, print_missing_node, &st);
+      fputs ("}\n", stdout);
+    }
+
+ out:
+  htab_delete (st.titles);
+  htab_delete (st.frontier);
+  htab_delete (st.next_frontier);
+  htab_delete (st.printed);
+  return ret;
+}
+
+/* strip  */
+
+typedef struct
+{
+  int label_p;
+  int attr_num;
+  char **attrs;
+} strip_state;
+
+/* Print RECORD without the attributes to strip.  The titles and the names
+   of the edge ends are always kept.  */
+
+static int
+strip_record (gdl_record *record, void *data)
+{
+  strip_state *st = (strip_state *) data;
+  int i, j, n = 0;
+  char *key;
+
+  for (i = 0; i < record->attr_num; i++)
+    {
+      key = record->attrs[i].key;
+      if (strcmp (key, "title") && strcmp (key, "sourcename")
+          && strcmp (key, "targetname"))
+        {
+          if (st->label_p && !strcmp (key, "label"))
+            continue;
+          for (j = 0; j < st->attr_num; j++)
+            if (!strcmp (key, st->attrs[j]))
+              break;
+          if (j < st->attr_num)
+            continue;
+        }
+      record->attrs[n++] = record->attrs[i];
+    }
+  record->attr_num = n;
+
+  if (record->kind != GDL_RECORD_GRAPH_ATTR || n > 0)
+    gdl_dump_record (stdout, record);
+  return 0;
+}
+
+static int
+do_strip (int argc, char **argv)
+{
+  strip_state st;
+  int ret;
+
+  memset (&st, 0, sizeof (st));
+  st.attrs = XNEWVEC (char *, argc);
+  while (argc > 1)
+    {
+      if (!strcmp (argv[0], "-l"))
+        {
+          st.label_p = 1;
+          argc--;
+          argv++;
+        }
+      else if (!strcmp (argv[0], "-a") && argc > 2)
+        {
+          st.attrs[st.attr_num++] = argv[1];
+          argc -= 2;
+          argv += 2;
+        }
+      else
+        break;
+    }
+  if (argc != 1)
+    {
+      free (st.attrs);
+      return -1;
+    }
+
+  /* Strip the labels by default.  */
+  if (st.attr_num == 0)
+    st.label_p = 1;
+
+  ret = parse_input (argv[0], strip_record, &st) < 0 ? 2 : 0;
+  free (st.attrs);
+  return ret;
+}
+
+static void
+usage (FILE *fout)
+{
+  fprintf (fout,
+           "Usage: %s COMMAND [OPTION]... FILE...\n"
+           "Process gdl files, \"-\" is the standard input.\n"
+           "\n"
+           "Commands:\n"
+           "  stats FILE...              Print the counts of graphs, nodes,\n"
+           "                             edges and the size of labels\n"
+           "  grep [-i] REGEX FILE...    Print the nodes whose label matches\n"
+           "                             the extended regular expression\n"
+           "  extract [-r N] TITLE FILE  Print the subgraph titled TITLE, or\n"
+           "                             the nodes within N edges (default 1)\n"
+           "                             of the node titled TITLE\n"
+           "  strip [-l] [-a ATTR]... FILE\n"
+           "                             Print the file without labels (-l,\n"
+           "                             the default) or the attribute ATTR\n"
+           "  merge [-j N] [-o OUTPUT] FILE...\n"
+           "                             Merge the files into one graph with N\n"
+           "                             threads, unifying the nodes by title\n"
+           "                             and counting the edges as their label\n"
+           "  diff [-o OUTPUT] OLD NEW   Print NEW with the added nodes and\n"
+           "                             edges in green, the removed ones in\n"
+           "                             red and the relabeled nodes in\n"
+           "                             yellow, and a summary of the counts\n"
+           "  replay [-o OUTPUT] LOG [STEP]\n"
+           "                             Print the graph of the step STEP,\n"
+           "                             counted from 0, or of the last step\n"
+           "                             of the delta log LOG\n"
+           "  serve [-o OUTPUT] SOCKET   Print the graphs pushed by the plugin\n"
+           "                             to the UNIX socket SOCKET, or replace\n"
+           "                             OUTPUT with each one\n",
+           program_name);
+}
+
+int
+main (int argc, char **argv)
+{
+  int ret;
+
+  if (argc < 2)
+    {
+      usage (stderr);
+      return 2;
+    }
+
+  if (!strcmp (argv[1], "stats"))
+    ret = do_stats (argc - 2, argv + 2);
+  else if (!strcmp (argv[1], "grep"))
+    ret = do_grep (argc - 2, argv + 2);
+  else if (!strcmp (argv[1], "extract"))
+    ret = do_extract (argc - 2, argv + 2);
+  else if (!strcmp (argv[1], "strip"))
+    ret = do_strip (argc - 2, argv + 2);
+  else if (!strcmp (argv[1], "merge"))
+    ret = do_merge (argc - 2, argv + 2);
+  else if (!strcmp (argv[1], "diff"))
+    ret = do_diff (argc - 2, argv + 2);
+  else if (!strcmp (argv[1], "replay"))
+    ret = do_replay (argc - 2, argv + 2);
+  else if (!strcmp (argv[1], "serve"))
+    ret = do_serve (argc - 2, argv + 2);
+  else if (!strcmp (argv[1], "help") || !strcmp (argv[1], "--help"))
+    {
+      usage (stdout);
+      return 0;
+    }
+  else
+    ret = -1;
+
+  if (ret < 0)
+    {
+      usage (stderr);
+      return 2;
+    }
+  return ret;
+}
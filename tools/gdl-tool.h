@@ -0,0 +1,41 @@
+/* Command line tool to process gdl files.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef GDL_TOOL_H
+#define GDL_TOOL_H
+
+#include <stdio.h>
+
+#include "gdl.h"
+
+/* Common routines.  */
+
+extern void tool_error (const char *format, ...);
+extern FILE *open_input (const char *fname);
+extern void close_input (FILE *fin);
+extern int parse_input (const char *fname, gdl_record_func func,
+                        void *data);
+
+/* The commands which live in their own files.  Each returns the exit
+   status, or -1 for wrong arguments.  */
+
+extern int do_merge (int argc, char **argv);
+extern int do_diff (int argc, char **argv);
+extern int do_replay (int argc, char **argv);
+extern int do_serve (int argc, char **argv);
+
+#endif
@@ -82,20 +82,32 @@ free_names (void)
   free (bb_node_title);
 }
 
-/* Create a graph from the basic block bb. */
+/* Create a graph from the basic block bb in GRAPH.  It is added before
+   it is filled, so that the budget of GRAPH applies to it.  The label
+   is copied into the strings of GRAPH.  */
 
 static gdl_graph *
-create_bb_graph (basic_block bb)
+create_bb_graph (gdl_graph *graph, basic_block bb)
 {
   gdl_graph *g;
   gdl_node *n;
   char *str;
+  long room;
   int i;
 
-  g = gdl_new_graph (bb_graph_title[bb->index]);
+  g = gdl_new_graph_subgraph (graph, bb_graph_title[bb->index]);
   gdl_set_graph_label (g, bb_graph_label[bb->index]);
-  gdl_set_graph_folding (g, 1);
-  gdl_set_graph_shape (g, "ellipse");
+  gdl_set_graph_style (g, vcg_plugin_common.folded_style);
+
+  /* The text is not even made once the budget is used up, where the
+     label is only counted as elided.  */
+  room = gdl_graph_label_room (g);
+  n = gdl_new_graph_node (g, bb_node_title[bb->index]);
+  if (room == 0)
+    {
+      gdl_set_node_label (n, "");
+      return g;
+    }
 
   rewind (vcg_plugin_common.stream);
   gimple_dump_bb (bb, vcg_plugin_common.stream, 0,
@@ -103,8 +115,11 @@ create_bb_graph (basic_block bb)
   i = vcg_plugin_common.stream_buf_size;
   while (i > 1 && ISSPACE (vcg_plugin_common.stream_buf[i - 1])) i--;
   str = xstrndup (vcg_plugin_common.stream_buf, i);
-  n = gdl_new_graph_node (g, bb_node_title[bb->index]);
-  gdl_set_node_label (n, str);
+  if (room > 0 && (long) strlen (str) > room)
+    gdl_set_node_label (n, str);
+  else
+    gdl_set_node_label (n, gdl_graph_strdup (g, str));
+  free (str);
 
   return g;
 }
@@ -148,7 +163,7 @@ dump_bb_to_file (char *fname, char *list)
   edge e;
   edge_iterator ei;
 
-  gdl_graph *graph, *bb_graph;
+  gdl_graph *graph;
   gdl_edge *edge;
 
   bb_index = XCNEWVEC (int, n_basic_blocks);
@@ -164,8 +179,7 @@ dump_bb_to_file (char *fname, char *list)
   FOR_ALL_BB (bb)
     if (bb_index[bb->index])
       {
-        bb_graph = create_bb_graph (bb);
-        gdl_add_subgraph (graph, bb_graph);
+        create_bb_graph (graph, bb);
 
         FOR_EACH_EDGE (e, ei, bb->succs)
           if (bb_index[e->dest->index])
@@ -58,7 +58,8 @@ find_string (struct cgraph_node *node, char *prefix)
   return str;
 }
 
-/* Create gdl edge based on EDGE and PREFIX if it does not exist.  */
+/* Create gdl edge based on EDGE and PREFIX.  The parallel edges are
+   merged by the graph.  */
 
 static void
 create_edge (gdl_graph *graph, struct cgraph_edge *edge, char *prefix,
@@ -74,9 +75,6 @@ create_edge (gdl_graph *graph, struct cgraph_edge *edge, char *prefix,
   source_title = find_string (source, prefix);
   target_title = find_string (target, prefix);
 
-  if (gdl_find_edge (graph, source_title, target_title))
-    return;
-
   e = gdl_new_graph_edge (graph, source_title, target_title);
   if (backedge_p)
     gdl_set_edge_type (e, GDL_BACKEDGE);
@@ -178,13 +176,26 @@ dump_cgraph_to_file_specific (char *fname, int callee_p)
 
   graph = vcg_plugin_common.top_graph;
   gdl_set_graph_orientation (graph, "left_to_right");
+  /* Label the edges with the number of call sites.  */
+  gdl_set_graph_edge_aggregation (graph, GDL_AGGREGATE_LABEL);
 
   for (node = cgraph_nodes; node; node = node->next)
-    create_node_and_edges_specific (graph, node, callee_p);
+    if (vcg_function_selected_p (cgraph_node_name (node)))
+      create_node_and_edges_specific (graph, node, callee_p);
 
   vcg_plugin_common.dump (fname);
 }
 
+/* Get the title or label of the node with INDEX in the node array DATA.  */
+
+static char *
+get_node_name (int index, void *data)
+{
+  struct cgraph_node **nodes = (struct cgraph_node **) data;
+
+  return find_string (nodes[index], NULL);
+}
+
 /* Dump call graph into the file FNAME.  */
 
 static void
@@ -193,20 +204,56 @@ dump_cgraph_to_file (char *fname)
   gdl_graph *graph;
   struct cgraph_node *node;
   struct cgraph_edge *edge;
+  struct cgraph_node **nodes;
+  int *node_index, *last_caller, *offsets, *targets;
+  int node_num, edge_num, i, j;
 
   graph = vcg_plugin_common.top_graph;
   gdl_set_graph_orientation (graph, "left_to_right");
 
+  /* Number the nodes.  Don't create the single node.  */
+  nodes = XNEWVEC (struct cgraph_node *, cgraph_n_nodes);
+  node_index = XNEWVEC (int, cgraph_max_uid);
+  node_num = 0;
+  edge_num = 0;
   for (node = cgraph_nodes; node; node = node->next)
+    if (node->callees || node->callers)
+      {
+        node_index[node->uid] = node_num;
+        nodes[node_num++] = node;
+        for (edge = node->callees; edge; edge = edge->next_callee)
+          edge_num++;
+      }
+
+  /* Collect the edges of each caller, and only keep one of the edges to
+     the same callee.  */
+  offsets = XNEWVEC (int, node_num + 1);
+  targets = XNEWVEC (int, edge_num);
+  last_caller = XNEWVEC (int, node_num);
+  memset (last_caller, -1, node_num * sizeof (int));
+  edge_num = 0;
+  for (i = 0; i < node_num; i++)
     {
-      /* Don't create the single node.  */
-      if (!node->callees && !node->callers)
-        continue;
-
-      create_node (graph, node, NULL);
-      for (edge = node->callees; edge; edge = edge->next_callee)
-        create_edge (graph, edge, NULL, 0);
+      offsets[i] = edge_num;
+      for (edge = nodes[i]->callees; edge; edge = edge->next_callee)
+        {
+          j = node_index[edge->callee->uid];
+          if (last_caller[j] == i)
+            continue;
+          last_caller[j] = i;
+          targets[edge_num++] = j;
+        }
     }
+  offsets[node_num] = edge_num;
+
+  gdl_new_graph_bulk_csr (graph, node_num, get_node_name, get_node_name,
+                          nodes, offsets, targets);
+
+  free (nodes);
+  free (node_index);
+  free (offsets);
+  free (targets);
+  free (last_caller);
 
   vcg_plugin_common.dump (fname);
 }
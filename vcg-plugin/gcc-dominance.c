@@ -17,6 +17,18 @@
 
 #include "vcg-plugin.h"
 
+/* Get the title of the node with INDEX in the basic block array DATA.  */
+
+static char *
+get_node_title (int index, void *data)
+{
+  static char buf[32];
+  basic_block *bbs = (basic_block *) data;
+
+  sprintf (buf, "bb %d", bbs[index]->index);
+  return buf;
+}
+
 /* Dump dominance graph into the file FNAME.  */
 
 static void
@@ -24,25 +36,47 @@ dump_dominance_to_file (char *fname)
 {
   gdl_graph *graph;
   basic_block bb, bb2;
-  char buf[32];
-  char buf2[32];
+  basic_block *bbs;
+  int *node_index, *sources, *targets;
+  int node_num, edge_num;
 
   graph = vcg_plugin_common.top_graph;
 
+  /* Number the basic blocks in the order they are first seen.  */
+  bbs = XNEWVEC (basic_block, last_basic_block);
+  node_index = XNEWVEC (int, last_basic_block);
+  memset (node_index, -1, last_basic_block * sizeof (int));
+  sources = XNEWVEC (int, n_basic_blocks);
+  targets = XNEWVEC (int, n_basic_blocks);
+  node_num = 0;
+  edge_num = 0;
+
   FOR_EACH_BB (bb)
     if ((bb2 = get_immediate_dominator (1, bb)))
       {
-        sprintf (buf, "bb %d", bb->index);
-        sprintf (buf2, "bb %d", bb2->index);
-
-        if (!gdl_find_node (graph, buf))
-          gdl_new_graph_node (graph, buf);
+        if (node_index[bb->index] < 0)
+          {
+            node_index[bb->index] = node_num;
+            bbs[node_num++] = bb;
+          }
+
+        if (node_index[bb2->index] < 0)
+          {
+            node_index[bb2->index] = node_num;
+            bbs[node_num++] = bb2;
+          }
+
+        sources[edge_num] = node_index[bb2->index];
+        targets[edge_num++] = node_index[bb->index];
+      }
 
-        if (!gdl_find_node (graph, buf2))
-          gdl_new_graph_node (graph, buf2);
+  gdl_new_graph_bulk_coo (graph, node_num, get_node_title, NULL, bbs,
+                          edge_num, sources, targets);
 
-        gdl_new_graph_edge (graph, buf2, buf);
-      }
+  free (bbs);
+  free (node_index);
+  free (sources);
+  free (targets);
 
   vcg_plugin_common.dump (fname);
 }
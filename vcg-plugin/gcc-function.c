@@ -77,111 +77,220 @@ free_names (int bb_num)
   free (bb_node_title);
 }
 
-/* Create a graph from the basic block bb. */
+/* The graphs of the basic blocks dumped last time, which are shared by
+   the dumps as long as the blocks do not change.  */
 
-static gdl_graph *
-create_bb_graph (basic_block bb)
+typedef struct
+{
+  /* The title of the graph and the label of its node.  */
+  char *title;
+  char *text;
+  gdl_graph *graph;
+  /* The dump which used the graph last.  */
+  int generation;
+} bb_graph_entry;
+
+static htab_t bb_graph_cache;
+static int bb_graph_generation;
+
+static hashval_t
+bb_graph_entry_hash (const void *p)
+{
+  const bb_graph_entry *e = (const bb_graph_entry *) p;
+
+  return htab_hash_string (e->title) * 31 + htab_hash_string (e->text);
+}
+
+static int
+bb_graph_entry_eq (const void *p1, const void *p2)
+{
+  const bb_graph_entry *e1 = (const bb_graph_entry *) p1;
+  const bb_graph_entry *e2 = (const bb_graph_entry *) p2;
+
+  return !strcmp (e1->title, e2->title) && !strcmp (e1->text, e2->text);
+}
+
+static void
+bb_graph_entry_del (void *p)
+{
+  bb_graph_entry *e = (bb_graph_entry *) p;
+
+  gdl_unref_graph (e->graph);
+  free (e);
+}
+
+/* Drop the graphs which the last dump did not use.  */
+
+static int
+prune_bb_graph (void **slot, void *data ATTRIBUTE_UNUSED)
+{
+  bb_graph_entry *e = (bb_graph_entry *) *slot;
+
+  if (e->generation != bb_graph_generation)
+    htab_clear_slot (bb_graph_cache, slot);
+  return 1;
+}
+
+/* Fill the graph G of the basic block bb, with LABEL and the gimple
+   STR.  */
+
+static void
+fill_bb_graph (gdl_graph *g, basic_block bb, char *label, char *str)
 {
-  gdl_graph *g;
   gdl_node *n;
-  char *str;
-  int i;
 
-  g = gdl_new_graph (bb_graph_title[bb->index]);
-  gdl_set_graph_label (g, bb_graph_label[bb->index]);
-  gdl_set_graph_folding (g, 1);
-  gdl_set_graph_shape (g, "ellipse");
+  gdl_set_graph_label (g, label);
+  gdl_set_graph_style (g, vcg_plugin_common.folded_style);
+  n = gdl_new_graph_node (g, bb_node_title[bb->index]);
+  gdl_set_node_label (n, str);
+}
+
+/* Return the gimple or, after expand, the insns of the basic block bb.
+   The text is allocated.  */
+
+static char *
+bb_text (basic_block bb)
+{
+  rtx insn;
+  int i;
 
   rewind (vcg_plugin_common.stream);
-  gimple_dump_bb (bb, vcg_plugin_common.stream, 0, TDF_VOPS|TDF_MEMSYMS|TDF_BLOCKS);
+  if (cfun->curr_properties & PROP_rtl)
+    FOR_BB_INSNS (bb, insn)
+      print_rtl_single (vcg_plugin_common.stream, insn);
+  else
+    gimple_dump_bb (bb, vcg_plugin_common.stream, 0, TDF_VOPS|TDF_MEMSYMS|TDF_BLOCKS);
+  fflush (vcg_plugin_common.stream);
   i = vcg_plugin_common.stream_buf_size;
   while (i > 1 && ISSPACE (vcg_plugin_common.stream_buf[i - 1])) i--;
-  str = xstrndup (vcg_plugin_common.stream_buf, i);
-  n = gdl_new_graph_node (g, bb_node_title[bb->index]);
-  gdl_set_node_label (n, str);
-
-  return g;
+  return xstrndup (vcg_plugin_common.stream_buf, i);
 }
 
-static int
-set_vertical_order_1 (gdl_graph *graph, int *distance, basic_block bb)
-{
-  int val, max = 0;
-  edge e;
-  edge_iterator ei;
-  gdl_graph *subgraph;
-  gdl_node *node;
+/* Create a graph from the basic block bb in GRAPH, with its gimple or,
+   after expand, its insns.  Without a budget, the graph is shared with
+   the previous dump if the block is the same.  Otherwise it is added
+   before it is filled, so that the budget of GRAPH applies to it, and
+   the text is not even made once the budget is used up.  In the async
+   mode it is not shared either, since the writer thread would drop its
+   references to the shared graphs while this one takes new ones.  */
 
-  if (distance[bb->index] != 0)
-    return distance[bb->index];
+static gdl_graph *
+create_bb_graph (gdl_graph *graph, basic_block bb)
+{
+  gdl_graph *g;
+  bb_graph_entry key, *e;
+  void **slot;
+  char *str;
+  long room;
 
-  FOR_EACH_EDGE (e, ei, bb->preds)
+  if (vcg_plugin_common.max_nodes || vcg_plugin_common.max_edges
+      || vcg_plugin_common.max_label_bytes
+      || vcg_plugin_common.async_queue_size)
     {
-      if (e->flags & EDGE_DFS_BACK)
-        continue;
+      g = gdl_new_graph_subgraph (graph, bb_graph_title[bb->index]);
+      room = gdl_graph_label_room (g);
+      if (room == 0)
+        {
+          /* Only counted as elided.  */
+          fill_bb_graph (g, bb, bb_graph_label[bb->index], "");
+          return g;
+        }
+      str = bb_text (bb);
+      if (room > 0 && (long) strlen (str) > room)
+        fill_bb_graph (g, bb, bb_graph_label[bb->index], str);
+      else
+        fill_bb_graph (g, bb, bb_graph_label[bb->index],
+                       gdl_graph_strdup (g, str));
+      free (str);
+      return g;
+    }
+
+  str = bb_text (bb);
 
-      val = set_vertical_order_1 (graph, distance, e->src);
-      max = max > val ? max : val;
+  if (bb_graph_cache == NULL)
+    bb_graph_cache = htab_create (64, bb_graph_entry_hash,
+                                  bb_graph_entry_eq, bb_graph_entry_del);
+
+  key.title = bb_graph_title[bb->index];
+  key.text = str;
+  slot = htab_find_slot (bb_graph_cache, &key, INSERT);
+  if (*slot == NULL)
+    {
+      /* The strings live as long as the shared graph.  */
+      g = gdl_new_graph (key.title);
+      e = XNEW (bb_graph_entry);
+      e->title = gdl_get_graph_title (g);
+      e->text = gdl_graph_strdup (g, str);
+      e->graph = g;
+      fill_bb_graph (g, bb, gdl_graph_strdup (g, bb_graph_label[bb->index]),
+                     e->text);
+      *slot = e;
     }
-  distance[bb->index] = max + 1;
-  subgraph = gdl_find_subgraph (graph, bb_graph_title[bb->index]); 
-  gdl_set_graph_vertical_order (subgraph, distance[bb->index]);
-  node = gdl_get_graph_node (subgraph);
-  gdl_set_node_vertical_order (node, distance[bb->index]);
- 
-  return distance[bb->index];
+  free (str);
+
+  e = (bb_graph_entry *) *slot;
+  e->generation = bb_graph_generation;
+  return gdl_new_graph_shared (graph, e->graph);
 }
 
+/* Lay out GRAPH, and keep the exit block on the last level, past the
+   blocks already there.  The orders are set on the graphs showing the
+   shared graphs of the blocks, whose nodes are left alone.  */
+
 static void
-set_vertical_order (gdl_graph *graph)
+layout_function_graph (gdl_graph *graph)
 {
-  int val, max = 0;
-  int *distance;
-  basic_block bb;
-  gdl_graph *subgraph;
+  int levels, pos;
+  gdl_graph *subgraph, *g;
   gdl_node *node;
 
-  distance = XCNEWVEC (int, n_basic_blocks);
+  levels = gdl_layout_graph (graph, 8);
 
-  max = set_vertical_order_1 (graph, distance, EXIT_BLOCK_PTR);
-  FOR_EACH_BB (bb)
-    {
-      if (distance[bb->index] == 0)
-        {
-          val = set_vertical_order_1 (graph, distance, bb);
-          max = max > val ? max : val + 1;
-        }
-    }
+  /* The graph of the block is missing if elided by the budget.  */
   subgraph = gdl_find_subgraph (graph,
-                                bb_graph_title[EXIT_BLOCK_PTR->index]); 
-  gdl_set_graph_vertical_order (subgraph, max);
+                                bb_graph_title[EXIT_BLOCK_PTR->index]);
+  if (subgraph == NULL
+      || gdl_get_graph_vertical_order (subgraph) == levels - 1)
+    return;
+
+  pos = 0;
+  for (g = gdl_get_graph_subgraph (graph); g != NULL; g = g->next)
+    if (gdl_get_graph_vertical_order (g) == levels - 1
+        && gdl_get_graph_horizontal_order (g) >= pos)
+      pos = gdl_get_graph_horizontal_order (g) + 1;
+  for (node = gdl_get_graph_node (graph); node != NULL; node = node->next)
+    if (gdl_get_node_vertical_order (node) == levels - 1
+        && gdl_get_node_horizontal_order (node) >= pos)
+      pos = gdl_get_node_horizontal_order (node) + 1;
+
+  gdl_set_graph_vertical_order (subgraph, levels - 1);
+  gdl_set_graph_horizontal_order (subgraph, pos);
+  /* The node is missing if elided by the budget.  */
   node = gdl_get_graph_node (subgraph);
-  gdl_set_node_vertical_order (node, max);
-
-  free (distance);
+  if (node != NULL && subgraph->shared == NULL)
+    {
+      gdl_set_node_vertical_order (node, levels - 1);
+      gdl_set_node_horizontal_order (node, pos);
+    }
 }
 
+/* Create the graph of the current function in GRAPH.  The names must
+   have been created.  */
+
 static void
-dump_function_to_file (char *fname)
+create_function_graph (gdl_graph *graph)
 {
   basic_block bb;
   edge e;
   edge_iterator ei;
-
-  gdl_graph *graph, *bb_graph;
   gdl_edge *edge;
 
-  /* Create names for graphs and nodes.  */
-  create_names ();
-
-  graph = vcg_plugin_common.top_graph;
-
   mark_dfs_back_edges ();
+  bb_graph_generation++;
 
   FOR_ALL_BB (bb)
     {
-      bb_graph = create_bb_graph (bb);
-      gdl_add_subgraph (graph, bb_graph);
+      create_bb_graph (graph, bb);
 
       FOR_EACH_EDGE (e, ei, bb->succs)
         {
@@ -192,8 +301,25 @@ dump_function_to_file (char *fname)
         }
     }
 
+  /* Keep only the graphs of the blocks in this graph for the next one,
+     the graph holds its own references.  */
+  if (bb_graph_cache != NULL)
+    htab_traverse (bb_graph_cache, prune_bb_graph, NULL);
+}
+
+static void
+dump_function_to_file (char *fname)
+{
+  gdl_graph *graph;
+
+  /* Create names for graphs and nodes.  */
+  create_names ();
+
+  graph = vcg_plugin_common.top_graph;
+  create_function_graph (graph);
+
   /* Optimize the graph layout.  */
-  set_vertical_order (graph);
+  layout_function_graph (graph);
 
   vcg_plugin_common.dump (fname);
 
@@ -226,3 +352,74 @@ vcg_plugin_view_function (void)
   vcg_plugin_common.finish ();
 }
 
+
+/* The delta log of the function recorded by the function-delta option,
+   and its file.  The log is given up if the file cannot be opened.  */
+
+static gdl_delta *delta_log;
+static FILE *delta_file;
+static int delta_failed_p;
+
+/* Plugin callback function for PLUGIN_PASS_EXECUTION event.  Append the
+   function named USER_DATA, as it is before the pass GCC_DATA, to its
+   delta log "<dump_base_name>.<name>.delta".  */
+
+void *
+vcg_plugin_callback_function_delta (void *gcc_data, void *user_data)
+{
+  struct opt_pass *pass = (struct opt_pass *) gcc_data;
+  char *name = (char *) user_data;
+  char *stem, *fname;
+
+  /* Only the passes which run on the function with a cfg.  */
+  if (delta_failed_p || cfun == NULL || cfun->cfg == NULL
+      || !(cfun->curr_properties & PROP_cfg)
+      || strcmp (current_function_name (), name))
+    return NULL;
+
+  if (delta_file == NULL)
+    {
+      stem = concat (dump_base_name, ".", name, NULL);
+      fname = vcg_plugin_common.file_name (stem, ".delta", 0);
+      free (stem);
+      delta_file = fopen (fname, "w");
+      if (delta_file == NULL)
+        {
+          vcg_plugin_common.error ("failed to open file %s.", fname);
+          free (fname);
+          delta_failed_p = 1;
+          return NULL;
+        }
+      free (fname);
+      delta_log = gdl_new_delta (delta_file);
+    }
+
+  vcg_plugin_common.init ();
+  create_names ();
+
+  create_function_graph (vcg_plugin_common.top_graph);
+  gdl_dump_delta_step (delta_log, pass->name, vcg_plugin_common.top_graph);
+
+  free_names (n_basic_blocks);
+  vcg_plugin_common.finish ();
+  return NULL;
+}
+
+/* Plugin callback function for PLUGIN_FINISH event.  Close the delta
+   log.  */
+
+void *
+vcg_plugin_callback_function_delta_finish (void *gcc_data, void *user_data)
+{
+  if (delta_log != NULL)
+    {
+      gdl_free_delta (delta_log);
+      delta_log = NULL;
+    }
+  if (delta_file != NULL)
+    {
+      fclose (delta_file);
+      delta_file = NULL;
+    }
+  return NULL;
+}
@@ -107,8 +107,7 @@ create_sub_pass_list_graph (gdl_graph *graph, struct opt_pass *pass_list,
   title = get_title (pass, NULL);
   subgraph = gdl_new_graph (title);
   gdl_set_graph_label (subgraph, label);
-  gdl_set_graph_folding (subgraph, 1);
-  gdl_set_graph_shape (subgraph, "ellipse");
+  gdl_set_graph_style (subgraph, vcg_plugin_common.folded_style);
   gdl_add_subgraph (graph, subgraph);
 
   if (pass->execute)
@@ -148,8 +147,7 @@ create_pass_list_graph (gdl_graph *graph, struct opt_pass *pass_list,
 
   subgraph = gdl_new_graph (name);
   gdl_set_graph_label (subgraph, name);
-  gdl_set_graph_folding (subgraph, 1);
-  gdl_set_graph_shape (subgraph, "ellipse");
+  gdl_set_graph_style (subgraph, vcg_plugin_common.folded_style);
   gdl_add_subgraph (graph, subgraph);
 
   for (pass = pass_list; pass; pass = pass->next)
@@ -186,12 +184,11 @@ dump_passes_to_file (char *fname)
 
   if (this_node)
     {
-      gdl_set_node_color (this_node, "red");
+      gdl_set_node_color (this_node, GDL_COLOR_RED);
       g = gdl_get_node_parent (this_node);
       while (g && g != graph)
         {
-          gdl_set_graph_color (g, "red");
-          gdl_set_graph_folding (g, 0);
+          gdl_set_graph_style (g, vcg_plugin_common.focused_style);
           g = gdl_get_graph_parent (g);
         }
     }
@@ -255,9 +252,23 @@ vcg_plugin_callback_passes_start (void *gcc_data, void *user_data)
 void *
 vcg_plugin_callback_pass (void *gcc_data, void *user_data)
 {
+  static tree last_decl;
+  static int selected_p = 1;
+  tree decl = cfun != NULL ? cfun->decl : NULL_TREE;
   gdl_graph *graph;
   gdl_node *node;
 
+  /* The passes on the functions which are not to be dumped are left
+     out.  The answer is kept for the passes on the same function.  */
+  if (decl != last_decl)
+    {
+      last_decl = decl;
+      selected_p = (decl == NULL_TREE
+                    || vcg_function_selected_p (current_function_name ()));
+    }
+  if (!selected_p)
+    return NULL;
+
   graph = vcg_plugin_common.top_graph;
   if (*(bool *)gcc_data)
     {
@@ -266,7 +277,7 @@ vcg_plugin_callback_pass (void *gcc_data, void *user_data)
   else
     {
       node = create_node (graph, current_pass, "[disable]");
-      gdl_set_node_color (node, "lightgrey");
+      gdl_set_node_style (node, vcg_plugin_common.disabled_style);
     }
 
   try_create_edge (graph, prev_node, node);
@@ -27,17 +27,45 @@ help (void)
   printf (
 "Usage: gcc -fplugin=/path/to/vcg_plugin.so -fplugin-arg-vcg_plugin-<option> ...\n" \
 "Options:\n" \
+"  archive=path         append the dumped files to the tar archive\n" \
+"                       <file>.path.tar, with an index of the members.\n" \
+"  async[=n]            write the dumped files in a background thread, with\n" \
+"                       at most n graphs waiting, default is 4.\n" \
+"  cache=dir            keep the dumped files in dir by their content, and\n" \
+"                       link the same graphs dumped again to them.\n" \
 "  cgraph               dump the call graph before IPA passes.\n" \
 "  cgraph-callee        dump the callee graph for each function.\n" \
 "  cgraph-caller        dump the caller graph for each function.\n" \
+"  fork-dump[=n]        dump the call graphs and hierarchy graphs in child\n" \
+"                       processes, at most n at once, default is 4; the\n" \
+"                       dumps of the passes and functions are not forked.\n" \
+"  filter=pattern       only dump the functions matching pattern, a regular\n" \
+"                       expression if it starts with ^, a wildcard else.\n" \
+"  format=name          set the format of the dumped files, vcg (the\n" \
+"                       default), dot, jsonl or svg; the graphs to view\n" \
+"                       are always in vcg.\n" \
+"  function-delta=name  record the function name before each pass into\n" \
+"                       the delta log <file>.name.delta.\n" \
 "  gimple-hierarchy     dump the gimple hierarchy graph.\n" \
 "  help                 show this help.\n" \
+"  max-edges=n          elide the edges of a graph beyond n.\n" \
+"  max-label-bytes=n    elide the labels of a graph beyond n bytes.\n" \
+"  max-nodes=n          elide the nodes of a graph beyond n.\n" \
+"  outdir=dir           write the files into the hashed subdirectories of\n" \
+"                       dir, named by unit, function, pass and pid.\n" \
 "  passes               dump the passes graph.\n" \
 "  pass-lists           dump the pass lists graph.\n" \
+"  sample=n             only dump about one in n functions.\n" \
+"  stats[=file.json]    report the cost of the dumps to stderr, or into\n" \
+"                       <file>.file.json, when gcc finishes.\n" \
+"  svg-max-nodes=n      use the coarse layout for the svg files of graphs\n" \
+"                       with more than n nodes, default is 2000.\n" \
 "  tree-hierarchy       dump the tree hierarchy graph.\n" \
 "  tree-hierarchy-4-6   dump the tree hierarchy graph for gcc 4.6.\n" \
 "  tree-hierarchy-4-7   dump the tree hierarchy graph for gcc 4.7.\n" \
 "  viewer=name          set the vcg viewer, default is vcgview.\n" \
+"  viewer-socket=path   push the viewed graphs into the persistent viewer\n" \
+"                       listening on the UNIX socket path.\n" \
 "  \n" \
 "%s %s <http://code.google.com/p/gcc-vcg-plugin>\n",
  vcg_plugin_common.plugin_name, vcg_plugin_common.version);
@@ -60,6 +88,18 @@ version_check (struct plugin_gcc_version *gcc_version,
   return true;
 }
 
+/* Register FUNC, which dumps a graph once, for EVENT.  It is run in a
+   child process in the fork-dump mode.  */
+
+static void
+register_dump_callback (const char *name, int event,
+                        void *(*func) (void *, void *))
+{
+  register_callback (name, event,
+                     (plugin_callback_func) vcg_plugin_callback_fork,
+                     (void *) func);
+}
+
 /* Plugin initialization.  */
 
 int
@@ -95,33 +135,212 @@ plugin_init (struct plugin_name_args *plugin_info,
           vcg_plugin_common.vcg_viewer = argv[i].value;
         }
 
-      /* Dump call graph.  */
-      if (strcmp (argv[i].key, "cgraph") == 0)
+      /* Write the dumped files in a background thread.  */
+      if (strcmp (argv[i].key, "async") == 0)
         {
+          if (argv[i].value != NULL && atoi (argv[i].value) <= 0)
+            {
+              vcg_plugin_common.error ("bad async %s.", argv[i].value);
+              return 1;
+            }
+          vcg_plugin_common.async_queue_size =
+            argv[i].value ? atoi (argv[i].value) : 4;
           register_callback (plugin_info->base_name,
-                             PLUGIN_ALL_IPA_PASSES_START,
-                             (plugin_callback_func) vcg_plugin_callback_cgraph,
+                             PLUGIN_FINISH,
+                             (plugin_callback_func) vcg_plugin_callback_async_finish,
                              NULL);
         }
 
-      /* Dump callee graph.  */
-      if (strcmp (argv[i].key, "cgraph-callee") == 0)
+      /* Dump in child processes.  */
+      if (strcmp (argv[i].key, "fork-dump") == 0)
         {
+          if (argv[i].value != NULL && atoi (argv[i].value) <= 0)
+            {
+              vcg_plugin_common.error ("bad fork-dump %s.", argv[i].value);
+              return 1;
+            }
+          vcg_plugin_common.fork_max =
+            argv[i].value ? atoi (argv[i].value) : 4;
           register_callback (plugin_info->base_name,
-                             PLUGIN_ALL_IPA_PASSES_START,
-                             (plugin_callback_func) vcg_plugin_callback_callee,
+                             PLUGIN_FINISH,
+                             (plugin_callback_func) vcg_plugin_callback_fork_finish,
                              NULL);
         }
 
-      /* Dump caller graph.  */
-      if (strcmp (argv[i].key, "cgraph-caller") == 0)
+      /* Get the socket of the persistent viewer.  */
+      if (strcmp (argv[i].key, "viewer-socket") == 0)
+        {
+          if (argv[i].value == NULL)
+            {
+              vcg_plugin_common.error ("viewer-socket needs a path.");
+              return 1;
+            }
+          vcg_plugin_common.viewer_socket = argv[i].value;
+        }
+
+      /* Append the dumped files to an archive.  */
+      if (strcmp (argv[i].key, "archive") == 0)
         {
+          if (argv[i].value == NULL)
+            {
+              vcg_plugin_common.error ("archive needs a path.");
+              return 1;
+            }
+          vcg_plugin_common.archive = argv[i].value;
           register_callback (plugin_info->base_name,
-                             PLUGIN_ALL_IPA_PASSES_START,
-                             (plugin_callback_func) vcg_plugin_callback_caller,
+                             PLUGIN_FINISH,
+                             (plugin_callback_func) vcg_plugin_callback_archive_finish,
                              NULL);
         }
 
+      /* Get the functions to dump.  */
+      if (strcmp (argv[i].key, "filter") == 0)
+        {
+          if (argv[i].value == NULL || !vcg_set_filter (argv[i].value))
+            {
+              vcg_plugin_common.error ("bad filter %s.",
+                                       argv[i].value ? argv[i].value : "");
+              return 1;
+            }
+        }
+
+      /* Only dump one in n functions.  */
+      if (strcmp (argv[i].key, "sample") == 0)
+        {
+          if (argv[i].value == NULL || atoi (argv[i].value) <= 0)
+            {
+              vcg_plugin_common.error ("bad sample %s.",
+                                       argv[i].value ? argv[i].value : "");
+              return 1;
+            }
+          vcg_plugin_common.sample = atoi (argv[i].value);
+        }
+
+      /* Measure the cost of the dumps.  */
+      if (strcmp (argv[i].key, "stats") == 0)
+        {
+          vcg_plugin_common.stats = 1;
+          vcg_plugin_common.stats_file = argv[i].value;
+          register_callback (plugin_info->base_name,
+                             PLUGIN_FINISH,
+                             (plugin_callback_func) vcg_plugin_callback_stats_finish,
+                             NULL);
+        }
+
+      /* Get the dump cache.  */
+      if (strcmp (argv[i].key, "cache") == 0)
+        {
+          if (argv[i].value == NULL)
+            {
+              vcg_plugin_common.error ("cache needs a directory.");
+              return 1;
+            }
+          vcg_plugin_common.cache_dir = argv[i].value;
+        }
+
+      /* Get the output directory.  */
+      if (strcmp (argv[i].key, "outdir") == 0)
+        {
+          if (argv[i].value == NULL)
+            {
+              vcg_plugin_common.error ("outdir needs a directory.");
+              return 1;
+            }
+          vcg_plugin_common.outdir = argv[i].value;
+        }
+
+      /* Get the format of the dumped files, default is "vcg".  */
+      if (strcmp (argv[i].key, "format") == 0)
+        {
+          if (argv[i].value && strcmp (argv[i].value, "vcg") == 0)
+            vcg_plugin_common.format = VCG_FORMAT_VCG;
+          else if (argv[i].value && strcmp (argv[i].value, "dot") == 0)
+            vcg_plugin_common.format = VCG_FORMAT_DOT;
+          else if (argv[i].value && strcmp (argv[i].value, "jsonl") == 0)
+            vcg_plugin_common.format = VCG_FORMAT_JSONL;
+          else if (argv[i].value && strcmp (argv[i].value, "svg") == 0)
+            vcg_plugin_common.format = VCG_FORMAT_SVG;
+          else
+            {
+              vcg_plugin_common.error ("unknown format %s.",
+                                       argv[i].value ? argv[i].value : "");
+              return 1;
+            }
+        }
+
+      /* Get the node count above which the svg layout is coarse.  */
+      if (strcmp (argv[i].key, "svg-max-nodes") == 0)
+        {
+          if (argv[i].value == NULL || atoi (argv[i].value) < 0)
+            {
+              vcg_plugin_common.error ("bad svg-max-nodes %s.",
+                                       argv[i].value ? argv[i].value : "");
+              return 1;
+            }
+          vcg_plugin_common.svg_max_nodes = atoi (argv[i].value);
+        }
+
+      /* Get the budget of the dumped graphs.  */
+      if (strcmp (argv[i].key, "max-nodes") == 0
+          || strcmp (argv[i].key, "max-edges") == 0
+          || strcmp (argv[i].key, "max-label-bytes") == 0)
+        {
+          if (argv[i].value == NULL || atol (argv[i].value) < 0)
+            {
+              vcg_plugin_common.error ("bad %s %s.", argv[i].key,
+                                       argv[i].value ? argv[i].value : "");
+              return 1;
+            }
+          if (strcmp (argv[i].key, "max-nodes") == 0)
+            vcg_plugin_common.max_nodes = atoi (argv[i].value);
+          else if (strcmp (argv[i].key, "max-edges") == 0)
+            vcg_plugin_common.max_edges = atoi (argv[i].value);
+          else
+            vcg_plugin_common.max_label_bytes = atol (argv[i].value);
+        }
+
+      /* Record a function across the passes.  */
+      if (strcmp (argv[i].key, "function-delta") == 0)
+        {
+          if (argv[i].value == NULL)
+            {
+              vcg_plugin_common.error ("function-delta needs a function name.");
+              return 1;
+            }
+          register_callback (plugin_info->base_name,
+                             PLUGIN_PASS_EXECUTION,
+                             (plugin_callback_func) vcg_plugin_callback_function_delta,
+                             argv[i].value);
+          register_callback (plugin_info->base_name,
+                             PLUGIN_FINISH,
+                             (plugin_callback_func) vcg_plugin_callback_function_delta_finish,
+                             NULL);
+        }
+
+      /* Dump call graph.  */
+      if (strcmp (argv[i].key, "cgraph") == 0)
+        {
+          register_dump_callback (plugin_info->base_name,
+                                  PLUGIN_ALL_IPA_PASSES_START,
+                                  vcg_plugin_callback_cgraph);
+        }
+
+      /* Dump callee graph.  */
+      if (strcmp (argv[i].key, "cgraph-callee") == 0)
+        {
+          register_dump_callback (plugin_info->base_name,
+                                  PLUGIN_ALL_IPA_PASSES_START,
+                                  vcg_plugin_callback_callee);
+        }
+
+      /* Dump caller graph.  */
+      if (strcmp (argv[i].key, "cgraph-caller") == 0)
+        {
+          register_dump_callback (plugin_info->base_name,
+                                  PLUGIN_ALL_IPA_PASSES_START,
+                                  vcg_plugin_callback_caller);
+        }
+
       /* Dump passes.  */
       if (strcmp (argv[i].key, "passes") == 0)
         {
@@ -142,46 +361,41 @@ plugin_init (struct plugin_name_args *plugin_info,
       /* Dump gcc pass lists.  */
       if (strcmp (argv[i].key, "pass-lists") == 0)
         {
-          register_callback (plugin_info->base_name,
-                             PLUGIN_FINISH,
-                             (plugin_callback_func) vcg_plugin_callback_pass_lists,
-                             NULL);
+          register_dump_callback (plugin_info->base_name,
+                                  PLUGIN_FINISH,
+                                  vcg_plugin_callback_pass_lists);
         }
 
       /* Dump gimple hierarchy graph.  */
       if (strcmp (argv[i].key, "gimple-hierarchy") == 0)
         {
-          register_callback (plugin_info->base_name,
-                             PLUGIN_FINISH,
-                             (plugin_callback_func) vcg_plugin_callback_gimple_hierarchy,
-                             NULL);
+          register_dump_callback (plugin_info->base_name,
+                                  PLUGIN_FINISH,
+                                  vcg_plugin_callback_gimple_hierarchy);
         }
 
       /* Dump tree hierarchy graph.  */
       if (strcmp (argv[i].key, "tree-hierarchy") == 0)
         {
-          register_callback (plugin_info->base_name,
-                             PLUGIN_FINISH,
-                             (plugin_callback_func) vcg_plugin_callback_tree_hierarchy,
-                             NULL);
+          register_dump_callback (plugin_info->base_name,
+                                  PLUGIN_FINISH,
+                                  vcg_plugin_callback_tree_hierarchy);
         }
 
       /* Dump tree hierarchy graph.  */
       if (strcmp (argv[i].key, "tree-hierarchy-4-6") == 0)
         {
-          register_callback (plugin_info->base_name,
-                             PLUGIN_FINISH,
-                             (plugin_callback_func) vcg_plugin_callback_tree_hierarchy_4_6,
-                             NULL);
+          register_dump_callback (plugin_info->base_name,
+                                  PLUGIN_FINISH,
+                                  vcg_plugin_callback_tree_hierarchy_4_6);
         }
 
       /* Dump tree hierarchy graph.  */
       if (strcmp (argv[i].key, "tree-hierarchy-4-7") == 0)
         {
-          register_callback (plugin_info->base_name,
-                             PLUGIN_FINISH,
-                             (plugin_callback_func) vcg_plugin_callback_tree_hierarchy_4_7,
-                             NULL);
+          register_dump_callback (plugin_info->base_name,
+                                  PLUGIN_FINISH,
+                                  vcg_plugin_callback_tree_hierarchy_4_7);
         }
 
       if (strcmp (argv[i].key, "help") == 0)
@@ -90,7 +90,7 @@ create_dashed_edge (gdl_graph *graph, gdl_node *sn, gdl_node *tn)
 
   edge = gdl_new_graph_edge (graph, gdl_get_node_title (sn),
                              gdl_get_node_title (tn));
-  gdl_set_edge_linestyle (edge, "dashed");
+  gdl_set_edge_style (edge, vcg_plugin_common.dashed_style);
 }
 
 static gdl_node *
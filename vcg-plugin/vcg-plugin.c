@@ -17,8 +17,102 @@
 
 #include "vcg-plugin.h"
 
-/* Used as a string buffer.  */
+#include <pthread.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <regex.h>
+
+/* Used as a string buffer.  It lives as long as the plugin, and is
+   rewound to STR_OBSTACK_MARK after each view/dump command.  */
 static struct obstack str_obstack;
+static char *str_obstack_mark;
+
+/* The temp stream is opened again after a command which has made its
+   buffer larger than this, so that one big function does not keep the
+   memory for the rest of the session.  */
+#define STREAM_KEEP_SIZE (1024 * 1024)
+
+/* Where a dumped graph goes: its file, a member of the archive, its
+   file linked to the cache, or the temp file to view, which is always in
+   the vcg format.  */
+
+typedef enum
+{
+  SINK_FILE,
+  SINK_ARCHIVE,
+  SINK_CACHE,
+  SINK_VIEW
+} vcg_sink;
+
+/* A top graph waiting for the writer thread, with its hash, and the file
+   to write it into.  */
+
+typedef struct vcg_job
+{
+  char *fname;
+  gdl_graph *graph;
+  gdl_hashval hash;
+  vcg_sink sink;
+  vcg_stats_entry *stats;
+  struct vcg_job *next;
+} vcg_job;
+
+/* The writer thread of the async mode, and its queue.  The job being
+   written stays at the head of the queue until it is done, so JOB_NUM
+   counts it as well.  */
+static pthread_t writer_thread;
+static int writer_started_p;
+static int writer_stop_p;
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_cond = PTHREAD_COND_INITIALIZER;
+static vcg_job *job_head;
+static vcg_job *job_tail;
+static int job_num;
+
+/* The top graph has been handed to the writer thread, which frees it.  */
+static int top_graph_handed_p;
+
+/* The anonymous memory file holding the graph to view, or -1.  */
+static int temp_fd = -1;
+
+/* The archive which the dumped files are appended to, see
+   open_archive, or -1.  */
+static int archive_fd = -1;
+
+/* The connection to the persistent viewer, or -1.  */
+static int viewer_fd = -1;
+
+/* The child processes of the fork-dump mode which may be dumping, oldest
+   first.  */
+static pid_t *fork_pids;
+static int fork_num;
+
+/* The file written by the last dump into it, and the hash of the graph
+   which was written.  */
+
+typedef struct
+{
+  char *fname;
+  gdl_hashval hash;
+} dump_record;
+
+/* The dump records, keyed by file name.  */
+static htab_t dump_records;
+
+/* The file name extensions of the formats.  */
+static const char *format_extensions[VCG_FORMAT_MAX] =
+{
+  ".vcg",
+  ".dot",
+  ".jsonl",
+  ".svg"
+};
 
 /* Print error messages.  */
 
@@ -34,30 +128,1014 @@ vcg_error (const char *format, ...)
   fputc ('\n', stderr);
 }
 
-/* Dump the top graph into file FNAME.  */
+static hashval_t
+dump_record_hash (const void *p)
+{
+  return htab_hash_string (((const dump_record *) p)->fname);
+}
+
+static int
+dump_record_eq (const void *p1, const void *p2)
+{
+  return strcmp (((const dump_record *) p1)->fname,
+                 ((const dump_record *) p2)->fname) == 0;
+}
 
 static void
-vcg_dump (char *fname)
+dump_record_del (void *p)
+{
+  free (((dump_record *) p)->fname);
+  free (p);
+}
+
+/* Return 1 if the top graph, whose hash is HASH, is unchanged since the
+   last time it was dumped into FNAME, and the file is still there, or in
+   the archive for SINK_ARCHIVE.  Record it as the last dump into FNAME
+   otherwise.  */
+
+static int
+vcg_dump_unchanged_p (char *fname, gdl_hashval hash, vcg_sink sink)
+{
+  dump_record key, *rec;
+  void **slot;
+
+  if (dump_records == NULL)
+    dump_records = htab_create (16, dump_record_hash, dump_record_eq,
+                                dump_record_del);
+
+  key.fname = fname;
+  key.hash = hash;
+  slot = htab_find_slot (dump_records, &key, INSERT);
+  rec = (dump_record *) *slot;
+  if (rec != NULL && rec->hash == key.hash
+      && (sink == SINK_ARCHIVE || access (fname, F_OK) == 0))
+    return 1;
+
+  if (rec == NULL)
+    {
+      rec = XNEW (dump_record);
+      rec->fname = xstrdup (fname);
+      *slot = rec;
+    }
+  rec->hash = key.hash;
+  return 0;
+}
+
+/* The number of the subdirectories of the output directory, which the
+   files are spread over by the hash of their names.  */
+#define OUTDIR_FANOUT 256
+
+/* The output directory and its subdirectories have been made.  */
+static int outdir_made_p;
+static char outdir_sub_made_p[OUTDIR_FANOUT];
+
+/* The longest function or pass name kept in a file name.  */
+#define NAME_PART_MAX 64
+
+/* Return a copy of S to be a part of a file name, with the characters
+   other than letters, digits, '_', '-' and '.' replaced by '_', and cut
+   to NAME_PART_MAX characters.  */
+
+static char *
+name_part (const char *s)
+{
+  char *part, *p;
+
+  part = xstrndup (s, NAME_PART_MAX);
+  for (p = part; *p != '\0'; p++)
+    if (!ISALNUM (*p) && *p != '_' && *p != '-' && *p != '.')
+      *p = '_';
+  return part;
+}
+
+/* Make the directory DIR unless it is there.  */
+
+static void
+make_dir (const char *dir)
+{
+  if (mkdir (dir, 0777) != 0 && errno != EEXIST)
+    vcg_plugin_common.error ("failed to make directory %s.", dir);
+}
+
+/* Return the name of the file to write for FNAME, without its ".vcg"
+   extension, and the extension EXT.  The name is allocated.
+
+   Without an output directory, it is FNAME with EXT in place of ".vcg".
+   Otherwise the name is made unique by the translation unit, the current
+   function and pass if OBJECT_P, and the process id,
+   "<tu>.<fname>.<function>.<pass>.<pid><ext>", and the file is put in
+   one of the OUTDIR_FANOUT subdirectories of the output directory by the
+   hash of the name, so that parallel compilations do not write the same
+   files nor crowd one directory.  */
+
+static char *
+vcg_file_name (char *fname, const char *ext, int object_p)
+{
+  const char *outdir = vcg_plugin_common.outdir;
+  const char *base, *tu;
+  char *stem, *leaf, *func, *pass, *name;
+  char pid[32], sub[8];
+  size_t len = strlen (fname);
+  unsigned h;
+
+  if (len >= 4 && !strcmp (fname + len - 4, ".vcg"))
+    len -= 4;
+
+  if (outdir == NULL)
+    {
+      name = XNEWVEC (char, len + strlen (ext) + 1);
+      memcpy (name, fname, len);
+      strcpy (name + len, ext);
+      return name;
+    }
+
+  /* The dumps named after dump_base_name have the unit already.  */
+  stem = xstrndup (fname, len);
+  base = lbasename (stem);
+  tu = dump_base_name != NULL ? lbasename (dump_base_name) : "";
+  if (strncmp (base, tu, strlen (tu)) == 0)
+    tu = "";
+
+  func = object_p && cfun != NULL
+         ? name_part (current_function_name ()) : NULL;
+  pass = object_p && current_pass != NULL && current_pass->name != NULL
+         ? name_part (current_pass->name) : NULL;
+  sprintf (pid, ".%ld", (long) getpid ());
+
+  leaf = concat (tu, *tu != '\0' ? "." : "", base,
+                 func != NULL ? "." : "", func != NULL ? func : "",
+                 pass != NULL ? "." : "", pass != NULL ? pass : "",
+                 pid, ext, NULL);
+
+  h = htab_hash_string (leaf) % OUTDIR_FANOUT;
+  sprintf (sub, "/%02x/", h);
+
+  if (!outdir_made_p)
+    {
+      make_dir (outdir);
+      outdir_made_p = 1;
+    }
+  name = concat (outdir, sub, leaf, NULL);
+  if (!outdir_sub_made_p[h])
+    {
+      name[strlen (outdir) + 3] = '\0';
+      make_dir (name);
+      name[strlen (outdir) + 3] = '/';
+      outdir_sub_made_p[h] = 1;
+    }
+
+  free (stem);
+  free (func);
+  free (pass);
+  free (leaf);
+  return name;
+}
+
+/* The filter of the functions to dump, see vcg_set_filter.  */
+static char *filter_glob;
+static regex_t filter_regex;
+static int filter_regex_p;
+
+/* Restrict the dumps of each function to the functions whose name
+   matches PATTERN, a regular expression if it starts with '^', or a
+   shell wildcard pattern otherwise.  The pattern is compiled once here.
+   Return 0 if it is bad.  */
+
+int
+vcg_set_filter (char *pattern)
+{
+  int err;
+
+  if (pattern[0] != '^')
+    {
+      filter_glob = pattern;
+      return 1;
+    }
+
+  err = regcomp (&filter_regex, pattern, REG_EXTENDED | REG_NOSUB);
+  if (err != 0)
+    return 0;
+  filter_regex_p = 1;
+  return 1;
+}
+
+/* Return 1 if the function NAME is to be dumped, which is when it passes
+   the filter and is sampled.  The sampling goes by the hash of the name,
+   so that the same functions are picked by every dump and every run.  */
+
+int
+vcg_function_selected_p (const char *name)
+{
+  if (filter_glob != NULL && fnmatch (filter_glob, name, 0) != 0)
+    return 0;
+  if (filter_regex_p && regexec (&filter_regex, name, 0, NULL, 0) != 0)
+    return 0;
+  if (vcg_plugin_common.sample > 1
+      && htab_hash_string (name) % vcg_plugin_common.sample != 0)
+    return 0;
+  return 1;
+}
+
+/* Return the name of the file to dump into for FNAME, which is given
+   with the ".vcg" extension, in the current format.  The temp file is
+   kept in the vcg format, which the viewer reads.  The name is
+   allocated.  */
+
+static char *
+vcg_dump_file_name (char *fname)
+{
+  vcg_format_t format = vcg_plugin_common.format;
+
+  if (!strcmp (fname, vcg_plugin_common.temp_file_name))
+    format = VCG_FORMAT_VCG;
+  return vcg_file_name (fname, format_extensions[format], 1);
+}
+
+/* Write GRAPH into the stream FP in FORMAT.  Return the number of bytes
+   written.  */
+
+static long
+write_graph (FILE *fp, gdl_graph *graph, vcg_format_t format)
+{
+  /* Put the version information on top, where the format has
+     comments.  */
+  if (format == VCG_FORMAT_SVG)
+    fprintf (fp, "<!-- Generated by GCC VCG Plugin %s\n" \
+                 "     Report bugs to <mingjie.xing@gmail.com>\n" \
+                 "     Home page: http://code.google.com/p/gcc-vcg-plugin\n" \
+                 "     %s-->\n", vcg_plugin_common.version,
+             vcg_plugin_common.info);
+  else if (format != VCG_FORMAT_JSONL)
+    fprintf (fp, "// Generated by GCC VCG Plugin %s\n" \
+                 "// Report bugs to <mingjie.xing@gmail.com>\n" \
+                 "// Home page: http://code.google.com/p/gcc-vcg-plugin\n" \
+                 "// %s", vcg_plugin_common.version, vcg_plugin_common.info);
+
+  switch (format)
+    {
+    case VCG_FORMAT_DOT:
+      gdl_dump_graph_dot (fp, graph);
+      break;
+    case VCG_FORMAT_JSONL:
+      gdl_dump_graph_jsonl (fp, graph);
+      break;
+    case VCG_FORMAT_SVG:
+      gdl_dump_graph_svg (fp, graph, vcg_plugin_common.svg_max_nodes);
+      break;
+    default:
+      gdl_dump_graph (fp, graph);
+      break;
+    }
+  return ftell (fp);
+}
+
+/* Write GRAPH into the file FNAME in FORMAT.  Return the number of
+   bytes written, or 0 on failure.  */
+
+static long
+write_graph_file (char *fname, gdl_graph *graph, vcg_format_t format)
 {
   FILE *fp;
+  long bytes;
 
+  /* The old file may be linked to the cache, which must not be
+     truncated through it.  */
+  unlink (fname);
   if ((fp = fopen (fname, "w")) == NULL)
     {
       vcg_plugin_common.error ("failed to open file %s.", fname);
+      return 0;
+    }
+  bytes = write_graph (fp, graph, format);
+  if (ferror (fp))
+    bytes = 0;
+  if (fclose (fp) != 0 || bytes == 0)
+    {
+      vcg_plugin_common.error ("failed to write file %s.", fname);
+      return 0;
+    }
+  return bytes;
+}
+
+/* The cache directory and its subdirectories have been made.  */
+static int cache_made_p;
+static char cache_sub_made_p[OUTDIR_FANOUT];
+
+/* Return the name of the file in the cache for a graph whose hash is
+   HASH, and its subdirectory in SUB.  The name is allocated.  The hash
+   is mixed with everything else which goes into the file, the format and
+   the version.  */
+
+static char *
+cache_file_name (gdl_hashval hash, unsigned *sub)
+{
+  const char *dir = vcg_plugin_common.cache_dir;
+  const gdl_hashval prime = 0x100000001b3ULL;
+  char key[32];
+
+  hash = (hash * prime) ^ vcg_plugin_common.format;
+  hash = (hash * prime) ^ vcg_plugin_common.svg_max_nodes;
+  hash = (hash * prime) ^ htab_hash_string (vcg_plugin_common.version);
+  if (vcg_plugin_common.info != NULL)
+    hash = (hash * prime) ^ htab_hash_string (vcg_plugin_common.info);
+
+  *sub = hash % OUTDIR_FANOUT;
+  sprintf (key, "/%02x/%016llx", *sub, (unsigned long long) hash);
+  return concat (dir, key, format_extensions[vcg_plugin_common.format],
+                 NULL);
+}
+
+/* Write GRAPH, whose hash is HASH, into the file FNAME through the
+   cache.  If the cache holds the same graph, FNAME becomes a hard link to
+   it and nothing is written; otherwise the file written is added to the
+   cache.  The files linked to the cache are never written in place.
+   Return the number of bytes written.  */
+
+static long
+write_graph_cached (char *fname, gdl_graph *graph, gdl_hashval hash)
+{
+  const char *dir = vcg_plugin_common.cache_dir;
+  struct stat cache_st, st;
+  char *cname;
+  unsigned sub;
+  size_t len;
+  long bytes;
+
+  cname = cache_file_name (hash, &sub);
+  if (stat (cname, &cache_st) == 0)
+    {
+      /* The file may be the cached one already, from the last build.  */
+      if (stat (fname, &st) == 0 && st.st_dev == cache_st.st_dev
+          && st.st_ino == cache_st.st_ino)
+        {
+          free (cname);
+          return 0;
+        }
+      unlink (fname);
+      if (link (cname, fname) == 0)
+        {
+          free (cname);
+          return 0;
+        }
+    }
+  else
+    {
+      len = strlen (dir);
+      if (!cache_made_p)
+        {
+          make_dir (dir);
+          cache_made_p = 1;
+        }
+      if (!cache_sub_made_p[sub])
+        {
+          cname[len + 3] = '\0';
+          make_dir (cname);
+          cname[len + 3] = '/';
+          cache_sub_made_p[sub] = 1;
+        }
+    }
+
+  /* Another compilation may have added the same graph meanwhile.  */
+  bytes = write_graph_file (fname, graph, vcg_plugin_common.format);
+  if (bytes > 0 && link (fname, cname) != 0 && errno != EEXIST)
+    vcg_plugin_common.error ("failed to add file %s to the cache.", fname);
+  free (cname);
+  return bytes;
+}
+
+/* The tar archive is made of blocks of TAR_BLOCK bytes.  */
+#define TAR_BLOCK 512
+#define TAR_ROUND(n) (((n) + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK)
+
+/* Open the archive of the dumped files if it is asked for and not yet
+   open.  Return 1 if the dumped files go into the archive.  */
+
+static int
+open_archive (void)
+{
+  const char *archive = vcg_plugin_common.archive;
+  char *stem, *name;
+  size_t len;
+
+  if (archive == NULL)
+    return 0;
+  if (archive_fd >= 0)
+    return 1;
+
+  len = strlen (archive);
+  if (len >= 4 && !strcmp (archive + len - 4, ".tar"))
+    len -= 4;
+  /* Each unit has its own archive "<dump_base_name>.<archive>.tar", since
+     it is truncated when opened.  */
+  name = xstrndup (archive, len);
+  stem = concat (dump_base_name, ".", name, NULL);
+  free (name);
+  name = vcg_file_name (stem, ".tar", 0);
+  free (stem);
+
+  /* The children of the fork-dump mode append to it as well.  */
+  archive_fd = open (name, O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0666);
+  if (archive_fd < 0)
+    {
+      vcg_plugin_common.error ("failed to open file %s.", name);
+      vcg_plugin_common.archive = NULL;
+    }
+  free (name);
+  return archive_fd >= 0;
+}
+
+/* Fill the tar header block HDR for a member NAME of SIZE bytes, of the
+   type TYPE.  */
+
+static void
+tar_header (char *hdr, const char *name, size_t size, char type)
+{
+  unsigned sum = 0;
+  int i;
+
+  memset (hdr, 0, TAR_BLOCK);
+  strncpy (hdr, name, 100);
+  strcpy (hdr + 100, "0000644");
+  strcpy (hdr + 108, "0000000");
+  strcpy (hdr + 116, "0000000");
+  sprintf (hdr + 124, "%011lo", (unsigned long) size);
+  sprintf (hdr + 136, "%011lo", (unsigned long) time (NULL));
+  hdr[156] = type;
+  memcpy (hdr + 257, "ustar", 6);
+  memcpy (hdr + 263, "00", 2);
+
+  /* The checksum is taken with its own field as spaces.  */
+  memset (hdr + 148, ' ', 8);
+  for (i = 0; i < TAR_BLOCK; i++)
+    sum += (unsigned char) hdr[i];
+  sprintf (hdr + 148, "%06o", sum);
+}
+
+/* Append LEN bytes of DATA to the archive as the member NAME.  A name
+   too long for the tar header goes into a pax header before it.  The
+   member is appended by a single write, so that the writes of the
+   fork-dump children do not interleave.  */
+
+static void
+append_member (const char *name, const char *data, size_t len)
+{
+  static const char zeros[TAR_BLOCK];
+  char hdr[2 * TAR_BLOCK], *pax = NULL;
+  struct iovec iov[5];
+  size_t pax_len, total = 0;
+  int n = 0, i, digits;
+
+  if (strlen (name) >= 100)
+    {
+      /* The pax record "<len> path=<name>\n" counts its own length.  */
+      pax_len = strlen (" path=") + strlen (name) + 1;
+      for (digits = 1;
+           snprintf (NULL, 0, "%lu", (unsigned long) (pax_len + digits))
+           != digits;
+           digits++)
+        ;
+      pax_len += digits;
+      pax = XCNEWVEC (char, TAR_ROUND (pax_len) + 1);
+      sprintf (pax, "%lu path=%s\n", (unsigned long) pax_len, name);
+      tar_header (hdr, "././@PaxHeader", pax_len, 'x');
+      iov[n].iov_base = hdr;
+      iov[n++].iov_len = TAR_BLOCK;
+      iov[n].iov_base = pax;
+      iov[n++].iov_len = TAR_ROUND (pax_len);
+    }
+
+  tar_header (hdr + TAR_BLOCK, name, len, '0');
+  iov[n].iov_base = hdr + TAR_BLOCK;
+  iov[n++].iov_len = TAR_BLOCK;
+  iov[n].iov_base = (void *) data;
+  iov[n++].iov_len = len;
+  if (TAR_ROUND (len) > len)
+    {
+      iov[n].iov_base = (void *) zeros;
+      iov[n++].iov_len = TAR_ROUND (len) - len;
+    }
+
+  for (i = 0; i < n; i++)
+    total += iov[i].iov_len;
+  if (writev (archive_fd, iov, n) != (ssize_t) total)
+    vcg_plugin_common.error ("failed to write the archive.");
+  free (pax);
+}
+
+/* Append GRAPH to the archive as the member named after the file FNAME,
+   in the current format.  Return the number of bytes written.  */
+
+static long
+write_graph_member (char *fname, gdl_graph *graph)
+{
+  char *buf = NULL;
+  size_t size = 0;
+  FILE *fp;
+
+  if ((fp = open_memstream (&buf, &size)) == NULL)
+    {
+      vcg_plugin_common.error ("failed to write the archive.");
+      return 0;
+    }
+  write_graph (fp, graph, vcg_plugin_common.format);
+  fclose (fp);
+  append_member (lbasename (fname), buf, size);
+  free (buf);
+  return size;
+}
+
+/* Write GRAPH, whose hash is HASH, for the file FNAME into SINK.
+   Return the number of bytes written.  */
+
+static long
+write_graph_sink (char *fname, gdl_graph *graph, gdl_hashval hash,
+                  vcg_sink sink)
+{
+  switch (sink)
+    {
+    case SINK_ARCHIVE:
+      return write_graph_member (fname, graph);
+    case SINK_CACHE:
+      return write_graph_cached (fname, graph, hash);
+    case SINK_VIEW:
+      return write_graph_file (fname, graph, VCG_FORMAT_VCG);
+    default:
+      return write_graph_file (fname, graph, vcg_plugin_common.format);
+    }
+}
+
+/* Write the top graph to view into a new anonymous memory file, which
+   the viewer reads through /proc/self/fd.  Nothing goes to the disk, and
+   the views of concurrent sessions do not clobber each other.  Return the
+   number of bytes written, or 0 if there is no such file, so that the
+   temp file is written instead.  */
+
+static long
+dump_temp (void)
+{
+#ifdef MFD_CLOEXEC
+  FILE *fp;
+  long bytes;
+  int fd;
+
+  /* A graph dumped but never shown.  */
+  if (temp_fd >= 0)
+    close (temp_fd);
+
+  /* The file is inherited by the viewer.  */
+  if ((temp_fd = memfd_create ("vcg-plugin", 0)) < 0)
+    return 0;
+  if ((fd = dup (temp_fd)) < 0 || (fp = fdopen (fd, "w")) == NULL)
+    {
+      if (fd >= 0)
+        close (fd);
+      close (temp_fd);
+      temp_fd = -1;
+      return 0;
+    }
+  bytes = write_graph (fp, vcg_plugin_common.top_graph, VCG_FORMAT_VCG);
+  fclose (fp);
+  return bytes;
+#else
+  return 0;
+#endif
+}
+
+/* The writer thread.  Write and free the graphs in the queue until it is
+   stopped.  */
+
+static void *
+writer_main (void *data ATTRIBUTE_UNUSED)
+{
+  vcg_job *job;
+  double start;
+  long bytes;
+
+  pthread_mutex_lock (&writer_lock);
+  for (;;)
+    {
+      while (job_head == NULL && !writer_stop_p)
+        pthread_cond_wait (&writer_cond, &writer_lock);
+      if (job_head == NULL)
+        break;
+
+      job = job_head;
+      pthread_mutex_unlock (&writer_lock);
+      start = vcg_stats_time ();
+      bytes = write_graph_sink (job->fname, job->graph, job->hash, job->sink);
+      vcg_stats_written (job->stats, start, bytes);
+      gdl_free_graph (job->graph);
+      free (job->fname);
+      pthread_mutex_lock (&writer_lock);
+
+      job_head = job->next;
+      if (job_head == NULL)
+        job_tail = NULL;
+      job_num--;
+      free (job);
+      pthread_cond_broadcast (&writer_cond);
+    }
+  pthread_mutex_unlock (&writer_lock);
+  return NULL;
+}
+
+/* Hand the top graph, whose hash is HASH, to the writer thread to be
+   written for FNAME, which is taken over, into SINK.  The cost of
+   writing is added to STATS.  Wait while the queue is full.  Return 0 if
+   the thread cannot be started.  */
+
+static int
+vcg_dump_async (char *fname, gdl_hashval hash, vcg_sink sink,
+                vcg_stats_entry *stats)
+{
+  vcg_job *job;
+
+  pthread_mutex_lock (&writer_lock);
+  if (!writer_started_p)
+    {
+      if (pthread_create (&writer_thread, NULL, writer_main, NULL) != 0)
+        {
+          pthread_mutex_unlock (&writer_lock);
+          vcg_plugin_common.error ("failed to start the writer thread.");
+          vcg_plugin_common.async_queue_size = 0;
+          return 0;
+        }
+      writer_started_p = 1;
+    }
+  while (job_num >= vcg_plugin_common.async_queue_size)
+    pthread_cond_wait (&writer_cond, &writer_lock);
+  pthread_mutex_unlock (&writer_lock);
+
+  /* The labels may live in the string obstack or in gcc, which do not
+     outlive this dump.  */
+  gdl_intern_graph (vcg_plugin_common.top_graph);
+
+  job = XNEW (vcg_job);
+  job->fname = fname;
+  job->graph = vcg_plugin_common.top_graph;
+  job->hash = hash;
+  job->sink = sink;
+  job->stats = stats;
+  job->next = NULL;
+  top_graph_handed_p = 1;
+
+  pthread_mutex_lock (&writer_lock);
+  if (job_tail == NULL)
+    job_head = job;
+  else
+    job_tail->next = job;
+  job_tail = job;
+  job_num++;
+  pthread_cond_broadcast (&writer_cond);
+  pthread_mutex_unlock (&writer_lock);
+  return 1;
+}
+
+/* Wait until the writer thread has written all the graphs.  */
+
+static void
+vcg_flush (void)
+{
+  if (!writer_started_p)
+    return;
+
+  pthread_mutex_lock (&writer_lock);
+  while (job_num > 0)
+    pthread_cond_wait (&writer_cond, &writer_lock);
+  pthread_mutex_unlock (&writer_lock);
+}
+
+/* Plugin callback function for PLUGIN_FINISH event.  Write the graphs
+   still in the queue and stop the writer thread.  The dumps after it are
+   written synchronously.  */
+
+void *
+vcg_plugin_callback_async_finish (void *gcc_data, void *user_data)
+{
+  vcg_plugin_common.async_queue_size = 0;
+  if (!writer_started_p)
+    return NULL;
+
+  pthread_mutex_lock (&writer_lock);
+  writer_stop_p = 1;
+  pthread_cond_broadcast (&writer_cond);
+  pthread_mutex_unlock (&writer_lock);
+  pthread_join (writer_thread, NULL);
+  writer_started_p = 0;
+  return NULL;
+}
+
+/* Forget the children of the fork-dump mode which are done, and wait
+   for the oldest ones until there are fewer than MAX.  */
+
+static void
+reap_children (int max)
+{
+  int i, j;
+
+  for (i = j = 0; i < fork_num; i++)
+    if (waitpid (fork_pids[i], NULL, WNOHANG) == 0)
+      fork_pids[j++] = fork_pids[i];
+  fork_num = j;
+
+  for (i = 0; fork_num - i >= max && i < fork_num; i++)
+    waitpid (fork_pids[i], NULL, 0);
+  memmove (fork_pids, fork_pids + i, (fork_num - i) * sizeof (pid_t));
+  fork_num -= i;
+}
+
+/* Plugin callback function for the events of the dumps registered by
+   register_dump_callback.  Run the dump USER_DATA, in a child process in
+   the fork-dump mode, which has a copy-on-write view of the IR and exits
+   after the dump, so that the compilation goes on at once.  */
+
+void *
+vcg_plugin_callback_fork (void *gcc_data, void *user_data)
+{
+  void *(*func) (void *, void *) = (void *(*) (void *, void *)) user_data;
+  pid_t pid;
+
+  if (vcg_plugin_common.fork_max <= 0)
+    return func (gcc_data, NULL);
+
+  if (fork_pids == NULL)
+    fork_pids = XNEWVEC (pid_t, vcg_plugin_common.fork_max);
+  reap_children (vcg_plugin_common.fork_max);
+
+  /* The children append to the archive of the parent.  */
+  open_archive ();
+
+  /* The writer thread must hold no lock, e.g. of the stats, which the
+     child would wait for forever.  It holds none once it is idle.  */
+  vcg_flush ();
+
+  /* Do not let the child write what is buffered once more.  */
+  fflush (NULL);
+  pid = fork ();
+  if (pid < 0)
+    {
+      vcg_plugin_common.error ("failed to fork, dumping in place.");
+      return func (gcc_data, NULL);
+    }
+
+  if (pid == 0)
+    {
+      /* The writer thread is not in the child.  */
+      writer_started_p = 0;
+      vcg_plugin_common.async_queue_size = 0;
+      func (gcc_data, NULL);
+      fflush (NULL);
+      /* Skip the exit handlers of gcc, which belong to the parent.  */
+      _exit (0);
+    }
+
+  fork_pids[fork_num++] = pid;
+  return NULL;
+}
+
+/* Plugin callback function for PLUGIN_FINISH event.  Wait for the
+   children of the fork-dump mode.  The dumps after it are done in
+   place.  */
+
+void *
+vcg_plugin_callback_fork_finish (void *gcc_data, void *user_data)
+{
+  reap_children (1);
+  vcg_plugin_common.fork_max = 0;
+  free (fork_pids);
+  fork_pids = NULL;
+  return NULL;
+}
+
+/* Plugin callback function for PLUGIN_FINISH event.  Close the archive
+   after the writer thread and the fork-dump children are done, with an
+   index of its members at the end, the member "index" of lines "OFFSET
+   SIZE NAME" giving where the data of each member is.  The dumps after
+   it are written into files.  */
+
+void *
+vcg_plugin_callback_archive_finish (void *gcc_data, void *user_data)
+{
+  static const char zeros[2 * TAR_BLOCK];
+  char hdr[TAR_BLOCK], *pax, *p, *name, *buf = NULL;
+  size_t size = 0, len;
+  off_t off = 0;
+  FILE *fp;
+
+  vcg_plugin_callback_async_finish (gcc_data, user_data);
+  vcg_plugin_callback_fork_finish (gcc_data, user_data);
+  vcg_plugin_common.archive = NULL;
+  if (archive_fd < 0)
+    return NULL;
+
+  /* Walk the headers, as the children have appended members too.  */
+  if ((fp = open_memstream (&buf, &size)) == NULL)
+    {
+      vcg_plugin_common.error ("failed to write the archive.");
+      close (archive_fd);
+      archive_fd = -1;
+      return NULL;
+    }
+  name = NULL;
+  while (pread (archive_fd, hdr, TAR_BLOCK, off) == TAR_BLOCK
+         && hdr[0] != '\0')
+    {
+      len = strtoul (hdr + 124, NULL, 8);
+      off += TAR_BLOCK;
+      if (hdr[156] == 'x')
+        {
+          /* The long name of the next member.  */
+          pax = XNEWVEC (char, len + 1);
+          if (pread (archive_fd, pax, len, off) == (ssize_t) len)
+            {
+              pax[len] = '\0';
+              if ((p = strstr (pax, " path=")) != NULL)
+                {
+                  free (name);
+                  name = xstrndup (p + 6, strcspn (p + 6, "\n"));
+                }
+            }
+          free (pax);
+        }
+      else
+        {
+          if (name == NULL)
+            name = xstrndup (hdr, 100);
+          fprintf (fp, "%lu %lu %s\n", (unsigned long) off,
+                   (unsigned long) len, name);
+          free (name);
+          name = NULL;
+        }
+      off += TAR_ROUND (len);
+    }
+  free (name);
+  fclose (fp);
+
+  append_member ("index", buf, size);
+  free (buf);
+
+  /* The end of the archive.  */
+  if (write (archive_fd, zeros, sizeof (zeros)) != sizeof (zeros))
+    vcg_plugin_common.error ("failed to write the archive.");
+  close (archive_fd);
+  archive_fd = -1;
+  return NULL;
+}
+
+/* Dump the top graph into file FNAME, with the extension of the current
+   format.  The file is left alone if it already holds the same graph.
+   In the async mode, the graph is written and freed by the writer
+   thread, so it must not be touched after the dump.  The graph to view
+   goes to a memory file if possible, see dump_temp; the other graphs go
+   into the archive or through the cache if there is one.  */
+
+static void
+vcg_dump (char *fname)
+{
+  vcg_stats_entry *stats;
+  gdl_hashval hash;
+  double start;
+  long bytes;
+  vcg_sink sink;
+
+  stats = vcg_stats_dump (fname, vcg_plugin_common.top_graph);
+  start = stats != NULL ? vcg_stats_time () : 0;
+
+  if (!strcmp (fname, vcg_plugin_common.temp_file_name))
+    {
+      if ((bytes = dump_temp ()) > 0)
+        {
+          vcg_stats_written (stats, start, bytes);
+          return;
+        }
+      sink = SINK_VIEW;
+    }
+  else if (open_archive ())
+    sink = SINK_ARCHIVE;
+  else if (vcg_plugin_common.cache_dir != NULL)
+    sink = SINK_CACHE;
+  else
+    sink = SINK_FILE;
+
+  fname = vcg_dump_file_name (fname);
+  hash = gdl_hash_graph (vcg_plugin_common.top_graph);
+  if (vcg_dump_unchanged_p (fname, hash, sink))
+    {
+      vcg_stats_written (stats, start, 0);
+      free (fname);
       return;
     }
 
-  /* Put the version information on top.  */
-  fprintf (fp, "// Generated by GCC VCG Plugin %s\n" \
-               "// Report bugs to <mingjie.xing@gmail.com>\n" \
-               "// Home page: http://code.google.com/p/gcc-vcg-plugin\n" \
-               "// %s", vcg_plugin_common.version, vcg_plugin_common.info);
+  if (vcg_plugin_common.async_queue_size > 0
+      && vcg_dump_async (fname, hash, sink, stats))
+    {
+      vcg_stats_written (stats, start, 0);
+      return;
+    }
+
+  bytes = write_graph_sink (fname, vcg_plugin_common.top_graph, hash, sink);
+  vcg_stats_written (stats, start, bytes);
+  free (fname);
+}
+
+/* Connect to the persistent viewer if not yet.  Return 0 on failure.  */
+
+static int
+connect_viewer (void)
+{
+  struct sockaddr_un addr;
+  const char *path = vcg_plugin_common.viewer_socket;
+
+  if (viewer_fd >= 0)
+    return 1;
+
+  if (strlen (path) >= sizeof (addr.sun_path))
+    {
+      vcg_plugin_common.error ("viewer socket name %s is too long.", path);
+      return 0;
+    }
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, path);
+
+  if ((viewer_fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+    return 0;
+  if (connect (viewer_fd, (struct sockaddr *) &addr, sizeof (addr)) < 0)
+    {
+      close (viewer_fd);
+      viewer_fd = -1;
+      return 0;
+    }
+  return 1;
+}
+
+/* Send LEN bytes of BUF to the persistent viewer.  Return 0 on
+   failure.  */
+
+static int
+send_viewer (const char *buf, size_t len)
+{
+  ssize_t n;
 
-  gdl_dump_graph (fp, vcg_plugin_common.top_graph);
+  while (len > 0)
+    {
+      n = send (viewer_fd, buf, len, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return 0;
+      buf += n;
+      len -= n;
+    }
+  return 1;
+}
+
+/* Push the file FNAME to the persistent viewer as a line "graph N"
+   followed by the N bytes of the file.  The connection is made again
+   once if the viewer has gone, e.g. restarted.  Return 0 on failure.  */
+
+static int
+push_viewer (char *fname)
+{
+  FILE *fp;
+  char *buf, header[32];
+  long len;
+  int i, ret = 0;
+
+  if ((fp = fopen (fname, "r")) == NULL)
+    return 0;
+  fseek (fp, 0, SEEK_END);
+  len = ftell (fp);
+  rewind (fp);
+  buf = XNEWVEC (char, len > 0 ? len : 1);
+  if (len < 0 || fread (buf, 1, len, fp) != (size_t) len)
+    {
+      fclose (fp);
+      free (buf);
+      return 0;
+    }
   fclose (fp);
+
+  sprintf (header, "graph %ld\n", len);
+  for (i = 0; i < 2 && !ret; i++)
+    {
+      if (!connect_viewer ())
+        break;
+      ret = send_viewer (header, strlen (header)) && send_viewer (buf, len);
+      if (!ret)
+        {
+          close (viewer_fd);
+          viewer_fd = -1;
+        }
+    }
+
+  free (buf);
+  return ret;
 }
 
-/* Show the top graph.  */
+/* Show the top graph.  With a viewer socket, the graph goes to the
+   persistent viewer, and the vcg viewer is only started if it cannot be
+   reached.  */
 
 static void
 vcg_show (char *fname)
@@ -65,6 +1143,25 @@ vcg_show (char *fname)
   char *cmd;
   pid_t pid;
 
+  /* The viewer needs the file written.  */
+  vcg_flush ();
+
+  if (temp_fd >= 0 && !strcmp (fname, vcg_plugin_common.temp_file_name))
+    {
+      fname = XNEWVEC (char, 32);
+      sprintf (fname, "/proc/self/fd/%d", temp_fd);
+    }
+  else
+    fname = vcg_dump_file_name (fname);
+
+  if (vcg_plugin_common.viewer_socket != NULL)
+    {
+      if (push_viewer (fname))
+        goto done;
+      vcg_plugin_common.error ("failed to reach the viewer at %s.",
+                               vcg_plugin_common.viewer_socket);
+    }
+
   cmd = concat (vcg_plugin_common.vcg_viewer, " ", fname, NULL);
   pid = fork ();
   if (pid == 0)
@@ -73,6 +1170,47 @@ vcg_show (char *fname)
       exit (0);
     }
   free (cmd);
+
+ done:
+  /* The viewer has its own copy of the memory file.  */
+  if (temp_fd >= 0)
+    {
+      close (temp_fd);
+      temp_fd = -1;
+    }
+  free (fname);
+}
+
+/* Create the attribute presets shared by the dumpers.  They live as long
+   as the plugin.  */
+
+static void
+create_styles (void)
+{
+  gdl_style *style;
+
+  /* A folded subgraph, e.g. a basic block or a pass list.  */
+  style = gdl_new_style ("folded");
+  gdl_set_style_folding (style, 1);
+  gdl_set_style_shape (style, GDL_ELLIPSE);
+  vcg_plugin_common.folded_style = style;
+
+  /* An unfolded and highlighted object, e.g. the current pass.  */
+  style = gdl_new_style ("focused");
+  gdl_set_style_color (style, GDL_COLOR_RED);
+  gdl_set_style_folding (style, 0);
+  gdl_set_style_shape (style, GDL_ELLIPSE);
+  vcg_plugin_common.focused_style = style;
+
+  /* A node for something which is not active, e.g. a disabled pass.  */
+  style = gdl_new_style ("disabled");
+  gdl_set_style_color (style, GDL_COLOR_LIGHTGREY);
+  vcg_plugin_common.disabled_style = style;
+
+  /* An edge for a weak reference.  */
+  style = gdl_new_style ("dashed");
+  gdl_set_style_linestyle (style, GDL_DASHED);
+  vcg_plugin_common.dashed_style = style;
 }
 
 /* Do the common initialization work for each view/dump command.  */
@@ -82,24 +1220,42 @@ vcg_init (void)
 {
   gdl_graph *graph;
 
-  /* Create the top graph.  */
-  graph = gdl_new_graph ("top graph");
+  vcg_stats_start ();
+
+  if (vcg_plugin_common.folded_style == NULL)
+    create_styles ();
+
+  /* Reuse the top graph of the last command unless the writer thread
+     has taken it.  */
+  graph = vcg_plugin_common.top_graph;
+  if (graph == NULL)
+    graph = gdl_new_graph ("top graph");
   gdl_set_graph_node_borderwidth (graph, 1);
   gdl_set_graph_edge_thickness (graph, 1);
   gdl_set_graph_splines (graph, "yes");
   gdl_set_graph_node_alignment (graph, "top");
   gdl_set_graph_colorentry (graph, 100, 70, 130, 180);
-  gdl_set_graph_node_textcolor (graph, "white");
-  gdl_set_graph_node_color (graph, "100");
-  gdl_set_graph_edge_color (graph, "100");
+  gdl_set_graph_node_textcolor (graph, GDL_COLOR_WHITE);
+  gdl_set_graph_node_color (graph, 100);
+  gdl_set_graph_edge_color (graph, 100);
+  if (vcg_plugin_common.max_nodes || vcg_plugin_common.max_edges
+      || vcg_plugin_common.max_label_bytes)
+    gdl_set_graph_budget (graph, vcg_plugin_common.max_nodes,
+                          vcg_plugin_common.max_edges,
+                          vcg_plugin_common.max_label_bytes);
   vcg_plugin_common.top_graph = graph;
 
   /* Initialize the string obstack.  */
-  obstack_init (&str_obstack);
+  if (str_obstack_mark == NULL)
+    {
+      obstack_init (&str_obstack);
+      str_obstack_mark = (char *) obstack_alloc (&str_obstack, 0);
+    }
 
   /* Open the temp stream.  */
-  vcg_plugin_common.stream = open_memstream (&vcg_plugin_common.stream_buf,
-                                             &vcg_plugin_common.stream_buf_size);
+  if (vcg_plugin_common.stream == NULL)
+    vcg_plugin_common.stream = open_memstream (&vcg_plugin_common.stream_buf,
+                                               &vcg_plugin_common.stream_buf_size);
 }
 
 /* Do the common cleanup work for each view/dump command.  */
@@ -107,10 +1263,30 @@ vcg_init (void)
 static void
 vcg_finish (void)
 {
-  gdl_free_graph (vcg_plugin_common.top_graph);
-  obstack_free (&str_obstack, NULL);
-  fclose (vcg_plugin_common.stream);
-  free (vcg_plugin_common.stream_buf);
+  /* Empty the top graph for the next command.  */
+  if (top_graph_handed_p)
+    vcg_plugin_common.top_graph = NULL;
+  else
+    gdl_clear_graph (vcg_plugin_common.top_graph);
+  top_graph_handed_p = 0;
+
+  vcg_stats_finish (obstack_memory_used (&str_obstack));
+  obstack_free (&str_obstack, str_obstack_mark);
+
+  /* Truncate the temp stream.  */
+  fflush (vcg_plugin_common.stream);
+  if (vcg_plugin_common.stream_buf_size > STREAM_KEEP_SIZE)
+    {
+      fclose (vcg_plugin_common.stream);
+      free (vcg_plugin_common.stream_buf);
+      vcg_plugin_common.stream = NULL;
+      vcg_plugin_common.stream_buf = NULL;
+    }
+  else
+    {
+      rewind (vcg_plugin_common.stream);
+      fflush (vcg_plugin_common.stream);
+    }
 }
 
 /* Print into the string buffer.  */
@@ -146,8 +1322,38 @@ vcg_plugin_common_t vcg_plugin_common =
   NULL,
   /* The name of the vcg viewer tool.  */
   "vcgview",
+  /* The socket of the persistent viewer.  */
+  NULL,
+  /* The output directory, NULL for the current one.  */
+  NULL,
+  /* The archive of the dumped files, NULL for none.  */
+  NULL,
+  /* No stats, reported to stderr.  */
+  0,
+  NULL,
+  /* Dump every function.  */
+  0,
+  /* No dump cache.  */
+  NULL,
+  /* The format of the dumped files.  */
+  VCG_FORMAT_VCG,
+  /* The node count above which svg files are laid out coarsely.  */
+  2000,
+  /* The budget of the top graph.  */
+  0,
+  0,
+  0,
+  /* The queue size of the writer thread, 0 for no async mode.  */
+  0,
+  /* The number of the dumping children, 0 for no fork-dump mode.  */
+  0,
   /* The top graph.  */
   NULL,
+  /* Shared attribute presets.  */
+  NULL,
+  NULL,
+  NULL,
+  NULL,
   /* Temp file name to dump/view a graph.  */
   "dump-temp.vcg",
   /* Temp stream to get gcc dump.  */
@@ -159,6 +1365,7 @@ vcg_plugin_common_t vcg_plugin_common =
   vcg_error,
   vcg_dump,
   vcg_show,
+  vcg_file_name,
   vcg_buf_print,
   vcg_buf_finish
 };
@@ -57,6 +57,21 @@
 /* libgdl */
 #include "gdl.h"
 
+/* The formats of the dumped files.  */
+
+typedef enum
+{
+  VCG_FORMAT_VCG,
+  VCG_FORMAT_DOT,
+  VCG_FORMAT_JSONL,
+  VCG_FORMAT_SVG,
+  VCG_FORMAT_MAX
+} vcg_format_t;
+
+/* The cost of the dumps of one kind for one function, see vcg-stats.c.  */
+
+typedef struct vcg_stats_entry vcg_stats_entry;
+
 /* The common data and functions for each dump/view command.  */
 
 typedef struct
@@ -76,10 +91,63 @@ typedef struct
   /* The name of the vcg viewer tool.  */
   char *vcg_viewer;
 
+  /* The UNIX socket of a persistent viewer to push the viewed graphs
+     into, or NULL to start the vcg viewer for each.  */
+  char *viewer_socket;
+
+  /* The directory to write the files into, spread over hashed
+     subdirectories and named uniquely, or NULL to write them into the
+     current directory under their plain names.  */
+  char *outdir;
+
+  /* The tar archive to append the dumped files to, or NULL to write
+     them as files.  */
+  char *archive;
+
+  /* Measure the cost of the dumps, and report it when gcc finishes into
+     the JSON file STATS_FILE, or to stderr if it is NULL.  */
+  int stats;
+  char *stats_file;
+
+  /* Only dump one in about SAMPLE functions, see
+     vcg_function_selected_p, 0 or 1 for all of them.  */
+  int sample;
+
+  /* The directory of the dumped files by their content, which the files
+     dumped again are hard links to, or NULL.  */
+  char *cache_dir;
+
+  /* The format of the dumped files.  */
+  vcg_format_t format;
+
+  /* The number of nodes above which the svg files get the coarse
+     layout.  */
+  int svg_max_nodes;
+
+  /* The budget of the top graph, 0 for no limit.  */
+  int max_nodes;
+  int max_edges;
+  long max_label_bytes;
+
+  /* The number of the graphs which may wait for the writer thread, 0 to
+     write them before the dump returns.  */
+  int async_queue_size;
+
+  /* The number of the child processes which may be dumping at once, 0
+     to dump in the compiler itself.  */
+  int fork_max;
+
   /* The top graph.  */
   gdl_graph *top_graph;
 
-  /* Temp file name to dump/view a graph.  */
+  /* Shared attribute presets.  */
+  gdl_style *folded_style;
+  gdl_style *focused_style;
+  gdl_style *disabled_style;
+  gdl_style *dashed_style;
+
+  /* Temp file name to dump/view a graph.  It is only written where the
+     graph to view cannot go to a memory file.  */
   char *temp_file_name;
 
   /* Temp stream to get gcc dump.  */
@@ -92,12 +160,27 @@ typedef struct
   void (*error) (const char *format, ...);
   void (*dump) (char *fname);
   void (*show) (char *fname);
+  char *(*file_name) (char *fname, const char *ext, int object_p);
   void (*buf_print) (char *fmt, ...);
   char *(*buf_finish) (void);
 } vcg_plugin_common_t;
 
 extern vcg_plugin_common_t vcg_plugin_common; 
 
+/* These pick the functions to dump.  */
+
+extern int vcg_set_filter (char *pattern);
+extern int vcg_function_selected_p (const char *name);
+
+/* These measure the cost of the dumps, see vcg-stats.c.  */
+
+extern double vcg_stats_time (void);
+extern void vcg_stats_start (void);
+extern vcg_stats_entry *vcg_stats_dump (char *fname, gdl_graph *graph);
+extern void vcg_stats_written (vcg_stats_entry *entry, double start,
+                               long bytes);
+extern void vcg_stats_finish (size_t obstack_size);
+
 /* These are available functins, which can be used to
    dump and view gcc internal data structures. */
 
@@ -144,6 +227,15 @@ extern void *vcg_plugin_callback_cgraph (void *, void *);
 extern void *vcg_plugin_callback_callee (void *, void *);
 extern void *vcg_plugin_callback_caller (void *, void *);
 
+extern void *vcg_plugin_callback_archive_finish (void *, void *);
+extern void *vcg_plugin_callback_async_finish (void *, void *);
+extern void *vcg_plugin_callback_stats_finish (void *, void *);
+extern void *vcg_plugin_callback_fork (void *, void *);
+extern void *vcg_plugin_callback_fork_finish (void *, void *);
+
+extern void *vcg_plugin_callback_function_delta (void *, void *);
+extern void *vcg_plugin_callback_function_delta_finish (void *, void *);
+
 extern void *vcg_plugin_callback_passes_start (void *, void *);
 extern void *vcg_plugin_callback_pass (void *, void *);
 extern void *vcg_plugin_callback_passes_finish (void *, void *);
@@ -0,0 +1,392 @@
+/* The cost of the dumps, reported when gcc finishes.
+
+   Copyright (C) 2009, 2010, 2011 Mingjie Xing, mingjie.xing@gmail.com.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include "vcg-plugin.h"
+
+#include <pthread.h>
+#include <time.h>
+
+/* The cost of the dumps of one kind for one function.  */
+
+struct vcg_stats_entry
+{
+  /* The kind of the dump, e.g. "dump-function" or "cgraph", and the
+     function being compiled, or NULL.  */
+  char *kind;
+  char *function;
+
+  int count;
+  double build_time;
+  double write_time;
+  long nodes;
+  long edges;
+  long bytes;
+  size_t obstack_peak;
+};
+
+/* The entries by kind and function.  */
+static htab_t stats_entries;
+
+/* The start of the current command, and the entry of its dump.  */
+static double command_start;
+static vcg_stats_entry *command_entry;
+
+/* The writer thread adds to the entries as well.  */
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static hashval_t
+stats_entry_hash (const void *p)
+{
+  const vcg_stats_entry *entry = (const vcg_stats_entry *) p;
+
+  return htab_hash_string (entry->kind)
+         ^ (entry->function ? htab_hash_string (entry->function) : 0);
+}
+
+static int
+stats_entry_eq (const void *p1, const void *p2)
+{
+  const vcg_stats_entry *entry1 = (const vcg_stats_entry *) p1;
+  const vcg_stats_entry *entry2 = (const vcg_stats_entry *) p2;
+
+  if (strcmp (entry1->kind, entry2->kind) != 0)
+    return 0;
+  if (entry1->function == NULL || entry2->function == NULL)
+    return entry1->function == entry2->function;
+  return strcmp (entry1->function, entry2->function) == 0;
+}
+
+static void
+stats_entry_del (void *p)
+{
+  vcg_stats_entry *entry = (vcg_stats_entry *) p;
+
+  free (entry->kind);
+  free (entry->function);
+  free (entry);
+}
+
+/* Return the time in seconds, from an arbitrary start.  */
+
+double
+vcg_stats_time (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Start timing a command, which builds the top graph.  */
+
+void
+vcg_stats_start (void)
+{
+  if (!vcg_plugin_common.stats)
+    return;
+
+  command_start = vcg_stats_time ();
+  command_entry = NULL;
+}
+
+/* Count the nodes and edges of GRAPH and its subgraphs into NODES and
+   EDGES.  */
+
+static void
+count_graph (gdl_graph *graph, long *nodes, long *edges)
+{
+  gdl_node *node;
+  gdl_edge *edge;
+  gdl_graph *subgraph;
+
+  for (node = gdl_get_graph_node (graph); node != NULL; node = node->next)
+    (*nodes)++;
+  for (edge = gdl_get_graph_edge (graph); edge != NULL; edge = edge->next)
+    (*edges)++;
+  for (subgraph = gdl_get_graph_subgraph (graph); subgraph != NULL;
+       subgraph = subgraph->next)
+    count_graph (subgraph, nodes, edges);
+}
+
+/* Return the kind of the dump into FNAME, the name of the file without
+   the directory, the unit and the extension.  The kind is allocated.  */
+
+static char *
+dump_kind (char *fname)
+{
+  const char *base = lbasename (fname);
+  const char *tu;
+  size_t len;
+
+  if (dump_base_name != NULL)
+    {
+      tu = lbasename (dump_base_name);
+      len = strlen (tu);
+      if (strncmp (base, tu, len) == 0 && base[len] == '.')
+        base += len + 1;
+    }
+
+  len = strlen (base);
+  if (len >= 4 && !strcmp (base + len - 4, ".vcg"))
+    len -= 4;
+  return xstrndup (base, len);
+}
+
+/* Record the dump of GRAPH into FNAME, which has taken the time since
+   the command started to build.  Return the entry to add the cost of
+   writing the graph to, see vcg_stats_written, or NULL if there are no
+   stats.  */
+
+vcg_stats_entry *
+vcg_stats_dump (char *fname, gdl_graph *graph)
+{
+  vcg_stats_entry key, *entry;
+  double build_time;
+  void **slot;
+
+  if (!vcg_plugin_common.stats)
+    return NULL;
+
+  build_time = vcg_stats_time () - command_start;
+
+  if (stats_entries == NULL)
+    stats_entries = htab_create (64, stats_entry_hash, stats_entry_eq,
+                                 stats_entry_del);
+
+  key.kind = dump_kind (fname);
+  key.function = cfun != NULL ? (char *) current_function_name () : NULL;
+
+  pthread_mutex_lock (&stats_lock);
+  slot = htab_find_slot (stats_entries, &key, INSERT);
+  entry = (vcg_stats_entry *) *slot;
+  if (entry == NULL)
+    {
+      entry = XCNEW (vcg_stats_entry);
+      entry->kind = key.kind;
+      entry->function = key.function ? xstrdup (key.function) : NULL;
+      *slot = entry;
+    }
+  else
+    free (key.kind);
+
+  entry->count++;
+  entry->build_time += build_time;
+  count_graph (graph, &entry->nodes, &entry->edges);
+  pthread_mutex_unlock (&stats_lock);
+
+  command_entry = entry;
+  return entry;
+}
+
+/* Add to ENTRY the writing of BYTES bytes, which started at the time
+   START.  It may be called by the writer thread.  */
+
+void
+vcg_stats_written (vcg_stats_entry *entry, double start, long bytes)
+{
+  double write_time;
+
+  if (entry == NULL)
+    return;
+
+  write_time = vcg_stats_time () - start;
+  pthread_mutex_lock (&stats_lock);
+  entry->write_time += write_time;
+  entry->bytes += bytes;
+  pthread_mutex_unlock (&stats_lock);
+}
+
+/* Finish timing a command, whose string obstack has grown to
+   OBSTACK_SIZE bytes.  */
+
+void
+vcg_stats_finish (size_t obstack_size)
+{
+  if (command_entry != NULL && command_entry->obstack_peak < obstack_size)
+    command_entry->obstack_peak = obstack_size;
+  command_entry = NULL;
+}
+
+/* Add the entry in SLOT to the array pointed to by DATA.  */
+
+static int
+collect_entry (void **slot, void *data)
+{
+  vcg_stats_entry ***p = (vcg_stats_entry ***) data;
+
+  *(*p)++ = (vcg_stats_entry *) *slot;
+  return 1;
+}
+
+/* Order the entries by the time taken, the most expensive first.  */
+
+static int
+entry_cmp (const void *p1, const void *p2)
+{
+  const vcg_stats_entry *entry1 = *(const vcg_stats_entry * const *) p1;
+  const vcg_stats_entry *entry2 = *(const vcg_stats_entry * const *) p2;
+  double time1 = entry1->build_time + entry1->write_time;
+  double time2 = entry2->build_time + entry2->write_time;
+
+  if (time1 != time2)
+    return time1 < time2 ? 1 : -1;
+  return strcmp (entry1->kind, entry2->kind);
+}
+
+/* Print the string S as a JSON string into FP, or null if S is NULL.  */
+
+static void
+print_json_string (FILE *fp, const char *s)
+{
+  if (s == NULL)
+    {
+      fputs ("null", fp);
+      return;
+    }
+
+  fputc ('"', fp);
+  for (; *s != '\0'; s++)
+    {
+      if (*s == '"' || *s == '\\')
+        fprintf (fp, "\\%c", *s);
+      else if ((unsigned char) *s < 0x20)
+        fprintf (fp, "\\u%04x", (unsigned char) *s);
+      else
+        fputc (*s, fp);
+    }
+  fputc ('"', fp);
+}
+
+/* Print the N ENTRIES into FP as a JSON object.  */
+
+static void
+print_stats_json (FILE *fp, vcg_stats_entry **entries, int n)
+{
+  vcg_stats_entry *entry;
+  int i;
+
+  fputs ("{\"unit\": ", fp);
+  print_json_string (fp, dump_base_name);
+  fputs (", \"dumps\": [", fp);
+  for (i = 0; i < n; i++)
+    {
+      entry = entries[i];
+      fputs (i == 0 ? "\n  {\"kind\": " : ",\n  {\"kind\": ", fp);
+      print_json_string (fp, entry->kind);
+      fputs (", \"function\": ", fp);
+      print_json_string (fp, entry->function);
+      fprintf (fp, ", \"count\": %d, \"build_ms\": %.3f, \"write_ms\": %.3f, "
+                   "\"nodes\": %ld, \"edges\": %ld, \"bytes\": %ld, "
+                   "\"obstack_peak\": %lu}",
+               entry->count, entry->build_time * 1e3, entry->write_time * 1e3,
+               entry->nodes, entry->edges, entry->bytes,
+               (unsigned long) entry->obstack_peak);
+    }
+  fputs ("\n]}\n", fp);
+}
+
+/* Print the N ENTRIES into FP as a table, with their totals on top.  */
+
+static void
+print_stats_table (FILE *fp, vcg_stats_entry **entries, int n)
+{
+  vcg_stats_entry *entry;
+  double build_time = 0, write_time = 0;
+  long bytes = 0;
+  int i, count = 0;
+
+  for (i = 0; i < n; i++)
+    {
+      count += entries[i]->count;
+      build_time += entries[i]->build_time;
+      write_time += entries[i]->write_time;
+      bytes += entries[i]->bytes;
+    }
+
+  fprintf (fp, "%s: %d dumps of %s, %.3f ms building, %.3f ms writing, "
+               "%ld bytes\n",
+           vcg_plugin_common.plugin_name, count,
+           dump_base_name ? dump_base_name : "-",
+           build_time * 1e3, write_time * 1e3, bytes);
+  fprintf (fp, "%-24s %-24s %6s %10s %10s %8s %8s %10s %8s\n",
+           "kind", "function", "dumps", "build ms", "write ms", "nodes",
+           "edges", "bytes", "obstack");
+  for (i = 0; i < n; i++)
+    {
+      entry = entries[i];
+      fprintf (fp, "%-24s %-24s %6d %10.3f %10.3f %8ld %8ld %10ld %8lu\n",
+               entry->kind, entry->function ? entry->function : "-",
+               entry->count, entry->build_time * 1e3,
+               entry->write_time * 1e3, entry->nodes, entry->edges,
+               entry->bytes, (unsigned long) entry->obstack_peak);
+    }
+}
+
+/* Plugin callback function for PLUGIN_FINISH event.  Report the cost of
+   the dumps, as a table to stderr, or as JSON into the stats file.  The
+   graphs still in the queue of the writer thread are written first.  */
+
+void *
+vcg_plugin_callback_stats_finish (void *gcc_data, void *user_data)
+{
+  vcg_stats_entry **entries, **p;
+  char *stem, *fname;
+  size_t len;
+  FILE *fp;
+  int n;
+
+  vcg_plugin_callback_async_finish (gcc_data, user_data);
+  if (!vcg_plugin_common.stats)
+    return NULL;
+  vcg_plugin_common.stats = 0;
+
+  n = stats_entries != NULL ? htab_elements (stats_entries) : 0;
+  entries = p = XNEWVEC (vcg_stats_entry *, n + 1);
+  if (stats_entries != NULL)
+    htab_traverse (stats_entries, collect_entry, &p);
+  qsort (entries, n, sizeof (vcg_stats_entry *), entry_cmp);
+
+  if (vcg_plugin_common.stats_file == NULL)
+    print_stats_table (stderr, entries, n);
+  else
+    {
+      len = strlen (vcg_plugin_common.stats_file);
+      if (len >= 5 && !strcmp (vcg_plugin_common.stats_file + len - 5,
+                               ".json"))
+        len -= 5;
+      /* Named "<dump_base_name>.<file>.json" for each unit.  */
+      fname = xstrndup (vcg_plugin_common.stats_file, len);
+      stem = concat (dump_base_name, ".", fname, NULL);
+      free (fname);
+      fname = vcg_plugin_common.file_name (stem, ".json", 0);
+      if ((fp = fopen (fname, "w")) == NULL)
+        vcg_plugin_common.error ("failed to open file %s.", fname);
+      else
+        {
+          print_stats_json (fp, entries, n);
+          fclose (fp);
+        }
+      free (stem);
+      free (fname);
+    }
+
+  free (entries);
+  if (stats_entries != NULL)
+    htab_delete (stats_entries);
+  stats_entries = NULL;
+  return NULL;
+}